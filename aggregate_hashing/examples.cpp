@@ -0,0 +1,935 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+//
+// The Point, Point2 and Point3 of the spaceship operator
+// examples, which get == but not a hash:
+//
+
+struct Point
+{
+   int
+      x,
+      y
+      ;
+   
+   auto operator <=> (Point const & other) const = default;
+}
+;
+
+struct Point2
+{
+   int
+      x,
+      y
+      ;
+   
+   bool operator== (Point2 const & other) const
+   {
+      return
+         (
+            ( this->x == other.x )
+            
+            and
+            
+            ( this->y == other.y )
+         )
+         ;
+   }
+}
+;
+
+struct Point3
+{
+   int
+      x,
+      y
+      ;
+   
+   bool operator== (Point3 const & other) const
+   {
+      return
+         (
+            ( this->x == other.x )
+            
+            and
+            
+            ( this->y == other.y )
+         )
+         ;
+   }
+   
+   bool operator== (Point2 const & other) const
+   {
+      return
+         (
+            ( this->x == other.x )
+            
+            and
+            
+            ( this->y == other.y )
+         )
+         ;
+   }
+}
+;
+
+//
+// Aggregates which are not a block of bytes: a string, and
+// padding after a char:
+//
+
+struct Person
+{
+   int
+      id;
+   
+   ::std::string
+      name;
+   
+   bool operator== (Person const & other) const = default;
+}
+;
+
+struct Sample
+{
+   char
+      channel;
+   
+   double
+      value;
+   
+   Point
+      where;
+   
+   bool operator== (Sample const & other) const = default;
+}
+;
+
+//
+// The number of fields of an aggregate, up to 6, found by
+// counting the initializers it accepts, as a structured
+// binding would declare them. field_initializer converts
+// to any type:
+//
+
+struct field_initializer final
+{
+   template <typename T>
+   operator T (void) const;
+}
+;
+
+template <typename T, ::std::size_t... Indices>
+constexpr bool
+is_initializable_from_fields(::std::index_sequence<Indices...>)
+{
+   return
+      requires
+      {
+         T { ( static_cast<void>( Indices ), field_initializer() )... };
+      }
+      ;
+}
+
+//
+// Through brace elision, an array field accepts one
+// initializer per element, but a structured binding names
+// it once. An empty pair of braces initializes a whole
+// field, so the count of initializers must match the
+// count of fields found with braces. Aggregates of more
+// than 6 fields accept 7 pairs of braces:
+//
+
+template <typename T>
+constexpr ::std::size_t
+braced_field_count(void)
+{
+   if constexpr( requires { T { { }, { }, { }, { }, { }, { }, { } }; } )
+   {
+      return
+         7u;
+   }
+   else if constexpr( requires { T { { }, { }, { }, { }, { }, { } }; } )
+   {
+      return
+         6u;
+   }
+   else if constexpr( requires { T { { }, { }, { }, { }, { } }; } )
+   {
+      return
+         5u;
+   }
+   else if constexpr( requires { T { { }, { }, { }, { } }; } )
+   {
+      return
+         4u;
+   }
+   else if constexpr( requires { T { { }, { }, { } }; } )
+   {
+      return
+         3u;
+   }
+   else if constexpr( requires { T { { }, { } }; } )
+   {
+      return
+         2u;
+   }
+   else if constexpr( requires { T { { } }; } )
+   {
+      return
+         1u;
+   }
+   else
+   {
+      return
+         0u;
+   }
+}
+
+//
+// Base classes come first in aggregate initialization, and
+// a structured binding cannot name the fields of both a
+// base and the derived class. An aggregate has a base if its
+// first element can be initialized from a type which
+// converts only to its bases:
+//
+
+template <typename T>
+struct base_initializer final
+{
+   template <typename Base>
+      requires
+         ( ::std::is_base_of_v<Base, T> and not ::std::is_same_v<Base, T> )
+   operator Base (void) const;
+}
+;
+
+template <typename T>
+concept has_base =
+   requires
+   {
+      T { base_initializer<T>() };
+   }
+   ;
+
+template <typename T>
+constexpr ::std::size_t
+field_count(void)
+{
+   ::std::size_t
+      count = 0u;
+   
+   [&]<::std::size_t... Counts> (::std::index_sequence<Counts...>)
+   {
+      ( ( is_initializable_from_fields<T>( ::std::make_index_sequence<Counts + 1u>() ) ? count = Counts + 1u : count ), ... );
+   }
+   ( ::std::make_index_sequence<6u>() )
+   ;
+   
+   if( count != braced_field_count<T>() or has_base<T> )
+   {
+      return
+         0u;
+   }
+   
+   return
+      count;
+}
+
+template <typename T>
+concept Aggregate =
+   ::std::is_aggregate_v<T>
+   
+   and
+   
+   not ::std::is_array_v<T>
+   
+   and
+   
+   ( field_count<T>() > 0u )
+   ;
+
+//
+// Calls function( field ) for every field of an aggregate:
+//
+
+template <Aggregate T, typename Function>
+void
+for_each_field(T const & value, Function && function)
+{
+   constexpr auto
+      count = field_count<T>();
+   
+   if constexpr( count == 1u )
+   {
+      auto const & [ a ] = value;
+      
+      function( a );
+   }
+   else if constexpr( count == 2u )
+   {
+      auto const & [ a, b ] = value;
+      
+      function( a ); function( b );
+   }
+   else if constexpr( count == 3u )
+   {
+      auto const & [ a, b, c ] = value;
+      
+      function( a ); function( b ); function( c );
+   }
+   else if constexpr( count == 4u )
+   {
+      auto const & [ a, b, c, d ] = value;
+      
+      function( a ); function( b ); function( c ); function( d );
+   }
+   else if constexpr( count == 5u )
+   {
+      auto const & [ a, b, c, d, e ] = value;
+      
+      function( a ); function( b ); function( c ); function( d ); function( e );
+   }
+   else
+   {
+      auto const & [ a, b, c, d, e, f ] = value;
+      
+      function( a ); function( b ); function( c ); function( d ); function( e ); function( f );
+   }
+}
+
+//
+// The state of a hash, mixed in the style of wyhash: the
+// 128-bit product of two 64-bit words, folded into 64 bits
+// with exclusive or, spreads every input bit over the whole
+// result in one multiplication.
+//
+
+class hash_state final
+{
+public:
+   explicit hash_state(::std::uint64_t seed = 0u) noexcept
+      : state_( seed ^ secret[0] )
+   {
+   }
+   
+   static ::std::uint64_t
+      mix(::std::uint64_t first, ::std::uint64_t second) noexcept
+   {
+#if defined(__SIZEOF_INT128__)
+      //
+      // __extension__ keeps -Wpedantic quiet about the
+      // non-standard 128-bit type:
+      //
+      
+      __extension__ typedef
+         unsigned __int128
+         uint128
+            ;
+      
+      auto const
+         product = static_cast<uint128>( first ) * second;
+      
+      return
+         static_cast<::std::uint64_t>( product ) ^ static_cast<::std::uint64_t>( product >> 64u );
+#else
+      //
+      // The same product from 32-bit halves:
+      //
+      
+      auto const
+         low = ( first & 0xffff'ffffu ) * ( second & 0xffff'ffffu ),
+         middle_1 = ( first >> 32u ) * ( second & 0xffff'ffffu ),
+         middle_2 = ( first & 0xffff'ffffu ) * ( second >> 32u ),
+         high = ( first >> 32u ) * ( second >> 32u ),
+         carry = ( ( low >> 32u ) + ( middle_1 & 0xffff'ffffu ) + ( middle_2 & 0xffff'ffffu ) ) >> 32u;
+      
+      return
+         ( low + ( middle_1 << 32u ) + ( middle_2 << 32u ) )
+         ^
+         ( high + ( middle_1 >> 32u ) + ( middle_2 >> 32u ) + carry );
+#endif
+   }
+   
+   void
+      append(::std::uint64_t word) noexcept
+   {
+      state_ = mix( state_ ^ word, secret[1] );
+   }
+   
+   //
+   // A block of bytes, 16 at a time, then the tail. The
+   // length is folded into the state first, so that blocks
+   // of different lengths differ:
+   //
+   
+   void
+      append_bytes(void const * data, ::std::size_t size) noexcept
+   {
+      auto
+         bytes = static_cast<unsigned char const *>( data );
+      
+      state_ ^= size;
+      
+      for( ; size >= 16u; size -= 16u, bytes += 16u )
+      {
+         state_ = mix( read( bytes ) ^ secret[1], read( bytes + 8u ) ^ state_ );
+      }
+      
+      if( size > 0u )
+      {
+         ::std::uint64_t
+            words[2] = { 0u, 0u };
+         
+         ::std::memcpy( words, bytes, size );
+         
+         state_ = mix( words[0] ^ secret[1], words[1] ^ state_ );
+      }
+   }
+   
+   ::std::uint64_t
+      finish(void) const noexcept
+   {
+      return
+         mix( state_ ^ secret[2], secret[3] );
+   }
+
+private:
+   static ::std::uint64_t
+      read(unsigned char const * bytes) noexcept
+   {
+      ::std::uint64_t
+         word;
+      
+      ::std::memcpy( &word, bytes, sizeof( word ) );
+      
+      return
+         word;
+   }
+   
+   static constexpr ::std::uint64_t
+      secret[4] =
+         {
+         0xa076'1d64'78bd'642fu,
+         0xe703'7ed1'a0b4'28dbu,
+         0x8ebc'6af0'9c88'c6e3u,
+         0x5899'65cc'7537'4cc3u
+         }
+         ;
+   
+   ::std::uint64_t
+      state_;
+}
+;
+
+//
+// Contiguous ranges of elements which are blocks of bytes,
+// such as strings:
+//
+
+template <typename T>
+concept ByteRange =
+   ::std::ranges::contiguous_range<T const>
+   
+   and
+   
+   ::std::ranges::sized_range<T const>
+   
+   and
+   
+   ::std::has_unique_object_representations_v< ::std::ranges::range_value_t<T const> >
+   ;
+
+//
+// Appends a value to a hash:
+//
+//    * Strings and other contiguous ranges of types with a
+//      unique object representation are one block; other
+//      ranges are hashed element by element, with their size.
+//      Ranges come first, as views such as
+//      ::std::string_view are trivially copyable but equal
+//      by their elements, not by their pointers.
+//    * Other types with a unique object representation, that
+//      is trivially copyable without padding (Point,
+//      integers, enumerations, pointers), are one block of
+//      bytes, hashed whole: equal values have equal bytes.
+//    * Floating-point numbers are hashed by value, as 0.
+//      and -0. are equal.
+//    * Other aggregates are hashed field by field, which
+//      skips their padding.
+//    * Any other type uses ::std::hash.
+//
+
+template <typename T>
+void
+hash_append(hash_state & state, T const & value)
+{
+   if constexpr( ByteRange<T> )
+   {
+      state.append_bytes( ::std::ranges::data( value ), ::std::ranges::size( value ) * sizeof( ::std::ranges::range_value_t<T const> ) );
+   }
+   else if constexpr( ::std::ranges::input_range<T const> )
+   {
+      ::std::size_t
+         size = 0u;
+      
+      for( auto const & element : value )
+      {
+         hash_append( state, element );
+         
+         ++size;
+      }
+      
+      state.append( size );
+   }
+   else if constexpr( ::std::has_unique_object_representations_v<T> )
+   {
+      state.append_bytes( &value, sizeof( T ) );
+   }
+   else if constexpr( ::std::floating_point<T> )
+   {
+      auto const
+         normalized = static_cast<double>( value == T( 0 ) ? T( 0 ) : value );
+      
+      state.append( ::std::bit_cast<::std::uint64_t>( normalized ) );
+   }
+   else if constexpr( Aggregate<T> )
+   {
+      for_each_field( value, [&] (auto const & field) { hash_append( state, field ); } );
+   }
+   else
+   {
+      state.append( ::std::hash<T>()( value ) );
+   }
+}
+
+//
+// A hash function object for aggregates and the types
+// above. It is transparent, so that tables of Point3 can be
+// searched with Point2, whose equal values hash alike:
+//
+
+struct aggregate_hash
+{
+   typedef
+      void
+      is_transparent
+         ;
+   
+   template <typename T>
+   ::std::size_t
+      operator() (T const & value) const noexcept
+   {
+      hash_state
+         state;
+      
+      hash_append( state, value );
+      
+      return
+         static_cast<::std::size_t>( state.finish() );
+   }
+}
+;
+
+//
+// The usual hand-written alternative, field by field with
+// ::std::hash, which is the identity for integers in
+// libstdc++:
+//
+
+inline void
+hash_combine(::std::size_t & seed, ::std::size_t hash) noexcept
+{
+   seed ^= hash + 0x9e37'79b9u + ( seed << 6u ) + ( seed >> 2u );
+}
+
+struct combined_hash
+{
+   ::std::size_t
+      operator() (Point const & point) const noexcept
+   {
+      ::std::size_t
+         seed = 0u;
+      
+      hash_combine( seed, ::std::hash<int>()( point.x ) );
+      hash_combine( seed, ::std::hash<int>()( point.y ) );
+      
+      return
+         seed;
+   }
+   
+   ::std::size_t
+      operator() (Person const & person) const noexcept
+   {
+      ::std::size_t
+         seed = 0u;
+      
+      hash_combine( seed, ::std::hash<int>()( person.id ) );
+      hash_combine( seed, ::std::hash<::std::string>()( person.name ) );
+      
+      return
+         seed;
+   }
+}
+;
+
+static_assert( field_count<Point>() == 2u and field_count<Person>() == 2u and field_count<Sample>() == 3u );
+
+static_assert( ::std::has_unique_object_representations_v<Point> and not ::std::has_unique_object_representations_v<Sample> );
+
+//
+// Brace elision gives an array field one initializer per
+// element, and structured bindings cannot name the fields
+// of a base class, so these are hashed with ::std::hash:
+//
+
+struct Interval
+{
+   double
+      bounds[2];
+   
+   bool operator== (Interval const & other) const = default;
+}
+;
+
+struct Tagged
+   : Point
+{
+   char
+      tag;
+   
+   bool operator== (Tagged const & other) const = default;
+}
+;
+
+template <>
+struct std::hash<Interval>
+{
+   ::std::size_t
+      operator() (Interval const & interval) const noexcept
+   {
+      ::std::size_t
+         seed = 0u;
+      
+      hash_combine( seed, ::std::hash<double>()( interval.bounds[0] ) );
+      hash_combine( seed, ::std::hash<double>()( interval.bounds[1] ) );
+      
+      return
+         seed;
+   }
+}
+;
+
+template <>
+struct std::hash<Tagged>
+{
+   ::std::size_t
+      operator() (Tagged const & tagged) const noexcept
+   {
+      ::std::size_t
+         seed = combined_hash()( static_cast<Point const &>( tagged ) );
+      
+      hash_combine( seed, ::std::hash<char>()( tagged.tag ) );
+      
+      return
+         seed;
+   }
+}
+;
+
+static_assert( field_count<Interval>() == 0u and field_count<Tagged>() == 0u and not Aggregate<Interval> );
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   aggregate_hash const
+      hash;
+   
+   assert( hash( Point { 1, 2 } ) == hash( Point3 { 1, 2 } ) and hash( Point { 1, 2 } ) != hash( Point { 2, 1 } ) );
+   
+   assert( hash( Person { 1, "Ada" } ) == hash( Person { 1, ::std::string( "Ada" ) } ) );
+   
+   //
+   // Views are hashed by their elements, not their pointers:
+   //
+   
+   char const
+      hello[] = "hello",
+      copy[] = "hello"
+         ;
+   
+   assert( hash( ::std::string_view( hello ) ) == hash( ::std::string_view( copy ) ) and hash( ::std::string_view( hello ) ) == hash( ::std::string( copy ) ) );
+   
+   ::std::unordered_set<::std::string_view, aggregate_hash>
+      words { ::std::string_view( hello ) };
+   
+   assert( words.contains( ::std::string_view( copy ) ) );
+   
+   struct Label
+   {
+      int
+         id;
+      
+      ::std::string_view
+         name;
+   }
+   ;
+   
+   assert( hash( Label { 1, hello } ) == hash( Label { 1, copy } ) );
+   
+   //
+   // An array field or a base class falls back to
+   // ::std::hash:
+   //
+   
+   assert( hash( Interval { { 0.5, 1. } } ) == hash( Interval { { 0.5, 1. } } ) and hash( Interval { { 0.5, 1. } } ) != hash( Interval { { 1., 0.5 } } ) );
+   
+   assert( hash( Tagged { { 1, 2 }, 'a' } ) == hash( Tagged { { 1, 2 }, 'a' } ) and hash( Tagged { { 1, 2 }, 'a' } ) != hash( Tagged { { 1, 2 }, 'b' } ) );
+   
+   //
+   // Padding is not hashed, and 0. equals -0.:
+   //
+   
+   Sample
+      first,
+      second;
+   
+   ::std::memset( &first, 0x00, sizeof( first ) );
+   ::std::memset( &second, 0xff, sizeof( second ) );
+   
+   first = { 'a', 0., { 1, 2 } };
+   second = { 'a', -0., { 1, 2 } };
+   
+   assert( first == second and hash( first ) == hash( second ) );
+   
+   ::std::unordered_set<Point3, aggregate_hash, ::std::equal_to<>>
+      points { { 1, 2 }, { 3, 4 } };
+   
+   assert( points.contains( Point2 { 3, 4 } ) and not points.contains( Point2 { 4, 3 } ) );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmarks. The number of keys can be passed as the
+   // first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 4'000'000u
+               ;
+   
+   //
+   // Points of a grid, a common case for identity hashes:
+   //
+   
+   auto const
+      side = static_cast<int>( ::std::sqrt( static_cast<double>( size ) ) ) + 1;
+   
+   ::std::vector<Point>
+      points;
+   
+   for( int x = 0; points.size() < size; ++x )
+   {
+      for( int y = 0; y < side and points.size() < size; ++y )
+      {
+         points.push_back( { x, y } );
+      }
+   }
+   
+   ::std::vector<Person>
+      people( size / 4u );
+   
+   for( ::std::size_t index = 0; index < people.size(); ++index )
+   {
+      people[index] = { static_cast<int>( index ), "person number " + ::std::to_string( index ) };
+   }
+   
+   auto const
+      throughput =
+         [&] (char const * name, auto hash)
+         {
+            ::std::size_t
+               sum = 0u;
+            
+            auto const
+               point_time =
+                  milliseconds
+                     (
+                     [&]
+                     {
+                        for( auto const & point : points )
+                        {
+                           sum += hash( point );
+                        }
+                     }
+                     )
+                     ;
+            
+            auto const
+               person_time =
+                  milliseconds
+                     (
+                     [&]
+                     {
+                        for( auto const & person : people )
+                        {
+                           sum += hash( person );
+                        }
+                     }
+                     )
+                     ;
+            
+            //
+            // Distinct Points with equal hashes collide in
+            // every table:
+            //
+            
+            ::std::vector<::std::size_t>
+               hashes;
+            
+            for( auto const & point : points )
+            {
+               hashes.push_back( hash( point ) );
+            }
+            
+            ::std::ranges::sort( hashes );
+            
+            auto const
+               distinct = hashes.size() - ::std::ranges::unique( hashes ).size();
+            
+            ::std::cout << name
+                        << ": "
+                        << static_cast<double>( points.size() ) / point_time / 1e3
+                        << " million Points per second, "
+                        << static_cast<double>( people.size() ) / person_time / 1e3
+                        << " million Persons per second, "
+                        << distinct
+                        << " distinct hashes of "
+                        << points.size()
+                        << " Points (checksum "
+                        << sum % 10u
+                        << ")"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   throughput( "hash_combine", combined_hash() );
+   
+   throughput( "aggregate_hash", aggregate_hash() );
+   
+   auto const
+      table =
+         [&] <typename Hash> (char const * name, Hash)
+         {
+            ::std::unordered_set<Point, Hash>
+               set;
+            
+            auto const
+               insert_time = milliseconds( [&] { set.insert( points.begin(), points.end() ); } );
+            
+            ::std::size_t
+               found = 0u;
+            
+            auto const
+               find_time =
+                  milliseconds
+                     (
+                     [&]
+                     {
+                        for( auto const & point : points )
+                        {
+                           found += set.count( Point { point.y, point.x } );
+                        }
+                     }
+                     )
+                     ;
+            
+            ::std::cout << name
+                        << ": unordered_set of "
+                        << set.size()
+                        << " Points, insert "
+                        << insert_time
+                        << " ms, "
+                        << found
+                        << " lookups found in "
+                        << find_time
+                        << " ms"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   table( "hash_combine", combined_hash() );
+   
+   table( "aggregate_hash", aggregate_hash() );
+   
+   }
+   
+   return 0;
+}
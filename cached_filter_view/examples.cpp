@@ -0,0 +1,704 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <forward_list>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// ::std::views::filter calls its predicate every time the
+// view is traversed, and every traversal branches on the
+// result, which is unpredictable at selectivities of a few
+// percent. When a filtered range is traversed repeatedly,
+// the predicate can be evaluated once:
+//
+//    1     the predicate is evaluated over the whole base
+//          range into a packed bitmap, 64 elements per
+//          word, without branches;
+//    2.    the bitmap is scanned a word at a time, with
+//          ::std::countr_zero finding the next set bit, into
+//          a vector of the positions of the matching
+//          elements;
+//    3     every traversal then visits exactly the matching
+//          elements, without calling the predicate.
+//
+// cached_filter_view is random-access when its base is, as
+// the n-th element is base[positions[n]]; over a forward
+// base, its iterator advances the base iterator by the
+// distance between consecutive positions.
+//
+// The positions are 32-bit, so the base range may have at
+// most 2^32 - 1 elements. They are shared between copies of
+// the view, so the view is cheap to copy, but changes to
+// the base range after the view is constructed are not
+// reflected in the selection.
+//
+
+template <::std::ranges::view V, typename Predicate>
+   requires
+      (
+      ::std::ranges::forward_range<V>
+      
+      and
+      
+      ::std::indirect_unary_predicate< Predicate const, ::std::ranges::iterator_t<V> >
+      )
+class cached_filter_view
+   : public ::std::ranges::view_interface< cached_filter_view<V, Predicate> >
+{
+public:
+   cached_filter_view(void) = default;
+   
+   cached_filter_view(V base, Predicate predicate)
+      : base_( ::std::move( base ) ),
+        positions_( ::std::make_shared< ::std::vector<::std::uint32_t> >() )
+   {
+      ::std::vector<::std::uint64_t>
+         bits;
+      
+      ::std::uint64_t
+         word = 0u;
+      
+      ::std::size_t
+         count = 0u;
+      
+      for( auto && element : base_ )
+      {
+         word |= ::std::uint64_t { ::std::invoke( predicate, element ) } << ( count % 64u );
+         
+         if( ++count % 64u == 0u )
+         {
+            bits.push_back( word );
+            
+            word = 0u;
+         }
+      }
+      
+      if( count % 64u != 0u )
+      {
+         bits.push_back( word );
+      }
+      
+      if( count > ::std::numeric_limits<::std::uint32_t>::max() )
+      {
+         throw
+            ::std::length_error( "cached_filter_view: the base range is too large" );
+      }
+      
+      positions_->reserve
+         (
+         ::std::transform_reduce
+            (
+            bits.begin(),
+            bits.end(),
+            ::std::size_t { 0 },
+            ::std::plus<> { },
+            [] (::std::uint64_t bits) { return static_cast<::std::size_t>( ::std::popcount( bits ) ); }
+            )
+         )
+         ;
+      
+      for( ::std::size_t index = 0; index < bits.size(); ++index )
+      {
+         for( auto bits_left = bits[index]; bits_left != 0u; bits_left &= bits_left - 1u )
+         {
+            positions_->push_back
+               (
+               static_cast<::std::uint32_t>( 64u * index + static_cast<unsigned>( ::std::countr_zero( bits_left ) ) )
+               )
+               ;
+         }
+      }
+      
+      selected_ = positions_->size();
+      
+      //
+      // Over a forward base, the iterator looks at the next
+      // position to advance; an extra position past the
+      // last one marks the end:
+      //
+      
+      if constexpr ( not ::std::ranges::random_access_range<V> )
+      {
+         positions_->push_back( ::std::numeric_limits<::std::uint32_t>::max() );
+      }
+   }
+   
+   template <bool Const>
+   class iterator
+   {
+      using
+         Base = ::std::conditional_t<Const, V const, V>;
+   
+   public:
+      using
+         value_type = ::std::ranges::range_value_t<Base>;
+      
+      using
+         difference_type = ::std::ptrdiff_t;
+      
+      using
+         iterator_concept =
+            ::std::conditional_t
+               <
+               ::std::ranges::random_access_range<Base>,
+               ::std::random_access_iterator_tag,
+               ::std::forward_iterator_tag
+               >
+               ;
+      
+      iterator(void) = default;
+      
+      //
+      // Over a random-access base, base is the beginning of
+      // the base range; otherwise it is the current element:
+      //
+      
+      iterator
+         (
+         ::std::ranges::iterator_t<Base> base,
+         ::std::uint32_t const * positions,
+         ::std::size_t index
+         )
+         : base_( ::std::move( base ) ), positions_( positions ), index_( index )
+      {
+      }
+      
+      decltype(auto)
+         operator* (void) const
+      {
+         if constexpr ( ::std::ranges::random_access_range<Base> )
+         {
+            return
+               base_[ positions_[index_] ];
+         }
+         else
+         {
+            return
+               *base_;
+         }
+      }
+      
+      iterator &
+         operator++ (void)
+      {
+         if constexpr ( not ::std::ranges::random_access_range<Base> )
+         {
+            //
+            // The end iterator has no base iterator to
+            // advance, so the last element does not advance
+            // it either:
+            //
+            
+            if( positions_[ index_ + 1u ] != ::std::numeric_limits<::std::uint32_t>::max() )
+            {
+               ::std::ranges::advance( base_, positions_[ index_ + 1u ] - positions_[index_] );
+            }
+         }
+         
+         ++index_;
+         
+         return
+            *this;
+      }
+      
+      iterator
+         operator++ (int)
+      {
+         auto
+            copy = *this;
+         
+         ++*this;
+         
+         return
+            copy;
+      }
+      
+      friend bool
+         operator== (iterator const & left, iterator const & right)
+      {
+         return
+            left.index_ == right.index_;
+      }
+      
+      //
+      // The random-access operations:
+      //
+      
+      iterator &
+         operator-- (void)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         --index_;
+         
+         return
+            *this;
+      }
+      
+      iterator
+         operator-- (int)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         auto
+            copy = *this;
+         
+         --index_;
+         
+         return
+            copy;
+      }
+      
+      iterator &
+         operator+= (difference_type offset)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         index_ = static_cast<::std::size_t>( static_cast<difference_type>( index_ ) + offset );
+         
+         return
+            *this;
+      }
+      
+      iterator &
+         operator-= (difference_type offset)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            *this += -offset;
+      }
+      
+      decltype(auto)
+         operator[] (difference_type offset) const
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            *( *this + offset );
+      }
+      
+      friend iterator
+         operator+ (iterator iterator, difference_type offset)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            iterator += offset;
+      }
+      
+      friend iterator
+         operator+ (difference_type offset, iterator iterator)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            iterator += offset;
+      }
+      
+      friend iterator
+         operator- (iterator iterator, difference_type offset)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            iterator -= offset;
+      }
+      
+      friend difference_type
+         operator- (iterator const & left, iterator const & right)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            static_cast<difference_type>( left.index_ ) - static_cast<difference_type>( right.index_ );
+      }
+      
+      friend ::std::strong_ordering
+         operator<=> (iterator const & left, iterator const & right)
+            requires ::std::ranges::random_access_range<Base>
+      {
+         return
+            left.index_ <=> right.index_;
+      }
+   
+   private:
+      ::std::ranges::iterator_t<Base>
+         base_ { };
+      
+      ::std::uint32_t const *
+         positions_ = nullptr;
+      
+      ::std::size_t
+         index_ = 0u;
+   }
+   ;
+   
+   iterator<false>
+      begin(void)
+   {
+      return
+         this->make_begin<false>( base_ );
+   }
+   
+   iterator<true>
+      begin(void) const
+         requires ::std::ranges::forward_range<V const>
+   {
+      return
+         this->make_begin<true>( base_ );
+   }
+   
+   iterator<false>
+      end(void)
+   {
+      return
+         { ::std::ranges::begin( base_ ), positions_->data(), selected_ };
+   }
+   
+   iterator<true>
+      end(void) const
+         requires ::std::ranges::forward_range<V const>
+   {
+      return
+         { ::std::ranges::begin( base_ ), positions_->data(), selected_ };
+   }
+   
+   ::std::size_t
+      size(void) const
+   {
+      return
+         selected_;
+   }
+   
+   V
+      base(void) const
+   {
+      return
+         base_;
+   }
+
+private:
+   template <bool Const, typename Base>
+   iterator<Const>
+      make_begin(Base & base) const
+   {
+      auto
+         first = ::std::ranges::begin( base );
+      
+      if constexpr ( not ::std::ranges::random_access_range<Base> )
+      {
+         if( selected_ > 0u )
+         {
+            ::std::ranges::advance( first, positions_->front() );
+         }
+      }
+      
+      return
+         { ::std::move( first ), positions_->data(), 0u };
+   }
+   
+   //
+   // The positions of an empty view, for one which is
+   // default-constructed. Over a forward base, they hold the
+   // extra position which marks the end:
+   //
+   
+   static ::std::shared_ptr< ::std::vector<::std::uint32_t> >
+      no_positions(void)
+   {
+      auto
+         positions = ::std::make_shared< ::std::vector<::std::uint32_t> >();
+      
+      if constexpr ( not ::std::ranges::random_access_range<V> )
+      {
+         positions->push_back( ::std::numeric_limits<::std::uint32_t>::max() );
+      }
+      
+      return
+         positions;
+   }
+   
+   V
+      base_ { };
+   
+   ::std::shared_ptr< ::std::vector<::std::uint32_t> >
+      positions_ = no_positions();
+   
+   ::std::size_t
+      selected_ = 0u;
+}
+;
+
+template <typename R, typename Predicate>
+cached_filter_view(R &&, Predicate) -> cached_filter_view< ::std::views::all_t<R>, Predicate >;
+
+namespace views
+{
+
+template <typename Predicate>
+struct cached_filter_closure
+{
+   Predicate
+      predicate_;
+   
+   template <::std::ranges::viewable_range R>
+   friend auto
+   operator| (R && range, cached_filter_closure const & self)
+   {
+      return
+         cached_filter_view( ::std::forward<R>( range ), self.predicate_ );
+   }
+}
+;
+
+struct cached_filter_fn
+{
+   template <::std::ranges::viewable_range R, typename Predicate>
+   auto
+   operator() (R && range, Predicate predicate) const
+   {
+      return
+         cached_filter_view( ::std::forward<R>( range ), ::std::move( predicate ) );
+   }
+   
+   template <typename Predicate>
+   auto
+   operator() (Predicate predicate) const
+   {
+      return
+         cached_filter_closure<Predicate> { ::std::move( predicate ) };
+   }
+}
+;
+
+inline constexpr cached_filter_fn
+   cached_filter;
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<int> const
+      items { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+   
+   auto const
+      is_even = [] (int item) { return item % 2 == 0; };
+   
+   auto
+      even = items | views::cached_filter( is_even );
+   
+   static_assert( ::std::ranges::random_access_range<decltype(even)> );
+   
+   for( int v : even )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   assert( even.size() == 5u and even[2] == 6 and even.back() == 10 );
+   
+   //
+   // Over a forward range:
+   //
+   
+   ::std::vector<int>
+      forward;
+   
+   static_assert
+      (
+      ::std::ranges::forward_range
+         <
+         decltype( ::std::forward_list { 1 } | views::cached_filter( is_even ) )
+         >
+      )
+      ;
+   
+   for( int v : ::std::forward_list { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 } | views::cached_filter( is_even ) )
+   {
+      forward.push_back( v );
+   }
+   
+   assert( ( forward == ::std::vector<int> { 2, 4, 6, 8, 10 } ) );
+   
+   //
+   // A default-constructed view is empty:
+   //
+   
+   decltype( ::std::vector<int> { } | views::cached_filter( is_even ) ) const
+      none;
+   
+   decltype( ::std::forward_list { 1 } | views::cached_filter( is_even ) )
+      no_forward;
+   
+   assert( none.empty() and none.size() == 0u and none.begin() == none.end() );
+   
+   assert( no_forward.begin() == no_forward.end() );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark traversing a filtered range repeatedly, at
+   // several selectivities. The number of elements and the
+   // number of traversals can be passed as the first and
+   // second command-line arguments:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 10'000'000u
+               ,
+      traversals =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 10u
+               ;
+   
+   ::std::mt19937
+      generator( 42u );
+   
+   ::std::uniform_int_distribution<int>
+      percent( 0, 99 );
+   
+   ::std::vector<int>
+      items( size );
+   
+   for( auto & item : items )
+   {
+      item = percent( generator );
+   }
+   
+   ::std::cout << traversals
+               << " traversals of "
+               << size
+               << " elements:"
+               << ::std::endl
+                  ;
+   
+   for( int selectivity : { 1, 2, 5, 10 } )
+   {
+      auto const
+         selected = [selectivity] (int item) { return item < selectivity; };
+      
+      long
+         filter_sum = 0,
+         cached_sum = 0;
+      
+      auto const
+         filter_time =
+            milliseconds
+               (
+               [&]
+               {
+                  auto
+                     filtered = items | ::std::views::filter( selected );
+                  
+                  for( ::std::size_t traversal = 0; traversal < traversals; ++traversal )
+                  {
+                     for( int item : filtered )
+                     {
+                        filter_sum += item;
+                     }
+                  }
+               }
+               )
+               ;
+      
+      auto const
+         cached_time =
+            milliseconds
+               (
+               [&]
+               {
+                  auto const
+                     filtered = items | views::cached_filter( selected );
+                  
+                  for( ::std::size_t traversal = 0; traversal < traversals; ++traversal )
+                  {
+                     for( int item : filtered )
+                     {
+                        cached_sum += item;
+                     }
+                  }
+               }
+               )
+               ;
+      
+      assert( filter_sum == cached_sum );
+      
+      ::std::cout << "   "
+                  << selectivity
+                  << "% selected: views::filter "
+                  << filter_time
+                  << " ms (sum "
+                  << filter_sum
+                  << "), views::cached_filter (including the bitmap) "
+                  << cached_time
+                  << " ms (sum "
+                  << cached_sum
+                  << ")"
+                  << ::std::endl
+                     ;
+   }
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,961 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <compare>
+#include <concepts>
+#include <iterator>
+#include <cctype>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// A ::std::vector< ::std::tuple<int, char> > stores its
+// elements side by side: every tuple occupies 8 bytes, 3 of
+// which are padding, and reading only the chars reads all of
+// them. ::std::views::elements<1> selects the chars, but the
+// loop over them still strides through the tuples.
+//
+// tuple_vector<int, char> stores one contiguous vector per
+// tuple element (a "column store"). Iterating over it yields
+// ::std::tuple<int &, char &> proxies rather than tuples, so
+// that assignments through them write to the columns. Unlike
+// with a vector of tuples, even a structured binding by
+// value, for( auto [ number, letter ] : items ), binds to
+// the stored elements and modifies the container: loops
+// ported from a vector of tuples which modify copies must
+// copy the elements explicitly. columns::elements<I> returns
+// a ::std::span of column I, which the compiler can
+// vectorize over without any stride.
+//
+// The iteration uses zip_view, a C++20 version of the C++23
+// ::std::views::zip: it walks several random-access ranges
+// in step and yields tuples of their references. enumerate
+// zips an index with a range.
+//
+
+//
+// The value type of a zip: a tuple of values which is
+// common-reference compatible with the tuples of references
+// the zip yields, as required by ::std::indirectly_readable.
+// (C++23 makes ::std::tuple itself compatible.)
+//
+
+template <typename ... Ts>
+struct zip_value
+   : public ::std::tuple<Ts...>
+{
+   using
+      ::std::tuple<Ts...>::tuple;
+   
+   template <typename ... Us>
+      requires ( sizeof...(Us) == sizeof...(Ts) )
+   zip_value(::std::tuple<Us...> const & other)
+      : ::std::tuple<Ts...>( other )
+   {
+   }
+   
+   //
+   // Before C++23, a tuple of references cannot be made from
+   // a non-const lvalue tuple of values:
+   //
+   
+   template <typename ... Us>
+      requires
+         (
+         sizeof...(Us) == sizeof...(Ts)
+         
+         and
+         
+         ( ( ::std::is_reference_v<Us> and ::std::convertible_to<Ts &, Us> ) and ... )
+         )
+   operator ::std::tuple<Us...> ()
+   {
+      return
+         ::std::apply( [] (Ts & ... element) { return ::std::tuple<Us...>( element... ); }, base() );
+   }
+   
+   template <typename ... Us>
+      requires
+         (
+         sizeof...(Us) == sizeof...(Ts)
+         
+         and
+         
+         ( ( ::std::is_reference_v<Us> and ::std::convertible_to<Ts const &, Us> ) and ... )
+         )
+   operator ::std::tuple<Us...> () const
+   {
+      return
+         ::std::apply( [] (Ts const & ... element) { return ::std::tuple<Us...>( element... ); }, base() );
+   }
+
+private:
+   ::std::tuple<Ts...> &
+      base(void)
+   {
+      return
+         *this;
+   }
+   
+   ::std::tuple<Ts...> const &
+      base(void) const
+   {
+      return
+         *this;
+   }
+}
+;
+
+template <typename ... Ts>
+struct std::tuple_size< zip_value<Ts...> >
+   : ::std::integral_constant< ::std::size_t, sizeof...(Ts) >
+{
+}
+;
+
+template <::std::size_t I, typename ... Ts>
+struct std::tuple_element< I, zip_value<Ts...> >
+   : ::std::tuple_element< I, ::std::tuple<Ts...> >
+{
+}
+;
+
+template
+   <
+   typename ... Ts,
+   typename ... Us,
+   template <typename> typename TQualifiers,
+   template <typename> typename UQualifiers
+   >
+   requires
+      (
+      sizeof...(Ts) == sizeof...(Us)
+      
+      and
+      
+      requires { typename ::std::tuple< ::std::common_reference_t< TQualifiers<Ts>, UQualifiers<Us> > ... >; }
+      )
+struct std::basic_common_reference< zip_value<Ts...>, ::std::tuple<Us...>, TQualifiers, UQualifiers >
+{
+   using
+      type = ::std::tuple< ::std::common_reference_t< TQualifiers<Ts>, UQualifiers<Us> > ... >;
+}
+;
+
+template
+   <
+   typename ... Us,
+   typename ... Ts,
+   template <typename> typename UQualifiers,
+   template <typename> typename TQualifiers
+   >
+   requires
+      (
+      sizeof...(Ts) == sizeof...(Us)
+      
+      and
+      
+      requires { typename ::std::tuple< ::std::common_reference_t< TQualifiers<Ts>, UQualifiers<Us> > ... >; }
+      )
+struct std::basic_common_reference< ::std::tuple<Us...>, zip_value<Ts...>, UQualifiers, TQualifiers >
+{
+   using
+      type = ::std::tuple< ::std::common_reference_t< TQualifiers<Ts>, UQualifiers<Us> > ... >;
+}
+;
+
+//
+// The iterator of a zip advances all of its iterators
+// together. It does not refer to the zip_view, so the
+// iterators of a temporary zip_view remain valid as long as
+// the zipped ranges do:
+//
+
+template <::std::random_access_iterator ... Iterators>
+class zip_iterator
+{
+public:
+   using
+      value_type = zip_value< ::std::iter_value_t<Iterators> ... >;
+   
+   using
+      reference = ::std::tuple< ::std::iter_reference_t<Iterators> ... >;
+   
+   using
+      difference_type = ::std::ptrdiff_t;
+   
+   using
+      iterator_concept = ::std::random_access_iterator_tag;
+   
+   zip_iterator(void) = default;
+   
+   explicit zip_iterator(Iterators ... iterators)
+      : current_( ::std::move( iterators )... )
+   {
+   }
+   
+   reference
+      operator* (void) const
+   {
+      return
+         ::std::apply
+            (
+            [] (auto const & ... iterator)
+            {
+               return
+                  reference( *iterator ... );
+            }
+            ,
+            current_
+            )
+            ;
+   }
+   
+   reference
+      operator[] (difference_type offset) const
+   {
+      return
+         *( *this + offset );
+   }
+   
+   zip_iterator &
+      operator+= (difference_type offset)
+   {
+      ::std::apply
+         (
+         [offset] (auto & ... iterator)
+         {
+            ( ( iterator += static_cast< ::std::iter_difference_t<Iterators> >( offset ) ), ... );
+         }
+         ,
+         current_
+         )
+         ;
+      
+      return
+         *this;
+   }
+   
+   zip_iterator &
+      operator-= (difference_type offset)
+   {
+      return
+         *this += -offset;
+   }
+   
+   zip_iterator &
+      operator++ (void)
+   {
+      ::std::apply( [] (auto & ... iterator) { ( ++iterator, ... ); }, current_ );
+      
+      return
+         *this;
+   }
+   
+   zip_iterator
+      operator++ (int)
+   {
+      auto
+         copy = *this;
+      
+      ++*this;
+      
+      return
+         copy;
+   }
+   
+   zip_iterator &
+      operator-- (void)
+   {
+      ::std::apply( [] (auto & ... iterator) { ( --iterator, ... ); }, current_ );
+      
+      return
+         *this;
+   }
+   
+   zip_iterator
+      operator-- (int)
+   {
+      auto
+         copy = *this;
+      
+      --*this;
+      
+      return
+         copy;
+   }
+   
+   friend zip_iterator
+      operator+ (zip_iterator iterator, difference_type offset)
+   {
+      return
+         iterator += offset;
+   }
+   
+   friend zip_iterator
+      operator+ (difference_type offset, zip_iterator iterator)
+   {
+      return
+         iterator += offset;
+   }
+   
+   friend zip_iterator
+      operator- (zip_iterator iterator, difference_type offset)
+   {
+      return
+         iterator -= offset;
+   }
+   
+   //
+   // All the iterators move together, so the first one
+   // gives the position:
+   //
+   
+   friend difference_type
+      operator- (zip_iterator const & left, zip_iterator const & right)
+   {
+      return
+         static_cast<difference_type>( ::std::get<0>( left.current_ ) - ::std::get<0>( right.current_ ) );
+   }
+   
+   friend bool
+      operator== (zip_iterator const & left, zip_iterator const & right)
+   {
+      return
+         ::std::get<0>( left.current_ ) == ::std::get<0>( right.current_ );
+   }
+   
+   friend auto
+      operator<=> (zip_iterator const & left, zip_iterator const & right)
+   {
+      return
+         ::std::get<0>( left.current_ ) <=> ::std::get<0>( right.current_ );
+   }
+
+private:
+   ::std::tuple<Iterators...>
+      current_;
+}
+;
+
+template <::std::ranges::view ... Vs>
+   requires
+      (
+      sizeof...(Vs) > 0
+      
+      and
+      
+      ( ( ::std::ranges::random_access_range<Vs> and ::std::ranges::sized_range<Vs> ) and ... )
+      )
+class zip_view
+   : public ::std::ranges::view_interface< zip_view<Vs...> >
+{
+public:
+   zip_view(void) = default;
+   
+   explicit zip_view(Vs ... bases)
+      : bases_( ::std::move( bases )... )
+   {
+   }
+   
+   auto
+      begin(void)
+   {
+      return
+         ::std::apply
+            (
+            [] (auto & ... base)
+            {
+               return
+                  zip_iterator< ::std::ranges::iterator_t<Vs> ... > ( ::std::ranges::begin( base ) ... );
+            }
+            ,
+            bases_
+            )
+            ;
+   }
+   
+   auto
+      begin(void) const
+         requires ( ::std::ranges::random_access_range<Vs const> and ... )
+   {
+      return
+         ::std::apply
+            (
+            [] (auto const & ... base)
+            {
+               return
+                  zip_iterator< ::std::ranges::iterator_t<Vs const> ... > ( ::std::ranges::begin( base ) ... );
+            }
+            ,
+            bases_
+            )
+            ;
+   }
+   
+   //
+   // A zip is as long as its shortest range:
+   //
+   
+   auto
+      end(void)
+   {
+      return
+         this->begin() + static_cast<::std::ptrdiff_t>( this->size() );
+   }
+   
+   auto
+      end(void) const
+         requires ( ::std::ranges::random_access_range<Vs const> and ... )
+   {
+      return
+         this->begin() + static_cast<::std::ptrdiff_t>( this->size() );
+   }
+   
+   ::std::size_t
+      size(void) const
+         requires ( ::std::ranges::sized_range<Vs const> and ... )
+   {
+      return
+         ::std::apply
+            (
+            [] (auto const & ... base)
+            {
+               return
+                  ::std::min( { static_cast<::std::size_t>( ::std::ranges::size( base ) ) ... } );
+            }
+            ,
+            bases_
+            )
+            ;
+   }
+
+private:
+   ::std::tuple<Vs...>
+      bases_;
+}
+;
+
+template <typename ... Rs>
+zip_view(Rs && ...) -> zip_view< ::std::views::all_t<Rs> ... >;
+
+template <::std::ranges::viewable_range ... Rs>
+auto
+zip(Rs && ... ranges)
+{
+   return
+      zip_view( ::std::forward<Rs>( ranges )... );
+}
+
+template <::std::ranges::viewable_range R>
+   requires ( ::std::ranges::sized_range<R> )
+auto
+enumerate(R && range)
+{
+   auto const
+      size = static_cast<::std::size_t>( ::std::ranges::size( range ) );
+   
+   return
+      zip_view( ::std::views::iota( ::std::size_t { 0 }, size ), ::std::forward<R>( range ) );
+}
+
+template <typename ... Ts>
+   requires ( sizeof...(Ts) > 0 )
+class tuple_vector final
+{
+public:
+   using
+      value_type = zip_value<Ts...>;
+   
+   using
+      reference = ::std::tuple<Ts & ...>;
+   
+   using
+      const_reference = ::std::tuple<Ts const & ...>;
+   
+   ::std::size_t
+      size(void) const
+   {
+      return
+         ::std::get<0>( columns_ ).size();
+   }
+   
+   void
+      reserve(::std::size_t capacity)
+   {
+      ::std::apply( [capacity] (auto & ... column) { ( column.reserve( capacity ), ... ); }, columns_ );
+   }
+   
+   template <typename ... Args>
+      requires ( sizeof...(Args) == sizeof...(Ts) )
+   void
+      emplace_back(Args && ... args)
+   {
+      [&] <::std::size_t ... Index> (::std::index_sequence<Index...>)
+      {
+         ( ::std::get<Index>( columns_ ).emplace_back( ::std::forward<Args>( args ) ), ... );
+      }
+      ( ::std::index_sequence_for<Ts...> { } );
+   }
+   
+   void
+      push_back(::std::tuple<Ts...> const & tuple)
+   {
+      ::std::apply( [this] (auto const & ... element) { this->emplace_back( element... ); }, tuple );
+   }
+   
+   reference
+      operator[] (::std::size_t index)
+   {
+      return
+         ::std::apply( [index] (auto & ... column) { return reference( column[index] ... ); }, columns_ );
+   }
+   
+   const_reference
+      operator[] (::std::size_t index) const
+   {
+      return
+         ::std::apply( [index] (auto const & ... column) { return const_reference( column[index] ... ); }, columns_ );
+   }
+   
+   //
+   // Column I is contiguous, so it is exposed as a span:
+   //
+   
+   template <::std::size_t I>
+   ::std::span< ::std::tuple_element_t< I, ::std::tuple<Ts...> > >
+      column(void)
+   {
+      return
+         ::std::get<I>( columns_ );
+   }
+   
+   template <::std::size_t I>
+   ::std::span< ::std::tuple_element_t< I, ::std::tuple<Ts...> > const >
+      column(void) const
+   {
+      return
+         ::std::get<I>( columns_ );
+   }
+   
+   auto
+      begin(void)
+   {
+      return
+         [&] <::std::size_t ... Index> (::std::index_sequence<Index...>)
+         {
+            return
+               zip_iterator<Ts * ...>( ::std::get<Index>( columns_ ).data() ... );
+         }
+         ( ::std::index_sequence_for<Ts...> { } );
+   }
+   
+   auto
+      begin(void) const
+   {
+      return
+         [&] <::std::size_t ... Index> (::std::index_sequence<Index...>)
+         {
+            return
+               zip_iterator<Ts const * ...>( ::std::get<Index>( columns_ ).data() ... );
+         }
+         ( ::std::index_sequence_for<Ts...> { } );
+   }
+   
+   auto
+      end(void)
+   {
+      return
+         this->begin() + static_cast<::std::ptrdiff_t>( this->size() );
+   }
+   
+   auto
+      end(void) const
+   {
+      return
+         this->begin() + static_cast<::std::ptrdiff_t>( this->size() );
+   }
+
+private:
+   ::std::tuple< ::std::vector<Ts> ... >
+      columns_;
+}
+;
+
+//
+// columns::elements<I> selects element I of a range of
+// tuples: a span of the column for a tuple_vector, and
+// ::std::views::elements<I> for any other range:
+//
+
+namespace columns
+{
+
+template <typename T>
+inline constexpr bool
+   is_tuple_vector = false;
+
+template <typename ... Ts>
+inline constexpr bool
+   is_tuple_vector< tuple_vector<Ts...> > = true;
+
+template <::std::size_t I>
+struct elements_fn
+{
+   template <typename R>
+   auto
+   operator() (R && range) const
+   {
+      if constexpr ( is_tuple_vector< ::std::remove_cvref_t<R> > )
+      {
+         static_assert
+            (
+            ::std::is_lvalue_reference_v<R>,
+            "the span of a column must not outlive its tuple_vector"
+            )
+            ;
+         
+         return
+            range.template column<I>();
+      }
+      else
+      {
+         return
+            ::std::forward<R>( range ) | ::std::views::elements<I>;
+      }
+   }
+   
+   template <typename R>
+   friend auto
+   operator| (R && range, elements_fn const & self)
+   {
+      return
+         self( ::std::forward<R>( range ) );
+   }
+}
+;
+
+template <::std::size_t I>
+inline constexpr elements_fn<I>
+   elements;
+
+inline constexpr elements_fn<0>
+   keys;
+
+inline constexpr elements_fn<1>
+   values;
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   tuple_vector<int, char>
+      items;
+   
+   items.push_back( { 1, 'a' } );
+   
+   items.push_back( { 2, 'b' } );
+   
+   items.emplace_back( 3, 'c' );
+   
+   //
+   // The same loops as over a vector of tuples, except that
+   // the elements are proxies: the bindings of the second
+   // loop refer to the columns, and auto && says so:
+   //
+   
+   for( auto const & element : items | columns::elements<1> )
+   {
+      ::std::cout << element << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   for( auto && [ number, letter ] : items )
+   {
+      number *= 10;
+      
+      letter = static_cast<char>( ::std::toupper( letter ) );
+   }
+   
+   for( auto [ index, row ] : enumerate( items ) )
+   {
+      auto const &
+         [ number, letter ] = row;
+      
+      ::std::cout << index << ": " << number << " " << letter << ::std::endl;
+   }
+   
+   static_assert( ::std::ranges::random_access_range< tuple_vector<int, char> > );
+   
+   static_assert
+      (
+      ::std::is_same_v
+         <
+         decltype( items | columns::elements<1> ),
+         ::std::span<char>
+         >
+      )
+      ;
+   
+   assert( ::std::get<0>( items[2] ) == 30 and ::std::get<1>( items[2] ) == 'C' );
+   
+   //
+   // Zip two ranges; zips work with the range algorithms:
+   //
+   
+   ::std::vector<double> const
+      weights { 0.5, 0.25, 0.25 };
+   
+   auto const
+      weighted = zip( items.column<0>(), weights );
+   
+   auto const
+      heaviest =
+         ::std::ranges::max_element
+            (
+            weighted,
+            { },
+            [] (auto const & pair) { return ::std::get<0>( pair ) * ::std::get<1>( pair ); }
+            )
+            ;
+   
+   assert( ::std::get<0>( *heaviest ) == 30 );
+   
+   //
+   // Columns may share a type:
+   //
+   
+   tuple_vector<int, int>
+      ranges;
+   
+   ranges.emplace_back( 1, 5 );
+   ranges.emplace_back( 2, 3 );
+   
+   auto const
+      widest = ::std::ranges::max_element( ranges, { }, [] (auto const & range) { return ::std::get<1>( range ) - ::std::get<0>( range ); } );
+   
+   assert( widest == ranges.begin() and ::std::as_const( ranges ).begin() + 2 == ::std::as_const( ranges ).end() );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark reading the columns of a vector of tuples and
+   // of a tuple_vector. The number of rows can be passed as
+   // the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 20'000'000u
+               ;
+   
+   ::std::mt19937
+      generator( 42u );
+   
+   ::std::uniform_int_distribution<int>
+      numbers( 0, 1000 ),
+      letters( 'a', 'z' );
+   
+   ::std::vector< ::std::tuple<int, char> >
+      rows;
+   
+   tuple_vector<int, char>
+      column_store;
+   
+   rows.reserve( size );
+   
+   column_store.reserve( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      ::std::tuple<int, char> const
+         row { numbers( generator ), static_cast<char>( letters( generator ) ) };
+      
+      rows.push_back( row );
+      
+      column_store.push_back( row );
+   }
+   
+   namespace
+      views = ::std::views;
+   
+   auto const
+      report =
+         [] (char const * name, auto && rows_function, auto && columns_function)
+         {
+            decltype( rows_function() )
+               rows_result { },
+               columns_result { };
+            
+            auto const
+               rows_time = milliseconds( [&] { rows_result = rows_function(); } );
+            
+            auto const
+               columns_time = milliseconds( [&] { columns_result = columns_function(); } );
+            
+            assert( rows_result == columns_result );
+            
+            ::std::cout << "   "
+                        << name
+                        << ": vector<tuple> "
+                        << rows_time
+                        << " ms (result "
+                        << rows_result
+                        << "), tuple_vector "
+                        << columns_time
+                        << " ms (result "
+                        << columns_result
+                        << ")"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   ::std::cout << size << " rows:" << ::std::endl;
+   
+   report
+      (
+      "sum of the ints     ",
+      [&]
+      {
+         long
+            sum = 0;
+         
+         for( int number : rows | views::elements<0> )
+         {
+            sum += number;
+         }
+         
+         return
+            sum;
+      }
+      ,
+      [&]
+      {
+         long
+            sum = 0;
+         
+         for( int number : column_store | columns::elements<0> )
+         {
+            sum += number;
+         }
+         
+         return
+            sum;
+      }
+      )
+      ;
+   
+   report
+      (
+      "count of the 'a's   ",
+      [&]
+      {
+         return
+            ::std::ranges::count( rows | views::elements<1>, 'a' );
+      }
+      ,
+      [&]
+      {
+         return
+            ::std::ranges::count( column_store | columns::elements<1>, 'a' );
+      }
+      )
+      ;
+   
+   report
+      (
+      "sum of whole rows   ",
+      [&]
+      {
+         long
+            sum = 0;
+         
+         for( auto const & [ number, letter ] : rows )
+         {
+            sum += number * letter;
+         }
+         
+         return
+            sum;
+      }
+      ,
+      [&]
+      {
+         long
+            sum = 0;
+         
+         for( auto const & [ number, letter ] : column_store )
+         {
+            sum += number * letter;
+         }
+         
+         return
+            sum;
+      }
+      )
+      ;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,1106 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+//
+// The IsClock concept of the concepts examples:
+//
+
+template <typename T>
+concept IsClock = requires(T object, double parameter)
+{
+   object.start();
+   object.stop();
+   object.reset();
+   
+   ++object;
+   --object;
+   object += parameter;
+   
+   { object.time_now() } noexcept
+      ->
+         ::std::convertible_to
+            <
+            ::std::string
+            >
+            ;
+   
+   { T::resolution() }
+      ->
+         ::std::same_as
+            <
+            float
+            >
+            ;
+   
+   typename T::ClockResolutionType;
+   
+   requires
+      
+      ::std::default_initializable<T>
+      
+      and
+      
+      ::std::copy_constructible<T>
+         ;
+   
+   requires
+      (
+         sizeof( decltype( T::resolution() ) )
+         
+         <=
+         
+         sizeof( double )
+      )
+      ;
+}
+;
+
+//
+// The Clock hierarchy of the concepts examples, with the
+// member functions made virtual so that derived clocks can
+// override them. The clocks are simulated: ++, -- and +=
+// move the current time, so that the benchmarks measure
+// the calls rather than the reading of a hardware clock.
+//
+
+class Clock
+{
+public:
+   Clock(void) = default;
+   
+   Clock(Clock const &) = default;
+   
+   Clock(Clock &&) = default;
+   
+   Clock & operator= (Clock const &) = default;
+   
+   Clock & operator= (Clock &&) = default;
+   
+   virtual ~Clock(void) = default;
+   
+   typedef
+      float
+      ClockResolutionType
+         ;
+   
+   virtual void
+      start(void)
+   {
+      start_ = now_;
+   }
+   
+   virtual void
+      stop(void)
+   {
+      elapsed_ += now_ - start_;
+   }
+   
+   virtual void
+      reset(void)
+   {
+      elapsed_ = 0;
+   }
+   
+   virtual ::std::string
+      time_now(void) const noexcept
+   {
+      return
+         ::std::to_string( elapsed_ );
+   }
+   
+   virtual Clock &
+      operator++ (void)
+   {
+      ++now_;
+      
+      return
+         *this;
+   }
+   
+   virtual Clock &
+      operator-- (void)
+   {
+      --now_;
+      
+      return
+         *this;
+   }
+   
+   virtual Clock &
+      operator+= (double seconds)
+   {
+      now_ += static_cast<::std::int64_t>( seconds / resolution() );
+      
+      return
+         *this;
+   }
+   
+   static
+      ClockResolutionType
+      resolution(void) { return 1.; }
+         ;
+   
+   ::std::int64_t
+      elapsed(void) const noexcept
+   {
+      return
+         elapsed_;
+   }
+
+protected:
+   ::std::int64_t
+      now_ = 0,
+      start_ = 0,
+      elapsed_ = 0;
+}
+;
+
+//
+// A clock with a finer resolution, which hides the static
+// resolution() of Clock. Through a pointer to Clock, the
+// resolution of the base is used:
+//
+
+struct DerivedClock final : Clock
+{
+   virtual ~DerivedClock(void) = default
+      ;
+   
+   DerivedClock &
+      operator+= (double seconds) override
+   {
+      now_ += static_cast<::std::int64_t>( seconds / resolution() );
+      
+      return
+         *this;
+   }
+   
+   static
+      ClockResolutionType
+      resolution(void) { return 1e-9f; }
+         ;
+}
+;
+
+//
+// A clock which counts its laps in a T:
+//
+
+template
+   <
+   typename T
+   >
+struct AnotherDerivedClock final : Clock
+{
+   virtual ~AnotherDerivedClock(void) = default
+      ;
+   
+   void
+      stop(void) override
+   {
+      Clock::stop();
+      
+      ++laps_;
+   }
+   
+   void
+      reset(void) override
+   {
+      Clock::reset();
+      
+      laps_ = T();
+   }
+   
+   T
+      laps_ = T();
+}
+;
+
+//
+// A clock outside of the hierarchy, which keeps the
+// duration of its last 16 laps. Too large to be stored in
+// the small buffer of the holders below:
+//
+
+class lap_clock final
+{
+public:
+   typedef
+      float
+      ClockResolutionType
+         ;
+   
+   void
+      start(void)
+   {
+      start_ = now_;
+   }
+   
+   void
+      stop(void)
+   {
+      laps_[ count_++ % laps_.size() ] = now_ - start_;
+   }
+   
+   void
+      reset(void)
+   {
+      count_ = 0u;
+   }
+   
+   ::std::string
+      time_now(void) const noexcept
+   {
+      return
+         ::std::to_string( count_ == 0u ? 0 : laps_[ ( count_ - 1u ) % laps_.size() ] );
+   }
+   
+   lap_clock &
+      operator++ (void)
+   {
+      ++now_;
+      
+      return
+         *this;
+   }
+   
+   lap_clock &
+      operator-- (void)
+   {
+      --now_;
+      
+      return
+         *this;
+   }
+   
+   lap_clock &
+      operator+= (double seconds)
+   {
+      now_ += static_cast<::std::int64_t>( seconds / resolution() );
+      
+      return
+         *this;
+   }
+   
+   static
+      ClockResolutionType
+      resolution(void) { return 1e-6f; }
+         ;
+
+private:
+   ::std::array<::std::int64_t, 16>
+      laps_ { };
+   
+   ::std::int64_t
+      now_ = 0,
+      start_ = 0;
+   
+   ::std::size_t
+      count_ = 0u;
+}
+;
+
+static_assert( IsClock<Clock> and IsClock<DerivedClock> and IsClock< AnotherDerivedClock<int> > and IsClock<lap_clock> );
+
+//
+// poly<Interface> holds an object of any type which
+// satisfies the concept of an interface, without a common
+// base class:
+//
+//    * Objects which are small enough, and nothrow movable,
+//      are stored inline in a buffer of Size bytes, so that
+//      constructing, copying and moving a poly does not
+//      allocate. Larger objects are stored on the heap.
+//    * Every stored type, and storage, has one static
+//      constexpr table of function pointers (a "vtable"),
+//      and a poly holds a pointer to it. The objects do not
+//      need a vtable pointer of their own.
+//    * target<T>() returns a pointer to the object when it
+//      has exactly the type T, through which calls are
+//      direct and can be inlined.
+//
+// An interface describes a concept to poly:
+//
+//    * accepts<T>, whether a type satisfies the concept;
+//    * vtable, the table of function pointers, and
+//      make_vtable<T, Get>(), which fills a table for T,
+//      given a function which finds a T from the address of
+//      the storage;
+//    * members<Self>, a base class of poly which gives it
+//      the member functions of the concept, forwarding to
+//      the table.
+//
+
+template <typename Interface>
+struct poly_vtable final
+{
+   typename Interface::vtable
+      functions;
+   
+   void
+      (*copy)(void const * from, void * to);
+   
+   void
+      (*move)(void * from, void * to) noexcept;
+   
+   void
+      (*destroy)(void * storage) noexcept;
+}
+;
+
+template
+   <
+   typename Interface,
+   ::std::size_t Size = 6u * sizeof( void * ),
+   ::std::size_t Alignment = alignof( ::std::max_align_t )
+   >
+class poly final
+   : public Interface::template members< poly<Interface, Size, Alignment> >
+{
+   friend Interface::template members<poly>;
+   
+   //
+   // Objects stored on the heap are held by a pointer in the
+   // buffer:
+   //
+   
+   static_assert
+      (
+      Size >= sizeof( void * ) and Alignment >= alignof( void * ),
+      "the buffer must be able to hold a pointer"
+      )
+      ;
+   
+   template <typename T>
+   static constexpr bool
+      is_inline =
+         sizeof( T ) <= Size
+         and
+         Alignment % alignof( T ) == 0u
+         and
+         ::std::is_nothrow_move_constructible_v<T>
+            ;
+   
+   template <typename T>
+   static T &
+      inline_object(void * storage) noexcept
+   {
+      return
+         *::std::launder( static_cast<T *>( storage ) );
+   }
+   
+   template <typename T>
+   static T &
+      heap_object(void * storage) noexcept
+   {
+      return
+         **static_cast<T **>( storage );
+   }
+   
+   template <typename T>
+   static constexpr poly_vtable<Interface>
+      inline_vtable
+         {
+         Interface::template make_vtable< T, &inline_object<T> >(),
+         [] (void const * from, void * to)
+         {
+            ::new( to ) T( inline_object<T>( const_cast<void *>( from ) ) );
+         },
+         [] (void * from, void * to) noexcept
+         {
+            ::new( to ) T( ::std::move( inline_object<T>( from ) ) );
+            
+            inline_object<T>( from ).~T();
+         },
+         [] (void * storage) noexcept
+         {
+            inline_object<T>( storage ).~T();
+         }
+         }
+         ;
+   
+   template <typename T>
+   static constexpr poly_vtable<Interface>
+      heap_vtable
+         {
+         Interface::template make_vtable< T, &heap_object<T> >(),
+         [] (void const * from, void * to)
+         {
+            *static_cast<T **>( to ) = new T( heap_object<T>( const_cast<void *>( from ) ) );
+         },
+         [] (void * from, void * to) noexcept
+         {
+            *static_cast<T **>( to ) = ::std::exchange( *static_cast<T **>( from ), nullptr );
+         },
+         [] (void * storage) noexcept
+         {
+            delete *static_cast<T **>( storage );
+         }
+         }
+         ;
+
+public:
+   //
+   // An empty poly, on which only assignment, destruction
+   // and has_value() are valid:
+   //
+   
+   poly(void) noexcept = default;
+   
+   template <typename T>
+      requires
+         (
+         not ::std::same_as< ::std::remove_cvref_t<T>, poly >
+         and
+         Interface::template accepts< ::std::remove_cvref_t<T> >
+         )
+   poly(T && object)
+   {
+      using
+         type = ::std::remove_cvref_t<T>;
+      
+      if constexpr( is_inline<type> )
+      {
+         ::new( static_cast<void *>( storage_ ) ) type( ::std::forward<T>( object ) );
+         
+         vtable_ = &inline_vtable<type>;
+      }
+      else
+      {
+         *reinterpret_cast<type **>( storage_ ) = new type( ::std::forward<T>( object ) );
+         
+         vtable_ = &heap_vtable<type>;
+      }
+   }
+   
+   poly(poly const & other)
+      : vtable_( other.vtable_ )
+   {
+      if( vtable_ )
+      {
+         vtable_->copy( other.storage_, storage_ );
+      }
+   }
+   
+   poly(poly && other) noexcept
+      : vtable_( ::std::exchange( other.vtable_, nullptr ) )
+   {
+      if( vtable_ )
+      {
+         vtable_->move( other.storage_, storage_ );
+      }
+   }
+   
+   poly &
+      operator= (poly const & other)
+   {
+      if( this != &other )
+      {
+         *this = poly( other );
+      }
+      
+      return
+         *this;
+   }
+   
+   poly &
+      operator= (poly && other) noexcept
+   {
+      if( this != &other )
+      {
+         this->~poly();
+         
+         ::new( static_cast<void *>( this ) ) poly( ::std::move( other ) );
+      }
+      
+      return
+         *this;
+   }
+   
+   ~poly(void)
+   {
+      if( vtable_ )
+      {
+         vtable_->destroy( storage_ );
+      }
+   }
+   
+   bool
+      has_value(void) const noexcept
+   {
+      return
+         vtable_ != nullptr;
+   }
+   
+   //
+   // Whether a stored object of type T would be stored
+   // inline:
+   //
+   
+   template <typename T>
+   static constexpr bool
+      stores_inline(void) noexcept
+   {
+      return
+         is_inline<T>;
+   }
+   
+   template <typename T>
+   T *
+      target(void) noexcept
+   {
+      if( vtable_ == &inline_vtable<T> )
+      {
+         return
+            &inline_object<T>( storage_ );
+      }
+      
+      if( vtable_ == &heap_vtable<T> )
+      {
+         return
+            &heap_object<T>( storage_ );
+      }
+      
+      return
+         nullptr;
+   }
+
+private:
+   typename Interface::vtable const &
+      functions(void) const noexcept
+   {
+      return
+         vtable_->functions;
+   }
+   
+   void *
+      object(void) const noexcept
+   {
+      return
+         const_cast<::std::byte *>( storage_ );
+   }
+   
+   poly_vtable<Interface> const *
+      vtable_ = nullptr;
+   
+   alignas( Alignment ) ::std::byte
+      storage_[ Size ];
+}
+;
+
+//
+// The interface of IsClock. Each requirement of the concept
+// has an entry in the table and a member function; the
+// static resolution() of the stored type becomes a member
+// function, as it depends on the type of the object held:
+//
+
+struct clock_interface final
+{
+   template <typename T>
+   static constexpr bool
+      accepts = IsClock<T>;
+   
+   struct vtable final
+   {
+      void
+         (*start)(void *);
+      
+      void
+         (*stop)(void *);
+      
+      void
+         (*reset)(void *);
+      
+      void
+         (*increment)(void *);
+      
+      void
+         (*decrement)(void *);
+      
+      void
+         (*add)(void *, double);
+      
+      ::std::string
+         (*time_now)(void *) noexcept;
+      
+      float
+         (*resolution)(void);
+   }
+   ;
+   
+   template <typename T, T & (*Get)(void *) noexcept>
+   static constexpr vtable
+      make_vtable(void)
+   {
+      return
+         {
+         [] (void * self) { Get( self ).start(); },
+         [] (void * self) { Get( self ).stop(); },
+         [] (void * self) { Get( self ).reset(); },
+         [] (void * self) { ++Get( self ); },
+         [] (void * self) { --Get( self ); },
+         [] (void * self, double seconds) { Get( self ) += seconds; },
+         [] (void * self) noexcept -> ::std::string { return Get( self ).time_now(); },
+         [] (void) { return T::resolution(); }
+         }
+         ;
+   }
+   
+   template <typename Self>
+   class members
+   {
+   public:
+      typedef
+         float
+         ClockResolutionType
+            ;
+      
+      void
+         start(void)
+      {
+         self().functions().start( self().object() );
+      }
+      
+      void
+         stop(void)
+      {
+         self().functions().stop( self().object() );
+      }
+      
+      void
+         reset(void)
+      {
+         self().functions().reset( self().object() );
+      }
+      
+      Self &
+         operator++ (void)
+      {
+         self().functions().increment( self().object() );
+         
+         return
+            self();
+      }
+      
+      Self &
+         operator-- (void)
+      {
+         self().functions().decrement( self().object() );
+         
+         return
+            self();
+      }
+      
+      Self &
+         operator+= (double seconds)
+      {
+         self().functions().add( self().object(), seconds );
+         
+         return
+            self();
+      }
+      
+      ::std::string
+         time_now(void) const noexcept
+      {
+         return
+            self().functions().time_now( self().object() );
+      }
+      
+      float
+         resolution(void) const
+      {
+         return
+            self().functions().resolution();
+      }
+   
+   private:
+      Self &
+         self(void) noexcept
+      {
+         return
+            static_cast<Self &>( *this );
+      }
+      
+      Self const &
+         self(void) const noexcept
+      {
+         return
+            static_cast<Self const &>( *this );
+      }
+   }
+   ;
+}
+;
+
+using
+   any_clock = poly<clock_interface>;
+
+static_assert( any_clock::stores_inline<DerivedClock>() and any_clock::stores_inline< AnotherDerivedClock<int> >() );
+
+static_assert( not any_clock::stores_inline<lap_clock>() );
+
+//
+// Count the allocations made by the benchmarks:
+//
+
+namespace
+{
+
+::std::size_t
+   allocations = 0u;
+
+}
+
+void *
+operator new(::std::size_t size)
+{
+   ++allocations;
+   
+   if( auto pointer = ::std::malloc( size == 0u ? 1u : size ) )
+   {
+      return
+         pointer;
+   }
+   
+   throw
+      ::std::bad_alloc();
+}
+
+void
+operator delete(void * pointer) noexcept
+{
+   ::std::free( pointer );
+}
+
+void
+operator delete(void * pointer, ::std::size_t) noexcept
+{
+   ::std::free( pointer );
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+//
+// The calls made to every clock by the benchmarks:
+//
+
+template <typename Clock>
+void
+time_lap(Clock & clock)
+{
+   clock.start();
+   
+   ++clock;
+   
+   clock += 2.;
+   
+   clock.stop();
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   //
+   // Clocks of unrelated types in one container, by value:
+   //
+   
+   ::std::vector<any_clock>
+      clocks;
+   
+   clocks.emplace_back( DerivedClock() );
+   clocks.emplace_back( AnotherDerivedClock<int>() );
+   clocks.emplace_back( lap_clock() );
+   
+   for( auto & clock : clocks )
+   {
+      time_lap( clock );
+      
+      ::std::cout << "resolution "
+                  << clock.resolution()
+                  << ", time "
+                  << clock.time_now()
+                  << ::std::endl
+                     ;
+   }
+   
+   assert( clocks[1].target< AnotherDerivedClock<int> >()->laps_ == 1 );
+   
+   assert( clocks[0].target<lap_clock>() == nullptr );
+   
+   //
+   // Copies are deep:
+   //
+   
+   auto
+      copy = clocks;
+   
+   ++copy[0];
+   
+   copy[0].stop();
+   
+   assert( copy[0].time_now() != clocks[0].time_now() );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark calls through unique_ptr<Clock> and through
+   // poly. The number of clocks and of laps per clock can
+   // be passed as the first and second command-line
+   // arguments:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 1'000'000u
+               ;
+   
+   ::std::size_t const
+      laps =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 20u
+               ;
+   
+   double const
+      calls = 4. * static_cast<double>( size * laps );
+   
+   auto const
+      report =
+         [&] (char const * name, ::std::size_t allocated, double construction, double time)
+         {
+            ::std::cout << name
+                        << ": "
+                        << allocated
+                        << " allocations, constructed in "
+                        << construction
+                        << " ms, "
+                        << calls / time / 1e3
+                        << " million calls per second"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   ::std::int64_t
+      expected = 0;
+   
+   {
+   
+   ::std::vector< ::std::unique_ptr<Clock> >
+      clocks;
+   
+   auto const
+      before = allocations;
+   
+   auto const
+      construction =
+         milliseconds
+            (
+            [&]
+            {
+               clocks.reserve( size );
+               
+               for( ::std::size_t index = 0; index < size; ++index )
+               {
+                  if( index % 2u == 0u )
+                  {
+                     clocks.push_back( ::std::make_unique<DerivedClock>() );
+                  }
+                  else
+                  {
+                     clocks.push_back( ::std::make_unique< AnotherDerivedClock<int> >() );
+                  }
+               }
+            }
+            )
+            ;
+   
+   auto const
+      allocated = allocations - before;
+   
+   auto const
+      time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t lap = 0; lap < laps; ++lap )
+               {
+                  for( auto & clock : clocks )
+                  {
+                     time_lap( *clock );
+                  }
+               }
+            }
+            )
+            ;
+   
+   for( auto & clock : clocks )
+   {
+      expected += clock->elapsed();
+   }
+   
+   report( "unique_ptr<Clock>", allocated, construction, time );
+   
+   }
+   
+   {
+   
+   ::std::vector<any_clock>
+      clocks;
+   
+   auto const
+      before = allocations;
+   
+   auto const
+      construction =
+         milliseconds
+            (
+            [&]
+            {
+               clocks.reserve( size );
+               
+               for( ::std::size_t index = 0; index < size; ++index )
+               {
+                  if( index % 2u == 0u )
+                  {
+                     clocks.emplace_back( DerivedClock() );
+                  }
+                  else
+                  {
+                     clocks.emplace_back( AnotherDerivedClock<int>() );
+                  }
+               }
+            }
+            )
+            ;
+   
+   auto const
+      allocated = allocations - before;
+   
+   auto const
+      time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t lap = 0; lap < laps; ++lap )
+               {
+                  for( auto & clock : clocks )
+                  {
+                     time_lap( clock );
+                  }
+               }
+            }
+            )
+            ;
+   
+   ::std::int64_t
+      total = 0;
+   
+   for( auto & clock : clocks )
+   {
+      if( auto derived = clock.target<DerivedClock>() )
+      {
+         total += derived->elapsed();
+      }
+      else
+      {
+         total += clock.target< AnotherDerivedClock<int> >()->elapsed();
+      }
+   }
+   
+   assert( total == expected );
+   
+   report( "poly<clock_interface>", allocated, construction, time );
+   
+   //
+   // When the type is known, through target<T>(), the calls
+   // are direct:
+   //
+   
+   auto const
+      known =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t lap = 0; lap < laps; ++lap )
+               {
+                  for( ::std::size_t index = 0; index < size; index += 2u )
+                  {
+                     time_lap( *clocks[index].target<DerivedClock>() );
+                  }
+               }
+            }
+            )
+            ;
+   
+   ::std::cout << "poly, target<DerivedClock>(): "
+               << calls / 2. / known / 1e3
+               << " million calls per second"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   }
+   
+   return 0;
+}
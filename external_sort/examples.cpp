@@ -0,0 +1,1111 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <system_error>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// A range which does not fit in memory can still be sorted:
+// an external merge sort reads the range in "runs" which do
+// fit in a memory budget, sorts every run in memory and
+// spills it to a temporary file, then merges the sorted
+// runs with a K-way merge, reading every run through a
+// buffer. K is bounded, so that the number of open files
+// is too: the runs are merged in groups of K while they are
+// spilled, and the last K or fewer in a final merge.
+//
+// Records are written to the run files by a
+// record_serializer. Trivially copyable types are written
+// as their bytes, and a whole sorted run of them is written
+// with a single call; other types, such as a record with a
+// ::std::string member, specialize record_serializer.
+//
+// external_sort(range, output, memory_budget, comparison,
+// projection) writes the sorted elements of range to the
+// output iterator, and returns the output iterator. I/O
+// failures throw ::std::system_error.
+//
+
+//
+// A buffered writer to, and reader from, a temporary file:
+//
+
+using
+   file_pointer = ::std::unique_ptr< ::std::FILE, decltype( &::std::fclose ) >;
+
+[[noreturn]] void
+throw_io_error(char const * what)
+{
+   throw
+      ::std::system_error( errno, ::std::generic_category(), what );
+}
+
+class run_writer final
+{
+public:
+   run_writer(::std::FILE * file, ::std::size_t buffer_size)
+      : file_( file ), buffer_( buffer_size )
+   {
+   }
+   
+   void
+      write(void const * data, ::std::size_t size)
+   {
+      if( used_ + size > buffer_.size() )
+      {
+         this->flush();
+         
+         //
+         // Large writes, such as a whole run of trivially
+         // copyable records, bypass the buffer:
+         //
+         
+         if( size >= buffer_.size() )
+         {
+            if( ::std::fwrite( data, 1u, size, file_ ) != size )
+            {
+               throw_io_error( "external_sort: cannot write run" );
+            }
+            
+            return;
+         }
+      }
+      
+      ::std::memcpy( buffer_.data() + used_, data, size );
+      
+      used_ += size;
+   }
+   
+   void
+      flush(void)
+   {
+      if( used_ > 0u and ::std::fwrite( buffer_.data(), 1u, used_, file_ ) != used_ )
+      {
+         throw_io_error( "external_sort: cannot write run" );
+      }
+      
+      used_ = 0u;
+   }
+
+private:
+   ::std::FILE *
+      file_;
+   
+   ::std::vector<char>
+      buffer_;
+   
+   ::std::size_t
+      used_ = 0u;
+}
+;
+
+class run_reader final
+{
+public:
+   run_reader(::std::FILE * file, ::std::size_t buffer_size)
+      : file_( file ), buffer_( buffer_size )
+   {
+   }
+   
+   //
+   // Returns false at the end of the run:
+   //
+   
+   bool
+      read(void * data, ::std::size_t size)
+   {
+      auto
+         target = static_cast<char *>( data );
+      
+      while( size > 0u )
+      {
+         if( position_ == end_ and not this->fill() )
+         {
+            return
+               false;
+         }
+         
+         auto const
+            count = ::std::min( size, end_ - position_ );
+         
+         ::std::memcpy( target, buffer_.data() + position_, count );
+         
+         position_ += count;
+         
+         target += count;
+         
+         size -= count;
+      }
+      
+      return
+         true;
+   }
+
+private:
+   bool
+      fill(void)
+   {
+      end_ = ::std::fread( buffer_.data(), 1u, buffer_.size(), file_ );
+      
+      position_ = 0u;
+      
+      if( end_ == 0u and ::std::ferror( file_ ) )
+      {
+         throw_io_error( "external_sort: cannot read run" );
+      }
+      
+      return
+         end_ > 0u;
+   }
+   
+   ::std::FILE *
+      file_;
+   
+   ::std::vector<char>
+      buffer_;
+   
+   ::std::size_t
+      position_ = 0u,
+      end_ = 0u;
+}
+;
+
+//
+// record_serializer<T> writes and reads the records of a
+// run, and tells how many bytes a record occupies outside
+// of its sizeof, for the memory budget:
+//
+
+template <typename T>
+struct record_serializer;
+
+template <typename T>
+   requires ::std::is_trivially_copyable_v<T>
+struct record_serializer<T> final
+{
+   static void
+      write(run_writer & writer, T const & record)
+   {
+      writer.write( &record, sizeof( T ) );
+   }
+   
+   static bool
+      read(run_reader & reader, T & record)
+   {
+      return
+         reader.read( &record, sizeof( T ) );
+   }
+   
+   static ::std::size_t
+      extra_size(T const &)
+   {
+      return
+         0u;
+   }
+}
+;
+
+template <typename T>
+concept Serializable =
+   requires (run_writer & writer, run_reader & reader, T & record)
+   {
+      record_serializer<T>::write( writer, record );
+      { record_serializer<T>::read( reader, record ) } -> ::std::same_as<bool>;
+      { record_serializer<T>::extra_size( record ) } -> ::std::convertible_to<::std::size_t>;
+   }
+   ;
+
+//
+// Sorts a run with one thread per part of the run, then
+// merges the sorted parts. Both steps are stable, so that
+// the whole sort is:
+//
+
+template <typename T, typename Comparison, typename Projection>
+void
+parallel_sort(::std::vector<T> & items, Comparison comparison, Projection projection)
+{
+   auto const
+      threads = ::std::max( ::std::thread::hardware_concurrency(), 1u );
+   
+   if( threads == 1u or items.size() < 65'536u )
+   {
+      ::std::ranges::stable_sort( items, comparison, projection );
+      
+      return;
+   }
+   
+   ::std::vector<::std::size_t>
+      bounds( threads + 1u );
+   
+   for( unsigned part = 0; part <= threads; ++part )
+   {
+      bounds[part] = items.size() * part / threads;
+   }
+   
+   auto const
+      at =
+         [&] (::std::size_t index)
+         {
+            return
+               items.begin() + static_cast<::std::ptrdiff_t>( index );
+         }
+         ;
+   
+   {
+   
+   ::std::vector<::std::jthread>
+      workers;
+   
+   for( unsigned part = 0; part < threads; ++part )
+   {
+      workers.emplace_back
+         (
+         [&, part]
+         {
+            ::std::ranges::stable_sort( at( bounds[part] ), at( bounds[ part + 1u ] ), comparison, projection );
+         }
+         )
+         ;
+   }
+   
+   }
+   
+   //
+   // Merge adjacent sorted parts, in parallel, until one is
+   // left:
+   //
+   
+   for( ::std::size_t width = 1u; width < threads; width *= 2u )
+   {
+      ::std::vector<::std::jthread>
+         workers;
+      
+      for( ::std::size_t part = 0; part + width < threads; part += 2u * width )
+      {
+         workers.emplace_back
+            (
+            [&, part, width]
+            {
+               ::std::ranges::inplace_merge
+                  (
+                  at( bounds[part] ),
+                  at( bounds[ part + width ] ),
+                  at( bounds[ ::std::min <::std::size_t> ( part + 2u * width, threads ) ] ),
+                  comparison,
+                  projection
+                  )
+                  ;
+            }
+            )
+            ;
+      }
+   }
+}
+
+//
+// Creates an empty run file, and rewinds a run file once it
+// is written, for reading:
+//
+
+file_pointer
+make_run_file(void)
+{
+   file_pointer
+      file( ::std::tmpfile(), &::std::fclose );
+   
+   if( not file )
+   {
+      throw_io_error( "external_sort: cannot create a temporary file" );
+   }
+   
+   return
+      file;
+}
+
+void
+rewind_run(::std::FILE * file)
+{
+   if( ::std::fflush( file ) != 0 )
+   {
+      throw_io_error( "external_sort: cannot write run" );
+   }
+   
+   ::std::rewind( file );
+}
+
+//
+// Merges sorted runs, reading every run through a buffer of
+// buffer_size bytes, and passes the records in order to
+// sink. A heap of the runs has at its top the run with the
+// smallest head; ties go to the earlier run, so that equal
+// records keep their order:
+//
+
+template <typename T, typename Comparison, typename Projection, typename Sink>
+void
+merge_runs
+   (
+   ::std::vector<file_pointer> const & runs,
+   ::std::size_t buffer_size,
+   Comparison const & comparison,
+   Projection const & projection,
+   Sink && sink
+   )
+{
+   using
+      serializer = record_serializer<T>;
+   
+   ::std::vector<run_reader>
+      readers;
+   
+   ::std::vector<T>
+      heads( runs.size() );
+   
+   ::std::vector<::std::size_t>
+      heap;
+   
+   readers.reserve( runs.size() );
+   
+   for( ::std::size_t index = 0; index < runs.size(); ++index )
+   {
+      readers.emplace_back( runs[index].get(), buffer_size );
+      
+      if( serializer::read( readers[index], heads[index] ) )
+      {
+         heap.push_back( index );
+      }
+   }
+   
+   auto const
+      later =
+         [&] (::std::size_t left, ::std::size_t right)
+         {
+            auto const &
+               left_key = ::std::invoke( projection, heads[left] );
+            
+            auto const &
+               right_key = ::std::invoke( projection, heads[right] );
+            
+            if( ::std::invoke( comparison, right_key, left_key ) )
+            {
+               return
+                  true;
+            }
+            
+            return
+               not ::std::invoke( comparison, left_key, right_key ) and right < left;
+         }
+         ;
+   
+   ::std::ranges::make_heap( heap, later );
+   
+   while( not heap.empty() )
+   {
+      ::std::ranges::pop_heap( heap, later );
+      
+      auto const
+         index = heap.back();
+      
+      sink( ::std::move( heads[index] ) );
+      
+      if( serializer::read( readers[index], heads[index] ) )
+      {
+         ::std::ranges::push_heap( heap, later );
+      }
+      else
+      {
+         heap.pop_back();
+      }
+   }
+}
+
+//
+// Merges a group of consecutive runs into one new run:
+//
+
+template <typename T, typename Comparison, typename Projection>
+file_pointer
+merge_into_run
+   (
+   ::std::vector<file_pointer> const & runs,
+   ::std::size_t buffer_size,
+   Comparison const & comparison,
+   Projection const & projection
+   )
+{
+   auto
+      file = make_run_file();
+   
+   run_writer
+      writer( file.get(), buffer_size );
+   
+   merge_runs<T>
+      (
+      runs,
+      buffer_size,
+      comparison,
+      projection,
+      [&] (T && record)
+      {
+         record_serializer<T>::write( writer, record );
+      }
+      )
+      ;
+   
+   writer.flush();
+   
+   rewind_run( file.get() );
+   
+   return
+      file;
+}
+
+template
+   <
+   ::std::ranges::input_range R,
+   typename O,
+   typename Comparison = ::std::ranges::less,
+   typename Projection = ::std::identity
+   >
+   requires
+      (
+      Serializable< ::std::ranges::range_value_t<R> >
+      
+      and
+      
+      ::std::output_iterator< O, ::std::ranges::range_value_t<R> >
+      
+      and
+      
+      ::std::sortable
+         <
+         typename ::std::vector< ::std::ranges::range_value_t<R> >::iterator,
+         Comparison,
+         Projection
+         >
+      )
+O
+external_sort
+   (
+   R && range,
+   O output,
+   ::std::size_t memory_budget,
+   Comparison comparison = { },
+   Projection projection = { }
+   )
+{
+   using
+      T = ::std::ranges::range_value_t<R>;
+   
+   using
+      serializer = record_serializer<T>;
+   
+   //
+   // A run holds at most half the budget, so that the buffer
+   // of the stable sort, which holds up to as many records as
+   // the run, fits in the other half. The run is reserved up
+   // front, so that it never grows past its budget:
+   //
+   
+   ::std::size_t const
+      run_budget = memory_budget / 2u;
+   
+   //
+   // At most fan_in runs are merged at once, each read
+   // through a buffer of merge_buffer_size bytes, and the
+   // merged run written through another. This bounds the
+   // number of open files, and keeps the buffers within the
+   // half of the budget which the run leaves:
+   //
+   
+   constexpr ::std::size_t
+      maximum_fan_in = 16u,
+      minimum_merge_buffer = 64u * 1024u;
+   
+   ::std::size_t const
+      fan_in = ::std::clamp <::std::size_t> ( run_budget / minimum_merge_buffer, 2u, maximum_fan_in ),
+      merge_buffer_size = ::std::max <::std::size_t> ( run_budget / ( fan_in + 1u ), 1u ),
+      io_buffer_size = ::std::max <::std::size_t> ( memory_budget / 16u, 1u );
+   
+   ::std::vector<T>
+      run;
+   
+   run.reserve( ::std::max <::std::size_t> ( run_budget / sizeof( T ), 1u ) );
+   
+   //
+   // The runs are kept like the digits of a counter in base
+   // fan_in: a level which reaches fan_in runs is merged into
+   // one run of the next level. Every run of a level is older
+   // than the runs of the levels below it:
+   //
+   
+   ::std::vector< ::std::vector<file_pointer> >
+      levels;
+   
+   auto
+      first = ::std::ranges::begin( range );
+   
+   auto const
+      last = ::std::ranges::end( range );
+   
+   while( first != last )
+   {
+      run.clear();
+      
+      //
+      // A run takes at least one record, whatever the budget:
+      //
+      
+      for( ::std::size_t used = 0u; first != last and ( run.empty() or used + sizeof( T ) <= run_budget ); ++first )
+      {
+         run.push_back( *first );
+         
+         used += sizeof( T ) + serializer::extra_size( run.back() );
+      }
+      
+      parallel_sort( run, comparison, projection );
+      
+      //
+      // If the whole range fits in one run, there is
+      // nothing to spill or merge:
+      //
+      
+      if( levels.empty() and first == last )
+      {
+         return
+            ::std::ranges::move( run, ::std::move( output ) ).out;
+      }
+      
+      auto
+         file = make_run_file();
+      
+      run_writer
+         writer( file.get(), io_buffer_size );
+      
+      if constexpr ( ::std::is_trivially_copyable_v<T> )
+      {
+         writer.write( run.data(), run.size() * sizeof( T ) );
+      }
+      else
+      {
+         for( auto const & record : run )
+         {
+            serializer::write( writer, record );
+         }
+      }
+      
+      writer.flush();
+      
+      rewind_run( file.get() );
+      
+      if( levels.empty() )
+      {
+         levels.emplace_back();
+      }
+      
+      levels.front().push_back( ::std::move( file ) );
+      
+      for( ::std::size_t level = 0; levels[level].size() == fan_in; ++level )
+      {
+         if( level + 1u == levels.size() )
+         {
+            levels.emplace_back();
+         }
+         
+         auto
+            merged = merge_into_run<T>( levels[level], merge_buffer_size, comparison, projection );
+         
+         levels[level].clear();
+         
+         levels[ level + 1u ].push_back( ::std::move( merged ) );
+      }
+   }
+   
+   //
+   // Release the run buffer, and collect the runs, oldest
+   // first. Merge the oldest ones until at most fan_in
+   // remain:
+   //
+   
+   run = ::std::vector<T>();
+   
+   ::std::vector<file_pointer>
+      runs;
+   
+   for( auto level = levels.rbegin(); level != levels.rend(); ++level )
+   {
+      ::std::ranges::move( *level, ::std::back_inserter( runs ) );
+   }
+   
+   levels.clear();
+   
+   while( runs.size() > fan_in )
+   {
+      auto const
+         group_end = runs.begin() + static_cast<::std::ptrdiff_t>( fan_in );
+      
+      ::std::vector<file_pointer>
+         group( ::std::make_move_iterator( runs.begin() ), ::std::make_move_iterator( group_end ) );
+      
+      runs.erase( runs.begin(), group_end );
+      
+      runs.insert( runs.begin(), merge_into_run<T>( group, merge_buffer_size, comparison, projection ) );
+   }
+   
+   merge_runs<T>
+      (
+      runs,
+      ::std::max <::std::size_t> ( memory_budget / ( runs.size() + 1u ), 1u ),
+      comparison,
+      projection,
+      [&] (T && record)
+      {
+         *output = ::std::move( record );
+         
+         ++output;
+      }
+      )
+      ;
+   
+   return
+      output;
+}
+
+//
+// A record which is not trivially copyable, with its
+// serializer:
+//
+
+struct Person final
+{
+   ::std::string
+      id_;
+   
+   double
+      salary_;
+}
+;
+
+template <>
+struct record_serializer<Person> final
+{
+   static void
+      write(run_writer & writer, Person const & person)
+   {
+      auto const
+         size = static_cast<::std::uint32_t>( person.id_.size() );
+      
+      writer.write( &size, sizeof( size ) );
+      
+      writer.write( person.id_.data(), size );
+      
+      writer.write( &person.salary_, sizeof( person.salary_ ) );
+   }
+   
+   static bool
+      read(run_reader & reader, Person & person)
+   {
+      ::std::uint32_t
+         size = 0u;
+      
+      if( not reader.read( &size, sizeof( size ) ) )
+      {
+         return
+            false;
+      }
+      
+      person.id_.resize( size );
+      
+      return
+         reader.read( person.id_.data(), size )
+         
+         and
+         
+         reader.read( &person.salary_, sizeof( person.salary_ ) );
+   }
+   
+   //
+   // An ID only owns heap memory once it outgrows the small
+   // string buffer, whose capacity depends on the standard
+   // library (15 characters in libstdc++ and MSVC, 22 in
+   // libc++):
+   //
+   
+   static ::std::size_t
+      extra_size(Person const & person)
+   {
+      static ::std::size_t const
+         small_capacity = ::std::string().capacity();
+      
+      return
+         person.id_.capacity() > small_capacity ? person.id_.capacity() : 0u;
+   }
+}
+;
+
+//
+// An output iterator which checks that its input is sorted,
+// without storing it:
+//
+
+template <typename T, typename Comparison = ::std::ranges::less, typename Projection = ::std::identity>
+struct sorted_checker final
+{
+   struct state final
+   {
+      ::std::size_t
+         count = 0u;
+      
+      bool
+         sorted = true;
+      
+      T
+         previous { };
+   }
+   ;
+   
+   using
+      difference_type = ::std::ptrdiff_t;
+   
+   ::std::shared_ptr<state>
+      state_ = ::std::make_shared<state>();
+   
+   Comparison
+      comparison { };
+   
+   Projection
+      projection { };
+   
+   sorted_checker &
+      operator* (void)
+   {
+      return
+         *this;
+   }
+   
+   sorted_checker &
+      operator++ (void)
+   {
+      return
+         *this;
+   }
+   
+   sorted_checker &
+      operator++ (int)
+   {
+      return
+         *this;
+   }
+   
+   sorted_checker &
+      operator= (T value)
+   {
+      if
+         (
+         state_->count > 0u
+         
+         and
+         
+         ::std::invoke
+            (
+            comparison,
+            ::std::invoke( projection, value ),
+            ::std::invoke( projection, state_->previous )
+            )
+         )
+      {
+         state_->sorted = false;
+      }
+      
+      state_->previous = ::std::move( value );
+      
+      ++state_->count;
+      
+      return
+         *this;
+   }
+}
+;
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+constexpr ::std::uint64_t
+random_value(::std::uint64_t index)
+{
+   index += 0x9e3779b97f4a7c15ull;
+   
+   index = ( index ^ ( index >> 30u ) ) * 0xbf58476d1ce4e5b9ull;
+   
+   index = ( index ^ ( index >> 27u ) ) * 0x94d049bb133111ebull;
+   
+   return
+      index ^ ( index >> 31u );
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<int> const
+      items { 5, 3, 9, 1, 7, 2, 8, 6, 4, 0 };
+   
+   ::std::vector<int>
+      sorted;
+   
+   //
+   // A budget of 16 bytes makes runs of 2 ints, merged 2 at a
+   // time:
+   //
+   
+   external_sort( items, ::std::back_inserter( sorted ), 16u );
+   
+   for( int v : sorted )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   assert( ::std::ranges::is_sorted( sorted ) and sorted.size() == items.size() );
+   
+   //
+   // A budget of 0 makes runs of one record:
+   //
+   
+   sorted.clear();
+   
+   external_sort( items, ::std::back_inserter( sorted ), 0u );
+   
+   assert( ::std::ranges::is_sorted( sorted ) and sorted.size() == items.size() );
+   
+   //
+   // Equal keys keep their order, within and across runs:
+   //
+   
+   struct keyed
+   {
+      int
+         key,
+         order;
+   }
+   ;
+   
+   ::std::vector<keyed>
+      records,
+      by_key;
+   
+   for( int order = 0; order < 100; ++order )
+   {
+      records.push_back( { ( order * 7 ) % 5, order } );
+   }
+   
+   external_sort( records, ::std::back_inserter( by_key ), 10u * sizeof( keyed ), { }, &keyed::key );
+   
+   assert
+      (
+      ::std::ranges::is_sorted
+         (
+         by_key,
+         [] (keyed const & left, keyed const & right)
+         {
+            return
+               left.key < right.key or ( left.key == right.key and left.order < right.order );
+         }
+         )
+      )
+      ;
+   
+   }
+   
+   {
+   
+   //
+   // Sort a generated sequence of 64-bit integers, which is
+   // never stored in memory, under a memory budget. The
+   // size of the sequence in MiB and the budget in MiB can
+   // be passed as the first and second command-line
+   // arguments:
+   //
+   
+   ::std::size_t const
+      size_mib =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 256u
+               ,
+      budget_mib =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 16u
+               ;
+   
+   auto const
+      count = size_mib * 1024u * 1024u / sizeof( ::std::uint64_t );
+   
+   auto const
+      input = ::std::views::iota( ::std::uint64_t { 0u }, count ) | ::std::views::transform( random_value );
+   
+   sorted_checker<::std::uint64_t>
+      checker;
+   
+   auto const
+      external_time =
+         milliseconds
+            (
+            [&]
+            {
+               external_sort( input, checker, budget_mib * 1024u * 1024u );
+            }
+            )
+            ;
+   
+   assert( checker.state_->sorted and checker.state_->count == count );
+   
+   ::std::vector<::std::uint64_t>
+      in_memory( count );
+   
+   ::std::ranges::copy( input, in_memory.begin() );
+   
+   auto const
+      in_memory_time =
+         milliseconds
+            (
+            [&]
+            {
+               ::std::ranges::sort( in_memory );
+            }
+            )
+            ;
+   
+   ::std::cout << "sort "
+               << size_mib
+               << " MiB of 64-bit integers:"
+               << ::std::endl
+               << "   external_sort ("
+               << budget_mib
+               << " MiB budget): "
+               << external_time
+               << " ms"
+               << ::std::endl
+               << "   ranges::sort (in memory):    "
+               << in_memory_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   {
+   
+   //
+   // Sort people by salary through their serializer:
+   //
+   
+   ::std::size_t const
+      count = 1'000'000u;
+   
+   auto const
+      people =
+         ::std::views::iota( ::std::uint64_t { 0u }, ::std::uint64_t { count } )
+         |
+         ::std::views::transform
+            (
+            [] (::std::uint64_t index)
+            {
+               return
+                  Person
+                     {
+                     "person-" + ::std::to_string( index ),
+                     static_cast<double>( random_value( index ) % 100'000u )
+                     }
+                     ;
+            }
+            )
+            ;
+   
+   sorted_checker< Person, ::std::ranges::less, decltype( &Person::salary_ ) >
+      checker { .projection = &Person::salary_ };
+   
+   auto const
+      time =
+         milliseconds
+            (
+            [&]
+            {
+               external_sort( people, checker, 8u * 1024u * 1024u, { }, &Person::salary_ );
+            }
+            )
+            ;
+   
+   assert( checker.state_->sorted and checker.state_->count == count );
+   
+   ::std::cout << "sort "
+               << count
+               << " people by salary (8 MiB budget): "
+               << time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,843 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <new>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+//
+// The Point and Point4 of the spaceship operator examples.
+// Point4 orders y first, and only has <=>:
+//
+
+struct Point
+{
+   int
+      x,
+      y
+      ;
+   
+   auto operator <=> (Point const & other) const = default;
+}
+;
+
+struct Point4
+{
+   int
+      x,
+      y
+      ;
+   
+   ::std::strong_ordering
+      operator<=> (Point4 const & other) const
+   {
+      if ( auto cmp = y <=> other.y; cmp != 0 )
+      {
+         return
+            cmp;
+      }
+      
+      return ( x <=> other.x )
+         ;
+   }
+}
+;
+
+//
+// A key for heterogeneous lookup, which compares Points by
+// x only, so that an equal range holds every Point of a
+// column:
+//
+
+struct column
+{
+   int
+      x;
+   
+   friend ::std::strong_ordering
+      operator<=> (Point const & point, column const & key)
+   {
+      return
+         point.x <=> key.x;
+   }
+}
+;
+
+//
+// Keys comparable with <=>, with a result which compares
+// with 0:
+//
+
+template <typename Key, typename Other>
+concept ThreeWayComparableWith =
+   requires(Key const & key, Other const & other)
+   {
+      { key <=> other } -> ::std::convertible_to<::std::weak_ordering>;
+   }
+   ;
+
+//
+// Allocates arrays aligned to cache lines:
+//
+
+template <typename T>
+struct cache_aligned_allocator
+{
+   typedef
+      T
+      value_type
+         ;
+   
+   static constexpr ::std::align_val_t
+      alignment { 64u };
+   
+   cache_aligned_allocator(void) = default;
+   
+   template <typename U>
+   cache_aligned_allocator(cache_aligned_allocator<U> const &) noexcept
+   {
+   }
+   
+   T *
+      allocate(::std::size_t size)
+   {
+      return
+         static_cast<T *>( ::operator new( size * sizeof( T ), alignment ) );
+   }
+   
+   void
+      deallocate(T * pointer, ::std::size_t) noexcept
+   {
+      ::operator delete( pointer, alignment );
+   }
+   
+   template <typename U>
+   bool
+      operator== (cache_aligned_allocator<U> const &) const noexcept
+   {
+      return
+         true;
+   }
+}
+;
+
+//
+// A map built once and then only searched, for read-mostly
+// lookup tables:
+//
+//    * The entries are stored in Eytzinger (breadth-first)
+//      order: the children of the entry at position k are at
+//      2 k and 2 k + 1. The first levels of the implicit
+//      tree, which every search reads, share a few cache
+//      lines.
+//    * A search descends the tree without branching on the
+//      result of <=>: k = 2 k + ( key[k] < x ). The lower
+//      bound is the last node where the search went left,
+//      found from the trailing ones of k. It is on the path
+//      of the search, so reading its value does not miss the
+//      cache.
+//    * While descending, the search prefetches the
+//      descendants of the current node a few levels below,
+//      which are contiguous, so that the memory latency of
+//      later levels overlaps the comparisons of earlier
+//      ones.
+//    * Iterators visit the entries in the order of the keys,
+//      moving to the in-order successor in the implicit
+//      tree.
+//    * Keys need only <=>, and lookups take any type which
+//      compares with the keys through <=>.
+//
+
+template <typename Key, typename Value>
+   requires ThreeWayComparableWith<Key, Key>
+class flat_static_map final
+{
+public:
+   typedef
+      ::std::pair<Key, Value>
+      value_type
+         ;
+   
+   class const_iterator final
+   {
+   public:
+      typedef
+         ::std::bidirectional_iterator_tag
+         iterator_category
+            ;
+      
+      typedef
+         flat_static_map::value_type
+         value_type
+            ;
+      
+      typedef
+         ::std::ptrdiff_t
+         difference_type
+            ;
+      
+      typedef
+         value_type const *
+         pointer
+            ;
+      
+      typedef
+         value_type const &
+         reference
+            ;
+      
+      const_iterator(void) = default;
+      
+      reference
+         operator* (void) const noexcept
+      {
+         return
+            map_->nodes_[node_];
+      }
+      
+      pointer
+         operator-> (void) const noexcept
+      {
+         return
+            &map_->nodes_[node_];
+      }
+      
+      //
+      // The leftmost node of the right subtree, or else the
+      // first ancestor of which this node is in the left
+      // subtree:
+      //
+      
+      const_iterator &
+         operator++ (void) noexcept
+      {
+         if( 2u * node_ + 1u < map_->nodes_.size() )
+         {
+            node_ = map_->leftmost( 2u * node_ + 1u );
+         }
+         else
+         {
+            node_ >>= ::std::countr_one( node_ ) + 1;
+         }
+         
+         return
+            *this;
+      }
+      
+      //
+      // The mirror image; the predecessor of the end is the
+      // last node:
+      //
+      
+      const_iterator &
+         operator-- (void) noexcept
+      {
+         if( node_ == 0u )
+         {
+            node_ = map_->rightmost( 1u );
+         }
+         else if( 2u * node_ < map_->nodes_.size() )
+         {
+            node_ = map_->rightmost( 2u * node_ );
+         }
+         else
+         {
+            node_ >>= ::std::countr_zero( node_ ) + 1;
+         }
+         
+         return
+            *this;
+      }
+      
+      const_iterator
+         operator++ (int) noexcept
+      {
+         auto
+            copy = *this;
+         
+         ++*this;
+         
+         return
+            copy;
+      }
+      
+      const_iterator
+         operator-- (int) noexcept
+      {
+         auto
+            copy = *this;
+         
+         --*this;
+         
+         return
+            copy;
+      }
+      
+      bool
+         operator== (const_iterator const & other) const noexcept
+      {
+         return
+            node_ == other.node_;
+      }
+   
+   private:
+      friend flat_static_map;
+      
+      const_iterator(flat_static_map const * map, ::std::size_t node) noexcept
+         : map_( map ), node_( node )
+      {
+      }
+      
+      flat_static_map const *
+         map_ = nullptr;
+      
+      //
+      // The end is node 0:
+      //
+      
+      ::std::size_t
+         node_ = 0u;
+   }
+   ;
+   
+   //
+   // Builds the map from pairs. Of equal keys, the first is
+   // kept, as with ::std::map::insert:
+   //
+   
+   template <::std::ranges::input_range Range>
+      requires ::std::convertible_to< ::std::ranges::range_reference_t<Range>, value_type >
+   explicit flat_static_map(Range && entries)
+   {
+      ::std::vector<value_type>
+         sorted;
+      
+      for( auto && entry : entries )
+      {
+         sorted.emplace_back( entry );
+      }
+      
+      ::std::ranges::stable_sort
+         (
+         sorted,
+         [] (Key const & first, Key const & second) { return ( first <=> second ) < 0; },
+         &value_type::first
+         )
+         ;
+      
+      auto const
+         duplicates =
+            ::std::ranges::unique
+               (
+               sorted,
+               [] (Key const & first, Key const & second) { return ( first <=> second ) == 0; },
+               &value_type::first
+               )
+               ;
+      
+      sorted.erase( duplicates.begin(), duplicates.end() );
+      
+      if( sorted.empty() )
+      {
+         return;
+      }
+      
+      //
+      // Position 0 is not a node: it is where a search which
+      // found no lower bound ends, and the end iterator:
+      //
+      
+      nodes_.resize( sorted.size() + 1u, sorted.front() );
+      
+      fill( sorted, 0u, 1u );
+   }
+   
+   flat_static_map(::std::initializer_list<value_type> entries)
+      : flat_static_map( ::std::ranges::subrange( entries.begin(), entries.end() ) )
+   {
+   }
+   
+   ::std::size_t
+      size(void) const noexcept
+   {
+      return
+         nodes_.empty() ? 0u : nodes_.size() - 1u;
+   }
+   
+   const_iterator
+      begin(void) const noexcept
+   {
+      return
+         { this, nodes_.empty() ? 0u : leftmost( 1u ) };
+   }
+   
+   const_iterator
+      end(void) const noexcept
+   {
+      return
+         { this, 0u };
+   }
+   
+   //
+   // The first entry whose key is not less than other:
+   //
+   
+   template <typename Other>
+   const_iterator
+      lower_bound(Other const & other) const
+      requires ThreeWayComparableWith<Key, Other>
+   {
+      return
+         { this, search( [&] (Key const & key) { return ( key <=> other ) < 0; } ) };
+   }
+   
+   //
+   // The first entry whose key is greater than other:
+   //
+   
+   template <typename Other>
+   const_iterator
+      upper_bound(Other const & other) const
+      requires ThreeWayComparableWith<Key, Other>
+   {
+      return
+         { this, search( [&] (Key const & key) { return ( key <=> other ) <= 0; } ) };
+   }
+   
+   template <typename Other>
+   ::std::pair<const_iterator, const_iterator>
+      equal_range(Other const & other) const
+      requires ThreeWayComparableWith<Key, Other>
+   {
+      return
+         { lower_bound( other ), upper_bound( other ) };
+   }
+   
+   template <typename Other>
+   const_iterator
+      find(Other const & other) const
+      requires ThreeWayComparableWith<Key, Other>
+   {
+      auto const
+         found = lower_bound( other );
+      
+      return
+         found != end() and ( found->first <=> other ) == 0 ? found : end();
+   }
+   
+   template <typename Other>
+   bool
+      contains(Other const & other) const
+      requires ThreeWayComparableWith<Key, Other>
+   {
+      return
+         find( other ) != end();
+   }
+   
+   template <typename Other>
+   Value const &
+      at(Other const & other) const
+      requires ThreeWayComparableWith<Key, Other>
+   {
+      auto const
+         found = find( other );
+      
+      if( found == end() )
+      {
+         throw
+            ::std::out_of_range( "flat_static_map::at: key not found" );
+      }
+      
+      return
+         found->second;
+   }
+
+private:
+   //
+   // The descendants of node k some levels below are
+   // contiguous, from prefetch_distance k: as many as fit in
+   // a cache line:
+   //
+   
+   static constexpr ::std::size_t
+      prefetch_distance = ::std::bit_floor( ::std::max< ::std::size_t >( 64u / sizeof( value_type ), 1u ) );
+   
+   //
+   // Fills the tree from the sorted entries by an in-order
+   // traversal:
+   //
+   
+   ::std::size_t
+      fill(::std::vector<value_type> & sorted, ::std::size_t rank, ::std::size_t node)
+   {
+      if( node < nodes_.size() )
+      {
+         rank = fill( sorted, rank, 2u * node );
+         
+         nodes_[node] = ::std::move( sorted[rank] );
+         
+         rank = fill( sorted, rank + 1u, 2u * node + 1u );
+      }
+      
+      return
+         rank;
+   }
+   
+   ::std::size_t
+      leftmost(::std::size_t node) const noexcept
+   {
+      while( 2u * node < nodes_.size() )
+      {
+         node *= 2u;
+      }
+      
+      return
+         node;
+   }
+   
+   ::std::size_t
+      rightmost(::std::size_t node) const noexcept
+   {
+      while( 2u * node + 1u < nodes_.size() )
+      {
+         node = 2u * node + 1u;
+      }
+      
+      return
+         node;
+   }
+   
+   //
+   // The position of the first key for which goes_right is
+   // false, or 0:
+   //
+   
+   template <typename GoesRight>
+   ::std::size_t
+      search(GoesRight goes_right) const
+   {
+      ::std::size_t
+         node = 1u;
+      
+      auto const
+         size = nodes_.size();
+      
+      while( node < size )
+      {
+#if defined(__GNUC__)
+         __builtin_prefetch( reinterpret_cast<void const *>( reinterpret_cast<::std::uintptr_t>( nodes_.data() ) + prefetch_distance * node * sizeof( value_type ) ) );
+#endif
+         
+         node = 2u * node + static_cast<::std::size_t>( goes_right( nodes_[node].first ) );
+      }
+      
+      //
+      // Undo the moves right after the last move left:
+      //
+      
+      return
+         node >> ( ::std::countr_one( node ) + 1 );
+   }
+   
+   ::std::vector< value_type, cache_aligned_allocator<value_type> >
+      nodes_;
+}
+;
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+struct point_hash
+{
+   ::std::size_t
+      operator() (Point const & point) const noexcept
+   {
+      auto
+         bits = ( static_cast<::std::uint64_t>( static_cast<::std::uint32_t>( point.x ) ) << 32u ) | static_cast<::std::uint32_t>( point.y );
+      
+      bits ^= bits >> 33u;
+      bits *= 0xff51'afd7'ed55'8ccdu;
+      bits ^= bits >> 33u;
+      
+      return
+         static_cast<::std::size_t>( bits );
+   }
+}
+;
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   flat_static_map<Point, char const *> const
+      names
+         {
+         { { 0, 0 }, "origin" },
+         { { 1, 0 }, "east" },
+         { { 1, 2 }, "north-east" },
+         { { -1, 0 }, "west" },
+         { { 0, 0 }, "duplicate" }
+         }
+         ;
+   
+   assert( names.size() == 4u and ::std::string_view( names.at( Point { 0, 0 } ) ) == "origin" );
+   
+   assert( names.lower_bound( Point { 0, 1 } )->first == ( Point { 1, 0 } ) );
+   
+   assert( names.find( Point { 2, 2 } ) == names.end() and names.upper_bound( Point { 5, 5 } ) == names.end() );
+   
+   //
+   // Heterogeneous lookup of every Point with x == 1:
+   //
+   
+   [[maybe_unused]] auto const
+      [ first, last ] = names.equal_range( column { 1 } );
+   
+   assert( ::std::distance( first, last ) == 2 and first->first == ( Point { 1, 0 } ) );
+   
+   //
+   // Iteration is in the order of the keys:
+   //
+   
+   static_assert( ::std::bidirectional_iterator< flat_static_map<Point, char const *>::const_iterator > );
+   
+   assert( ::std::ranges::is_sorted( names, ::std::ranges::less(), &::std::pair<Point, char const *>::first ) );
+   
+   assert( ::std::prev( names.end() )->first == ( Point { 1, 2 } ) );
+   
+   //
+   // Point4, which orders y first:
+   //
+   
+   flat_static_map<Point4, int> const
+      ordered { { { 5, 0 }, 1 }, { { 0, 1 }, 2 }, { { -5, 0 }, 3 } };
+   
+   assert( ordered.begin()->second == 3 and ordered.lower_bound( Point4 { 9, 0 } )->second == 2 );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark lookups. The largest number of keys can be
+   // passed as the first command-line argument:
+   //
+   
+   ::std::size_t const
+      largest =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 4'000'000u
+               ;
+   
+   for( auto const size : { ::std::size_t { 1'000u }, ::std::size_t { 100'000u }, largest } )
+   {
+      ::std::mt19937
+         generator( 42 );
+      
+      ::std::uniform_int_distribution<int>
+         coordinate( -100'000, 100'000 );
+      
+      ::std::vector< ::std::pair<Point, int> >
+         entries( size );
+      
+      for( ::std::size_t index = 0; index < size; ++index )
+      {
+         entries[index] = { Point { coordinate( generator ), coordinate( generator ) }, static_cast<int>( index ) };
+      }
+      
+      //
+      // Half of the lookups hit. Each container sums the values
+      // found into a checksum which is printed, so that the
+      // lookups cannot be removed:
+      //
+      
+      ::std::size_t const
+         lookups = 2'000'000u;
+      
+      ::std::vector<Point>
+         queries( lookups );
+      
+      for( ::std::size_t index = 0; index < lookups; ++index )
+      {
+         queries[index] =
+            index % 2u == 0u
+               ? entries[ generator() % size ].first
+               : Point { coordinate( generator ), coordinate( generator ) }
+                  ;
+      }
+      
+      flat_static_map<Point, int> const
+         flat( entries );
+      
+      ::std::map<Point, int> const
+         tree( entries.begin(), entries.end() );
+      
+      ::std::unordered_map<Point, int, point_hash> const
+         hashed( entries.begin(), entries.end() );
+      
+      ::std::vector< ::std::pair<Point, int> > const
+         sorted( tree.begin(), tree.end() );
+      
+      long long
+         expected = 0;
+      
+      bool
+         first_result = true;
+      
+      auto const
+         run =
+            [&] (char const * name, auto && find)
+            {
+               long long
+                  sum = 0;
+               
+               auto const
+                  time =
+                     milliseconds
+                        (
+                        [&]
+                        {
+                           for( auto const & query : queries )
+                           {
+                              sum += find( query );
+                           }
+                        }
+                        )
+                        ;
+               
+               if( expected == 0 )
+               {
+                  expected = sum;
+               }
+               
+               assert( sum == expected );
+               
+               ::std::cout << ( ::std::exchange( first_result, false ) ? "" : ", " )
+                           << name
+                           << " "
+                           << time * 1e6 / static_cast<double>( lookups )
+                           << " (checksum "
+                           << sum
+                           << ")"
+                              ;
+            }
+            ;
+      
+      ::std::cout << tree.size()
+                  << " keys, nanoseconds per lookup: "
+                     ;
+      
+      run
+         (
+         "std::map",
+         [&] (Point const & query)
+         {
+            auto const
+               found = tree.find( query );
+            
+            return
+               found == tree.end() ? -1 : found->second;
+         }
+         )
+         ;
+      
+      run
+         (
+         "lower_bound",
+         [&] (Point const & query)
+         {
+            auto const
+               found = ::std::lower_bound( sorted.begin(), sorted.end(), query, [] (auto const & entry, Point const & key) { return entry.first < key; } );
+            
+            return
+               found == sorted.end() or found->first != query ? -1 : found->second;
+         }
+         )
+         ;
+      
+      run
+         (
+         "unordered_map",
+         [&] (Point const & query)
+         {
+            auto const
+               found = hashed.find( query );
+            
+            return
+               found == hashed.end() ? -1 : found->second;
+         }
+         )
+         ;
+      
+      run
+         (
+         "flat_static_map",
+         [&] (Point const & query)
+         {
+            auto const
+               found = flat.find( query );
+            
+            return
+               found == flat.end() ? -1 : found->second;
+         }
+         )
+         ;
+      
+      ::std::cout << ::std::endl;
+   }
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,1291 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <span>
+#include <random>
+#include <chrono>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//
+// ::std::ranges::set_intersection walks both of its input
+// ranges element by element, so intersecting a list of 10
+// elements with a list of 10 million elements takes 10
+// million steps. When one range is much smaller than the
+// other, it is faster to take each element of the smaller
+// range and search for it in the larger range. Because both
+// ranges are sorted, each search can start where the
+// previous search ended.
+//
+// "Galloping" (or exponential) search looks at the elements
+// 1, 2, 4, 8, ... positions ahead until it overshoots the
+// value, and then binary searches the last interval. It
+// costs O(log d) comparisons, where d is the distance to the
+// value, so it is cheap both when the value is close (as in
+// a balanced intersection) and when it is far away.
+//
+// The algorithms below take and return ranges and iterators
+// in the same way as the algorithms in ::std::ranges, and
+// require their inputs to be sorted with respect to the
+// comparison. Like posting lists, the inputs are assumed not
+// to contain duplicates.
+//
+
+namespace galloping
+{
+
+//
+// Returns the first iterator in [first, last) which is not
+// less than value:
+//
+
+template
+   <
+   ::std::random_access_iterator I,
+   ::std::sentinel_for<I> S,
+   typename T,
+   typename Comparison = ::std::ranges::less
+   >
+constexpr I
+lower_bound(I first, S last, T const & value, Comparison comparison = { })
+{
+   ::std::iter_difference_t<I>
+      step = 1;
+   
+   auto const
+      size = ::std::ranges::distance( first, last );
+   
+   //
+   // Gallop until first[step - 1] is not less than value:
+   //
+   
+   I
+      low = first;
+   
+   while( step <= size and ::std::invoke( comparison, first[step - 1], value ) )
+   {
+      low = first + step;
+      
+      step *= 2;
+   }
+   
+   auto const
+      high = first + ::std::min( step - 1, size );
+   
+   return
+      ::std::ranges::lower_bound( low, high, value, comparison );
+}
+
+//
+// Intersection of ranges of very different sizes: search for
+// every element of the smaller range in the larger range.
+// The elements are written in order, and are taken from the
+// first range:
+//
+
+template <typename I1, typename S1, typename I2, typename S2, typename O, typename Comparison>
+constexpr O
+intersect_by_search
+   (
+   I1 first1, S1 last1,
+   I2 first2, S2 last2,
+   O output,
+   Comparison comparison,
+   bool search_in_second
+   )
+{
+   if( search_in_second )
+   {
+      for( ; first1 != last1 and first2 != last2; ++first1 )
+      {
+         first2 = lower_bound( first2, last2, *first1, comparison );
+         
+         if( first2 != last2 and not ::std::invoke( comparison, *first1, *first2 ) )
+         {
+            *output = *first1;
+            
+            ++output;
+            
+            ++first2;
+         }
+      }
+   }
+   else
+   {
+      for( ; first1 != last1 and first2 != last2; ++first2 )
+      {
+         first1 = lower_bound( first1, last1, *first2, comparison );
+         
+         if( first1 != last1 and not ::std::invoke( comparison, *first2, *first1 ) )
+         {
+            *output = *first1;
+            
+            ++output;
+            
+            ++first1;
+         }
+      }
+   }
+   
+   return
+      output;
+}
+
+//
+// Intersection of ranges of similar sizes: a linear merge,
+// galloping over runs of non-matching elements:
+//
+
+template <typename I1, typename S1, typename I2, typename S2, typename O, typename Comparison>
+constexpr O
+intersect_by_merge
+   (
+   I1 first1, S1 last1,
+   I2 first2, S2 last2,
+   O output,
+   Comparison comparison
+   )
+{
+   while( first1 != last1 and first2 != last2 )
+   {
+      if( ::std::invoke( comparison, *first1, *first2 ) )
+      {
+         first1 = lower_bound( first1, last1, *first2, comparison );
+      }
+      else if( ::std::invoke( comparison, *first2, *first1 ) )
+      {
+         first2 = lower_bound( first2, last2, *first1, comparison );
+      }
+      else
+      {
+         *output = *first1;
+         
+         ++output;
+         
+         ++first1;
+         
+         ++first2;
+      }
+   }
+   
+   return
+      output;
+}
+
+#if defined(__SSE2__)
+
+//
+// Intersection of two contiguous ranges of 32-bit integers,
+// comparing blocks of four elements from each range at
+// once. Each block of the first range is compared with the
+// block of the second range and with three rotations of it
+// (16 comparisons in four instructions), giving a mask of
+// the elements of the first block which appear in the
+// second block. The block with the smaller last element is
+// then replaced by the next block:
+//
+
+template <typename T, typename O>
+O
+intersect_by_blocks
+   (
+   T const * first1, T const * last1,
+   T const * first2, T const * last2,
+   O output
+   )
+{
+   while( last1 - first1 >= 4 and last2 - first2 >= 4 )
+   {
+      __m128i const
+         block1 =
+            _mm_loadu_si128( reinterpret_cast<__m128i const *>( first1 ) ),
+         block2 =
+            _mm_loadu_si128( reinterpret_cast<__m128i const *>( first2 ) );
+      
+      __m128i const
+         matches =
+            _mm_or_si128
+               (
+               _mm_or_si128
+                  (
+                  _mm_cmpeq_epi32( block1, block2 ),
+                  _mm_cmpeq_epi32
+                     (
+                     block1,
+                     _mm_shuffle_epi32( block2, _MM_SHUFFLE( 0, 3, 2, 1 ) )
+                     )
+                  ),
+               _mm_or_si128
+                  (
+                  _mm_cmpeq_epi32
+                     (
+                     block1,
+                     _mm_shuffle_epi32( block2, _MM_SHUFFLE( 1, 0, 3, 2 ) )
+                     ),
+                  _mm_cmpeq_epi32
+                     (
+                     block1,
+                     _mm_shuffle_epi32( block2, _MM_SHUFFLE( 2, 1, 0, 3 ) )
+                     )
+                  )
+               )
+               ;
+      
+      for
+         (
+         int mask = _mm_movemask_ps( _mm_castsi128_ps( matches ) );
+         mask != 0;
+         mask &= mask - 1
+         )
+      {
+         *output = first1[ __builtin_ctz( static_cast<unsigned>( mask ) ) ];
+         
+         ++output;
+      }
+      
+      T const
+         maximum1 = first1[3],
+         maximum2 = first2[3];
+      
+      if( maximum1 <= maximum2 )
+      {
+         first1 += 4;
+      }
+      
+      if( maximum2 <= maximum1 )
+      {
+         first2 += 4;
+      }
+   }
+   
+   return
+      intersect_by_merge
+         (
+         first1, last1, first2, last2, output, ::std::ranges::less { }
+         )
+         ;
+}
+
+#endif
+
+//
+// Above this size ratio, searching from the smaller range
+// is faster than merging:
+//
+
+inline constexpr ::std::size_t
+   search_ratio = 32u;
+
+template
+   <
+   ::std::ranges::random_access_range R1,
+   ::std::ranges::random_access_range R2,
+   ::std::weakly_incrementable O,
+   typename Comparison = ::std::ranges::less
+   >
+   requires
+      ::std::ranges::sized_range<R1>
+      
+      and
+      
+      ::std::ranges::sized_range<R2>
+constexpr O
+set_intersection
+   (
+   R1 && range1,
+   R2 && range2,
+   O output,
+   Comparison comparison = { }
+   )
+{
+   auto const
+      size1 = ::std::ranges::size( range1 ),
+      size2 = ::std::ranges::size( range2 );
+   
+   auto const
+      first1 = ::std::ranges::begin( range1 ),
+      last1 = ::std::ranges::end( range1 );
+   
+   auto const
+      first2 = ::std::ranges::begin( range2 ),
+      last2 = ::std::ranges::end( range2 );
+   
+   if( size1 * search_ratio < size2 or size2 * search_ratio < size1 )
+   {
+      return
+         intersect_by_search
+            (
+            first1, last1, first2, last2, output, comparison, size1 < size2
+            )
+            ;
+   }
+   
+   #if defined(__SSE2__)
+   
+   using
+      T1 = ::std::ranges::range_value_t<R1>;
+   
+   if constexpr
+      (
+      ::std::ranges::contiguous_range<R1>
+      
+      and
+      
+      ::std::ranges::contiguous_range<R2>
+      
+      and
+      
+      ::std::same_as< T1, ::std::ranges::range_value_t<R2> >
+      
+      and
+      
+      ::std::integral<T1>
+      
+      and
+      
+      ( sizeof(T1) == 4u )
+      
+      and
+      
+      ::std::same_as< Comparison, ::std::ranges::less >
+      )
+   {
+      if( not ::std::is_constant_evaluated() )
+      {
+         return
+            intersect_by_blocks
+               (
+               ::std::ranges::data( range1 ),
+               ::std::ranges::data( range1 ) + size1,
+               ::std::ranges::data( range2 ),
+               ::std::ranges::data( range2 ) + size2,
+               output
+               )
+               ;
+      }
+   }
+   
+   #endif
+   
+   return
+      intersect_by_merge( first1, last1, first2, last2, output, comparison );
+}
+
+//
+// Union of ranges of very different sizes: for every
+// element of the smaller range, a galloping search finds
+// the run of elements of the larger range which are less
+// than it, and the run is copied without comparing its
+// elements. Equivalent elements are taken from the first
+// range:
+//
+
+template <typename I1, typename S1, typename I2, typename S2, typename O, typename Comparison>
+constexpr O
+union_by_search
+   (
+   I1 first1, S1 last1,
+   I2 first2, S2 last2,
+   O output,
+   Comparison comparison,
+   bool search_in_second
+   )
+{
+   if( search_in_second )
+   {
+      for( ; first1 != last1; ++first1 )
+      {
+         auto const
+            run = lower_bound( first2, last2, *first1, comparison );
+         
+         output = ::std::ranges::copy( first2, run, output ).out;
+         
+         first2 = run;
+         
+         if( first2 != last2 and not ::std::invoke( comparison, *first1, *first2 ) )
+         {
+            ++first2;
+         }
+         
+         *output = *first1;
+         
+         ++output;
+      }
+   }
+   else
+   {
+      for( ; first2 != last2; ++first2 )
+      {
+         auto const
+            run = lower_bound( first1, last1, *first2, comparison );
+         
+         output = ::std::ranges::copy( first1, run, output ).out;
+         
+         first1 = run;
+         
+         if( first1 != last1 and not ::std::invoke( comparison, *first2, *first1 ) )
+         {
+            *output = *first1;
+            
+            ++first1;
+         }
+         else
+         {
+            *output = *first2;
+         }
+         
+         ++output;
+      }
+   }
+   
+   output = ::std::ranges::copy( first1, last1, output ).out;
+   
+   return
+      ::std::ranges::copy( first2, last2, output ).out;
+}
+
+//
+// Union. Every element is copied, so galloping only saves
+// comparisons, and only pays when one range is much larger
+// than the other: a merge of such ranges compares mostly in
+// the same direction, which the branch predictor learns.
+// Below union_search_ratio, this is ::std::ranges::set_union:
+//
+
+inline constexpr ::std::size_t
+   union_search_ratio = 128u;
+
+template
+   <
+   ::std::ranges::random_access_range R1,
+   ::std::ranges::random_access_range R2,
+   ::std::weakly_incrementable O,
+   typename Comparison = ::std::ranges::less
+   >
+   requires
+      ::std::ranges::sized_range<R1>
+      
+      and
+      
+      ::std::ranges::sized_range<R2>
+constexpr O
+set_union
+   (
+   R1 && range1,
+   R2 && range2,
+   O output,
+   Comparison comparison = { }
+   )
+{
+   auto const
+      size1 = ::std::ranges::size( range1 ),
+      size2 = ::std::ranges::size( range2 );
+   
+   if( size1 * union_search_ratio < size2 or size2 * union_search_ratio < size1 )
+   {
+      return
+         union_by_search
+            (
+            ::std::ranges::begin( range1 ),
+            ::std::ranges::end( range1 ),
+            ::std::ranges::begin( range2 ),
+            ::std::ranges::end( range2 ),
+            output,
+            comparison,
+            size1 < size2
+            )
+            ;
+   }
+   
+   return
+      ::std::ranges::set_union( range1, range2, ::std::move( output ), comparison ).out;
+}
+
+//
+// Intersection of any number of sorted ranges. The ranges
+// are intersected smallest first, so that every
+// intermediate result is no larger than the smallest range,
+// and the intersection stops as soon as it is empty:
+//
+
+template <typename T, typename Comparison = ::std::ranges::less>
+::std::vector<T>
+set_intersection
+   (
+   ::std::vector< ::std::span<T const> > ranges,
+   Comparison comparison = { }
+   )
+{
+   if( ranges.empty() )
+   {
+      return
+         { };
+   }
+   
+   //
+   // The address of a member function of the standard
+   // library is unspecified, so the size is taken through a
+   // lambda:
+   //
+   
+   ::std::ranges::sort
+      (
+      ranges,
+      { },
+      [] (::std::span<T const> range)
+      {
+         return
+            range.size();
+      }
+      )
+      ;
+   
+   ::std::vector<T>
+      result( ranges.front().begin(), ranges.front().end() ),
+      next;
+   
+   for( auto const & range : ranges | ::std::views::drop( 1 ) )
+   {
+      if( result.empty() )
+      {
+         break;
+      }
+      
+      next.clear();
+      
+      set_intersection( result, range, ::std::back_inserter( next ), comparison );
+      
+      result.swap( next );
+   }
+   
+   return
+      result;
+}
+
+//
+// A lazy view of the intersection of two sorted ranges.
+// Each increment gallops through both ranges to the next
+// common element:
+//
+
+template <::std::ranges::view V1, ::std::ranges::view V2, typename Comparison = ::std::ranges::less>
+   requires
+      ::std::ranges::random_access_range<V1>
+      
+      and
+      
+      ::std::ranges::random_access_range<V2>
+class intersection_view
+   : public ::std::ranges::view_interface< intersection_view<V1, V2, Comparison> >
+{
+public:
+   intersection_view(void) = default;
+   
+   intersection_view(V1 range1, V2 range2, Comparison comparison = { })
+      :
+      range1_( ::std::move( range1 ) ),
+      range2_( ::std::move( range2 ) ),
+      comparison_( ::std::move( comparison ) )
+   { }
+   
+   class iterator
+   {
+   public:
+      using
+         value_type = ::std::ranges::range_value_t<V1>;
+      
+      using
+         difference_type = ::std::ptrdiff_t;
+      
+      iterator(void) = default;
+      
+      iterator(intersection_view const & parent)
+         :
+         parent_( &parent ),
+         first1_( ::std::ranges::begin( parent.range1_ ) ),
+         first2_( ::std::ranges::begin( parent.range2_ ) )
+      {
+         this->satisfy();
+      }
+      
+      decltype(auto)
+         operator* (void) const
+      {
+         return
+            *first1_;
+      }
+      
+      iterator &
+         operator++ (void)
+      {
+         ++first1_;
+         
+         ++first2_;
+         
+         this->satisfy();
+         
+         return
+            *this;
+      }
+      
+      iterator
+         operator++ (int)
+      {
+         auto
+            copy = *this;
+         
+         ++*this;
+         
+         return
+            copy;
+      }
+      
+      bool
+         operator== (iterator const & other) const
+      {
+         return
+            first1_ == other.first1_;
+      }
+      
+      bool
+         operator== (::std::default_sentinel_t) const
+      {
+         return
+            first1_ == ::std::ranges::end( parent_->range1_ )
+            
+            or
+            
+            first2_ == ::std::ranges::end( parent_->range2_ )
+               ;
+      }
+   
+   private:
+      //
+      // Advances to the next common element:
+      //
+      
+      void
+         satisfy(void)
+      {
+         auto const
+            last1 = ::std::ranges::end( parent_->range1_ );
+         
+         auto const
+            last2 = ::std::ranges::end( parent_->range2_ );
+         
+         auto const &
+            comparison = parent_->comparison_;
+         
+         while( first1_ != last1 and first2_ != last2 )
+         {
+            if( ::std::invoke( comparison, *first1_, *first2_ ) )
+            {
+               first1_ = lower_bound( first1_, last1, *first2_, comparison );
+            }
+            else if( ::std::invoke( comparison, *first2_, *first1_ ) )
+            {
+               first2_ = lower_bound( first2_, last2, *first1_, comparison );
+            }
+            else
+            {
+               return;
+            }
+         }
+         
+         //
+         // Make the end position unique:
+         //
+         
+         first1_ = last1;
+      }
+      
+      intersection_view const *
+         parent_ = nullptr;
+      
+      ::std::ranges::iterator_t<V1 const>
+         first1_ { };
+      
+      ::std::ranges::iterator_t<V2 const>
+         first2_ { };
+   }
+   ;
+   
+   iterator
+      begin(void) const
+   {
+      return
+         iterator( *this );
+   }
+   
+   ::std::default_sentinel_t
+      end(void) const
+   {
+      return
+         { };
+   }
+
+private:
+   V1
+      range1_;
+   
+   V2
+      range2_;
+   
+   Comparison
+      comparison_;
+}
+;
+
+template <typename R1, typename R2, typename Comparison = ::std::ranges::less>
+intersection_view(R1 &&, R2 &&, Comparison = { })
+   ->
+      intersection_view
+         <
+         ::std::views::all_t<R1>,
+         ::std::views::all_t<R2>,
+         Comparison
+         >
+         ;
+
+//
+// A lazy view of the union of two sorted ranges:
+//
+
+template <::std::ranges::view V1, ::std::ranges::view V2, typename Comparison = ::std::ranges::less>
+   requires
+      ::std::ranges::forward_range<V1>
+      
+      and
+      
+      ::std::ranges::forward_range<V2>
+      
+      and
+      
+      ::std::same_as
+         <
+         ::std::ranges::range_value_t<V1>,
+         ::std::ranges::range_value_t<V2>
+         >
+class union_view
+   : public ::std::ranges::view_interface< union_view<V1, V2, Comparison> >
+{
+public:
+   union_view(void) = default;
+   
+   union_view(V1 range1, V2 range2, Comparison comparison = { })
+      :
+      range1_( ::std::move( range1 ) ),
+      range2_( ::std::move( range2 ) ),
+      comparison_( ::std::move( comparison ) )
+   { }
+   
+   class iterator
+   {
+   public:
+      using
+         value_type = ::std::ranges::range_value_t<V1>;
+      
+      using
+         difference_type = ::std::ptrdiff_t;
+      
+      iterator(void) = default;
+      
+      iterator(union_view const & parent)
+         :
+         parent_( &parent ),
+         first1_( ::std::ranges::begin( parent.range1_ ) ),
+         first2_( ::std::ranges::begin( parent.range2_ ) )
+      { }
+      
+      value_type
+         operator* (void) const
+      {
+         if( this->second_is_next() )
+         {
+            return
+               *first2_;
+         }
+         
+         return
+            *first1_;
+      }
+      
+      iterator &
+         operator++ (void)
+      {
+         bool const
+            end1 = first1_ == ::std::ranges::end( parent_->range1_ ),
+            end2 = first2_ == ::std::ranges::end( parent_->range2_ );
+         
+         auto const &
+            comparison = parent_->comparison_;
+         
+         if( end1 )
+         {
+            ++first2_;
+         }
+         else if( end2 )
+         {
+            ++first1_;
+         }
+         else if( ::std::invoke( comparison, *first1_, *first2_ ) )
+         {
+            ++first1_;
+         }
+         else if( ::std::invoke( comparison, *first2_, *first1_ ) )
+         {
+            ++first2_;
+         }
+         else
+         {
+            ++first1_;
+            
+            ++first2_;
+         }
+         
+         return
+            *this;
+      }
+      
+      iterator
+         operator++ (int)
+      {
+         auto
+            copy = *this;
+         
+         ++*this;
+         
+         return
+            copy;
+      }
+      
+      bool
+         operator== (iterator const & other) const
+      {
+         return
+            first1_ == other.first1_ and first2_ == other.first2_;
+      }
+      
+      bool
+         operator== (::std::default_sentinel_t) const
+      {
+         return
+            first1_ == ::std::ranges::end( parent_->range1_ )
+            
+            and
+            
+            first2_ == ::std::ranges::end( parent_->range2_ )
+               ;
+      }
+   
+   private:
+      bool
+         second_is_next(void) const
+      {
+         if( first1_ == ::std::ranges::end( parent_->range1_ ) )
+         {
+            return
+               true;
+         }
+         
+         if( first2_ == ::std::ranges::end( parent_->range2_ ) )
+         {
+            return
+               false;
+         }
+         
+         return
+            ::std::invoke( parent_->comparison_, *first2_, *first1_ );
+      }
+      
+      union_view const *
+         parent_ = nullptr;
+      
+      ::std::ranges::iterator_t<V1 const>
+         first1_ { };
+      
+      ::std::ranges::iterator_t<V2 const>
+         first2_ { };
+   }
+   ;
+   
+   iterator
+      begin(void) const
+   {
+      return
+         iterator( *this );
+   }
+   
+   ::std::default_sentinel_t
+      end(void) const
+   {
+      return
+         { };
+   }
+
+private:
+   V1
+      range1_;
+   
+   V2
+      range2_;
+   
+   Comparison
+      comparison_;
+}
+;
+
+template <typename R1, typename R2, typename Comparison = ::std::ranges::less>
+union_view(R1 &&, R2 &&, Comparison = { })
+   ->
+      union_view
+         <
+         ::std::views::all_t<R1>,
+         ::std::views::all_t<R2>,
+         Comparison
+         >
+         ;
+
+}
+
+//
+// A sorted list of distinct random integers in [0, universe):
+//
+
+::std::vector<int>
+make_posting_list
+   (
+   ::std::size_t size,
+   int universe,
+   ::std::mt19937 & generator
+   )
+{
+   ::std::uniform_int_distribution<int>
+      distribution( 0, universe - 1 );
+   
+   ::std::vector<int>
+      list( size );
+   
+   for( auto & element : list )
+   {
+      element = distribution( generator );
+   }
+   
+   ::std::ranges::sort( list );
+   
+   list.erase( ::std::ranges::unique( list ).begin(), list.end() );
+   
+   return
+      list;
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<int> const
+      first { 1, 3, 4, 7, 9, 12, 15, 21, 22, 30 },
+      second { 3, 9, 10, 21, 40 },
+      third { 2, 3, 9, 21 };
+   
+   ::std::vector<int>
+      intersection;
+   
+   galloping::set_intersection( first, second, ::std::back_inserter( intersection ) );
+   
+   assert( ( intersection == ::std::vector<int> { 3, 9, 21 } ) );
+   
+   ::std::vector<int>
+      union_;
+   
+   galloping::set_union( first, second, ::std::back_inserter( union_ ) );
+   
+   assert( ::std::ranges::is_sorted( union_ ) and union_.size() == 12u );
+   
+   //
+   // Multi-way intersection:
+   //
+   
+   auto const
+      common =
+         galloping::set_intersection <int>
+            (
+            { first, second, third }
+            )
+            ;
+   
+   assert( ( common == ::std::vector<int> { 3, 9, 21 } ) );
+   
+   //
+   // Lazy views:
+   //
+   
+   for( int v : galloping::intersection_view( first, second ) )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   assert
+      (
+      ::std::ranges::equal( galloping::union_view( first, second ), union_ )
+      )
+      ;
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark intersections and unions of lists with
+   // different size ratios, into a vector and through the
+   // lazy views. The size of the larger list can be passed
+   // as the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 4'000'000u
+               ;
+   
+   ::std::mt19937
+      generator( 42u );
+   
+   //
+   // Both lists are drawn from the same universe, so that
+   // the smaller list spans the whole of the larger list:
+   //
+   
+   int const
+      universe = static_cast<int>( size * 4u ) + 4;
+   
+   auto const
+      large = make_posting_list( size, universe, generator );
+   
+   for( ::std::size_t ratio : { 1u, 10u, 100u, 1'000u, 10'000u } )
+   {
+      auto const
+         small = make_posting_list( size / ratio, universe, generator );
+      
+      ::std::vector<int>
+         expected,
+         result,
+         lazy;
+      
+      //
+      // Times an operation which writes to the beginning of
+      // output and returns the end of what it wrote. Output
+      // is sized to size elements, and its pages touched,
+      // before the clock starts, then trimmed. The fastest
+      // of a few repetitions is reported, to keep scheduler
+      // noise out of the comparison:
+      //
+      
+      auto const
+         timed =
+            [] (::std::vector<int> & output, ::std::size_t size, auto operation)
+            {
+               auto
+                  time = ::std::numeric_limits<double>::infinity();
+               
+               for( int repetition = 0; repetition < 5; ++repetition )
+               {
+                  output.assign( size, 0 );
+                  
+                  auto
+                     end = output.begin();
+                  
+                  time =
+                     ::std::min
+                        (
+                        time,
+                        milliseconds
+                           (
+                           [&]
+                           {
+                              end = operation( output.begin() );
+                           }
+                           )
+                        )
+                        ;
+                  
+                  output.erase( end, output.end() );
+               }
+               
+               return
+                  time;
+            }
+            ;
+      
+      auto const
+         standard_intersection_time =
+            timed
+               (
+               expected,
+               small.size(),
+               [&] (auto output)
+               {
+                  return
+                     ::std::ranges::set_intersection( small, large, output ).out;
+               }
+               )
+               ;
+      
+      auto const
+         galloping_intersection_time =
+            timed
+               (
+               result,
+               small.size(),
+               [&] (auto output)
+               {
+                  return
+                     galloping::set_intersection( small, large, output );
+               }
+               )
+               ;
+      
+      auto const
+         lazy_intersection_time =
+            timed
+               (
+               lazy,
+               small.size(),
+               [&] (auto output)
+               {
+                  return
+                     ::std::ranges::copy( galloping::intersection_view( small, large ), output ).out;
+               }
+               )
+               ;
+      
+      assert( result == expected and lazy == expected );
+      
+      auto const
+         standard_union_time =
+            timed
+               (
+               expected,
+               small.size() + large.size(),
+               [&] (auto output)
+               {
+                  return
+                     ::std::ranges::set_union( small, large, output ).out;
+               }
+               )
+               ;
+      
+      auto const
+         galloping_union_time =
+            timed
+               (
+               result,
+               small.size() + large.size(),
+               [&] (auto output)
+               {
+                  return
+                     galloping::set_union( small, large, output );
+               }
+               )
+               ;
+      
+      auto const
+         lazy_union_time =
+            timed
+               (
+               lazy,
+               small.size() + large.size(),
+               [&] (auto output)
+               {
+                  return
+                     ::std::ranges::copy( galloping::union_view( small, large ), output ).out;
+               }
+               )
+               ;
+      
+      assert( result == expected and lazy == expected );
+      
+      ::std::cout << "1:"
+                  << ratio
+                  << " ("
+                  << small.size()
+                  << " x "
+                  << large.size()
+                  << "):\n   intersection: std "
+                  << standard_intersection_time
+                  << " ms, galloping "
+                  << galloping_intersection_time
+                  << " ms, intersection_view "
+                  << lazy_intersection_time
+                  << " ms\n   union: std "
+                  << standard_union_time
+                  << " ms, galloping "
+                  << galloping_union_time
+                  << " ms, union_view "
+                  << lazy_union_time
+                  << " ms"
+                  << ::std::endl
+                     ;
+   }
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,931 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// A "group by" computes one or more aggregates (a sum, a
+// count, a minimum...) for every distinct key of a range.
+// The obvious implementation, a
+// ::std::unordered_map<Key, Accumulators>, allocates a node
+// for every group and follows a pointer for every lookup.
+//
+// group_aggregate stores the groups densely, in insertion
+// order, in a vector of (key, accumulators) pairs, and finds
+// them with an open-addressing hash table of 32-bit indices
+// and 32-bit hash tags. Most lookups touch one slot of the
+// table and one group, and the tag avoids comparing keys
+// which only share a slot.
+//
+// An aggregator describes one aggregate with three
+// functions: initial(element) returns the accumulator for
+// the first element of a group, add(accumulator, element)
+// adds another element, and merge(accumulator, other)
+// combines two accumulators of the same group. The last one
+// allows parallel_group_aggregate to aggregate parts of a
+// range independently.
+//
+
+struct Person final
+{
+   ::std::string
+      id_;
+   
+   double
+      salary_;
+}
+;
+
+namespace aggregate
+{
+
+template <typename Projection = ::std::identity>
+struct sum final
+{
+   Projection
+      projection;
+   
+   template <typename Element>
+   auto
+      initial(Element const & element) const
+   {
+      return
+         ::std::invoke( projection, element );
+   }
+   
+   template <typename Accumulator, typename Element>
+   void
+      add(Accumulator & accumulator, Element const & element) const
+   {
+      accumulator += ::std::invoke( projection, element );
+   }
+   
+   template <typename Accumulator>
+   void
+      merge(Accumulator & accumulator, Accumulator const & other) const
+   {
+      accumulator += other;
+   }
+}
+;
+
+template <typename Projection>
+sum(Projection) -> sum<Projection>;
+
+struct count final
+{
+   template <typename Element>
+   ::std::size_t
+      initial(Element const &) const
+   {
+      return
+         1u;
+   }
+   
+   template <typename Element>
+   void
+      add(::std::size_t & accumulator, Element const &) const
+   {
+      ++accumulator;
+   }
+   
+   void
+      merge(::std::size_t & accumulator, ::std::size_t other) const
+   {
+      accumulator += other;
+   }
+}
+;
+
+template <typename Projection = ::std::identity>
+struct min final
+{
+   Projection
+      projection;
+   
+   template <typename Element>
+   auto
+      initial(Element const & element) const
+   {
+      return
+         ::std::invoke( projection, element );
+   }
+   
+   template <typename Accumulator, typename Element>
+   void
+      add(Accumulator & accumulator, Element const & element) const
+   {
+      accumulator = ::std::min <Accumulator> ( accumulator, ::std::invoke( projection, element ) );
+   }
+   
+   template <typename Accumulator>
+   void
+      merge(Accumulator & accumulator, Accumulator const & other) const
+   {
+      accumulator = ::std::min( accumulator, other );
+   }
+}
+;
+
+template <typename Projection>
+min(Projection) -> min<Projection>;
+
+template <typename Projection = ::std::identity>
+struct max final
+{
+   Projection
+      projection;
+   
+   template <typename Element>
+   auto
+      initial(Element const & element) const
+   {
+      return
+         ::std::invoke( projection, element );
+   }
+   
+   template <typename Accumulator, typename Element>
+   void
+      add(Accumulator & accumulator, Element const & element) const
+   {
+      accumulator = ::std::max <Accumulator> ( accumulator, ::std::invoke( projection, element ) );
+   }
+   
+   template <typename Accumulator>
+   void
+      merge(Accumulator & accumulator, Accumulator const & other) const
+   {
+      accumulator = ::std::max( accumulator, other );
+   }
+}
+;
+
+template <typename Projection>
+max(Projection) -> max<Projection>;
+
+}
+
+template <typename A, typename Element>
+concept Aggregator =
+   requires (A const aggregator, Element const & element)
+   {
+      { aggregator.initial( element ) } -> ::std::movable;
+   }
+   and
+   requires
+      (
+      A const aggregator,
+      Element const & element,
+      decltype( ::std::declval<A const &>().initial( element ) ) & accumulator
+      )
+   {
+      aggregator.add( accumulator, element );
+      aggregator.merge( accumulator, accumulator );
+   }
+   ;
+
+template <typename A, typename Element>
+using accumulator_t =
+   ::std::remove_cvref_t
+      <
+      decltype( ::std::declval<A const &>().initial( ::std::declval<Element const &>() ) )
+      >
+      ;
+
+namespace ranges
+{
+
+//
+// A 64-bit finalizer, so that weak hashes (::std::hash of
+// an integer is the identity in libstdc++) spread over the
+// whole table:
+//
+
+constexpr ::std::uint64_t
+mix(::std::uint64_t hash)
+{
+   hash ^= hash >> 33u;
+   
+   hash *= 0xff51afd7ed558ccdull;
+   
+   hash ^= hash >> 33u;
+   
+   hash *= 0xc4ceb3f97b3da3b5ull;
+   
+   hash ^= hash >> 33u;
+   
+   return
+      hash;
+}
+
+template <typename Key, typename ... Accumulators>
+class group_table final
+{
+public:
+   using
+      group_type = ::std::pair< Key, ::std::tuple<Accumulators...> >;
+   
+   group_table(void)
+      : slots_( 16u )
+   {
+   }
+   
+   //
+   // Returns the accumulators of the group with the given
+   // key, and whether the group was inserted; the
+   // accumulators of an inserted group are made by make():
+   //
+   
+   template <typename K, typename Make>
+   ::std::pair< ::std::tuple<Accumulators...> *, bool >
+      find_or_insert(::std::uint64_t hash, K && key, Make && make)
+   {
+      auto const
+         tag = static_cast<::std::uint32_t>( hash >> 32u );
+      
+      auto const
+         mask = slots_.size() - 1u;
+      
+      for( auto position = hash & mask; ; position = ( position + 1u ) & mask )
+      {
+         auto &
+            slot = slots_[position];
+         
+         if( slot.index == 0u )
+         {
+            groups_.emplace_back( ::std::forward<K>( key ), make() );
+            
+            hashes_.push_back( hash );
+            
+            slot = { static_cast<::std::uint32_t>( groups_.size() ), tag };
+            
+            //
+            // Keep the load factor at most 1 / 2, so that
+            // linear probing stays short:
+            //
+            
+            if( 2u * groups_.size() > slots_.size() )
+            {
+               this->grow();
+               
+               return
+                  { &groups_.back().second, true };
+            }
+            
+            return
+               { &groups_[ slot.index - 1u ].second, true };
+         }
+         
+         if( slot.tag == tag and groups_[ slot.index - 1u ].first == key )
+         {
+            return
+               { &groups_[ slot.index - 1u ].second, false };
+         }
+      }
+   }
+   
+   ::std::vector<group_type> &
+      groups(void)
+   {
+      return
+         groups_;
+   }
+   
+   ::std::vector<::std::uint64_t> const &
+      hashes(void) const
+   {
+      return
+         hashes_;
+   }
+
+private:
+   struct slot final
+   {
+      //
+      // The index of the group, plus one; zero is an empty
+      // slot:
+      //
+      
+      ::std::uint32_t
+         index = 0u;
+      
+      ::std::uint32_t
+         tag = 0u;
+   }
+   ;
+   
+   void
+      grow(void)
+   {
+      slots_.assign( 2u * slots_.size(), slot { } );
+      
+      auto const
+         mask = slots_.size() - 1u;
+      
+      for( ::std::size_t index = 0; index < groups_.size(); ++index )
+      {
+         auto
+            position = hashes_[index] & mask;
+         
+         while( slots_[position].index != 0u )
+         {
+            position = ( position + 1u ) & mask;
+         }
+         
+         slots_[position] =
+            {
+            static_cast<::std::uint32_t>( index + 1u ),
+            static_cast<::std::uint32_t>( hashes_[index] >> 32u )
+            }
+            ;
+      }
+   }
+   
+   ::std::vector<slot>
+      slots_;
+   
+   ::std::vector<group_type>
+      groups_;
+   
+   ::std::vector<::std::uint64_t>
+      hashes_;
+}
+;
+
+template <typename R, typename KeyProjection, typename ... Aggregators>
+using group_table_for =
+   group_table
+      <
+      ::std::remove_cvref_t
+         <
+         ::std::invoke_result_t< KeyProjection &, ::std::ranges::range_reference_t<R> >
+         >,
+      accumulator_t< Aggregators, ::std::ranges::range_value_t<R> > ...
+      >
+      ;
+
+template <typename Element, typename ... Aggregators>
+void
+add_to_group
+   (
+   ::std::tuple<Aggregators...> const & aggregators,
+   ::std::tuple< accumulator_t<Aggregators, Element> ... > & accumulators,
+   Element const & element
+   )
+{
+   [&] <::std::size_t ... Index> (::std::index_sequence<Index...>)
+   {
+      ( ::std::get<Index>( aggregators ).add( ::std::get<Index>( accumulators ), element ), ... );
+   }
+   ( ::std::index_sequence_for<Aggregators...> { } );
+}
+
+//
+// Aggregates one element into a table; hash is the mixed
+// hash of its key:
+//
+
+template <typename Table, typename Key, typename Element, typename ... Aggregators>
+void
+aggregate_into
+   (
+   Table & table,
+   ::std::uint64_t hash,
+   Key && key,
+   Element const & element,
+   ::std::tuple<Aggregators...> const & aggregators
+   )
+{
+   auto const
+      [ accumulators, inserted ] =
+         table.find_or_insert
+            (
+            hash,
+            ::std::forward<Key>( key ),
+            [&]
+            {
+               return
+                  ::std::apply
+                     (
+                     [&] (auto const & ... aggregator)
+                     {
+                        return
+                           ::std::tuple { aggregator.initial( element ) ... };
+                     }
+                     ,
+                     aggregators
+                     )
+                     ;
+            }
+            )
+            ;
+   
+   if( not inserted )
+   {
+      add_to_group( aggregators, *accumulators, element );
+   }
+}
+
+template
+   <
+   ::std::ranges::input_range R,
+   typename KeyProjection,
+   typename ... Aggregators
+   >
+   requires
+      (
+      ::std::regular_invocable< KeyProjection &, ::std::ranges::range_reference_t<R> >
+      
+      and
+      
+      ( Aggregator< Aggregators, ::std::ranges::range_value_t<R> > and ... )
+      )
+auto
+group_aggregate(R && range, KeyProjection key_projection, Aggregators ... aggregators)
+{
+   using
+      Table = group_table_for<R, KeyProjection, Aggregators...>;
+   
+   using
+      Key = typename Table::group_type::first_type;
+   
+   auto const
+      all = ::std::tuple { aggregators... };
+   
+   Table
+      table;
+   
+   ::std::hash<Key> const
+      hasher;
+   
+   for( auto && element : range )
+   {
+      decltype(auto)
+         key = ::std::invoke( key_projection, element );
+      
+      aggregate_into
+         (
+         table, mix( hasher( key ) ), ::std::forward<decltype(key)>( key ), element, all
+         )
+         ;
+   }
+   
+   return
+      ::std::move( table.groups() );
+}
+
+//
+// The parallel version splits the range between threads.
+// Every thread aggregates its part into one table per
+// partition of the hash values, so that the tables of a
+// partition, from all the threads, only contain the keys of
+// that partition. Then every thread merges the tables of
+// one partition, without any synchronisation, and the
+// merged partitions are concatenated.
+//
+
+template
+   <
+   ::std::ranges::random_access_range R,
+   typename KeyProjection,
+   typename ... Aggregators
+   >
+   requires
+      (
+      ::std::ranges::sized_range<R>
+      
+      and
+      
+      ::std::regular_invocable< KeyProjection &, ::std::ranges::range_reference_t<R> >
+      
+      and
+      
+      ( Aggregator< Aggregators, ::std::ranges::range_value_t<R> > and ... )
+      )
+auto
+parallel_group_aggregate(R && range, KeyProjection key_projection, Aggregators ... aggregators)
+{
+   using
+      Table = group_table_for<R, KeyProjection, Aggregators...>;
+   
+   using
+      Key = typename Table::group_type::first_type;
+   
+   auto const
+      all = ::std::tuple { aggregators... };
+   
+   auto const
+      threads = ::std::max( ::std::thread::hardware_concurrency(), 1u );
+   
+   auto const
+      size = ::std::ranges::size( range );
+   
+   auto const
+      part = ( size + threads - 1u ) / threads;
+   
+   //
+   // The partition of a hash is taken from its high bits,
+   // as the low bits choose the slot in the tables:
+   //
+   
+   auto const
+      partition_of =
+         [threads] (::std::uint64_t hash)
+         {
+            return
+               static_cast<::std::size_t>( ( ( hash >> 32u ) * threads ) >> 32u );
+         }
+         ;
+   
+   ::std::vector< ::std::vector<Table> >
+      local( threads, ::std::vector<Table>( threads ) );
+   
+   {
+   
+   ::std::vector<::std::jthread>
+      workers;
+   
+   for( unsigned thread = 0; thread < threads; ++thread )
+   {
+      workers.emplace_back
+         (
+         [&, thread]
+         {
+            ::std::hash<Key> const
+               hasher;
+            
+            auto const
+               begin = ::std::min <::std::size_t> ( size, thread * part ),
+               end = ::std::min <::std::size_t> ( size, begin + part );
+            
+            for( auto index = begin; index < end; ++index )
+            {
+               auto &&
+                  element = ::std::ranges::begin( range )[index];
+               
+               decltype(auto)
+                  key = ::std::invoke( key_projection, element );
+               
+               auto const
+                  hash = mix( hasher( key ) );
+               
+               aggregate_into
+                  (
+                  local[thread][ partition_of( hash ) ],
+                  hash,
+                  ::std::forward<decltype(key)>( key ),
+                  element,
+                  all
+                  )
+                  ;
+            }
+         }
+         )
+         ;
+   }
+   
+   }
+   
+   ::std::vector<Table>
+      merged( threads );
+   
+   {
+   
+   ::std::vector<::std::jthread>
+      workers;
+   
+   for( unsigned partition = 0; partition < threads; ++partition )
+   {
+      workers.emplace_back
+         (
+         [&, partition]
+         {
+            auto &
+               table = merged[partition];
+            
+            for( auto & tables : local )
+            {
+               auto &
+                  source = tables[partition];
+               
+               for( ::std::size_t index = 0; index < source.groups().size(); ++index )
+               {
+                  auto &
+                     [ key, accumulators ] = source.groups()[index];
+                  
+                  auto const
+                     [ target, inserted ] =
+                        table.find_or_insert
+                           (
+                           source.hashes()[index],
+                           ::std::move( key ),
+                           [&] { return accumulators; }
+                           )
+                           ;
+                  
+                  if( not inserted )
+                  {
+                     [&] <::std::size_t ... Index> (::std::index_sequence<Index...>)
+                     {
+                        (
+                        ::std::get<Index>( all ).merge
+                           (
+                           ::std::get<Index>( *target ),
+                           ::std::get<Index>( accumulators )
+                           ),
+                        ...
+                        )
+                        ;
+                     }
+                     ( ::std::index_sequence_for<Aggregators...> { } );
+                  }
+               }
+            }
+         }
+         )
+         ;
+   }
+   
+   }
+   
+   auto
+      groups = ::std::move( merged[0].groups() );
+   
+   for( unsigned partition = 1; partition < threads; ++partition )
+   {
+      auto &
+         more = merged[partition].groups();
+      
+      groups.insert
+         (
+         groups.end(),
+         ::std::make_move_iterator( more.begin() ),
+         ::std::make_move_iterator( more.end() )
+         )
+         ;
+   }
+   
+   return
+      groups;
+}
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<Person> const
+      payments
+         {
+         { "ann", 10. },
+         { "bob", 20. },
+         { "ann", 30. },
+         { "cid", 5. },
+         { "bob", 1. }
+         }
+         ;
+   
+   for
+      (
+      auto const & [ id, accumulators ]
+         :
+      ranges::group_aggregate
+         (
+         payments,
+         &Person::id_,
+         aggregate::sum { &Person::salary_ },
+         aggregate::count { },
+         aggregate::max { &Person::salary_ }
+         )
+      )
+   {
+      auto const &
+         [ total, count, highest ] = accumulators;
+      
+      ::std::cout << id
+                  << ": total "
+                  << total
+                  << ", count "
+                  << count
+                  << ", max "
+                  << highest
+                  << ::std::endl
+                     ;
+   }
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark the sum and the count of salaries by id. The
+   // number of records and the number of distinct ids can
+   // be passed as the first and second command-line
+   // arguments:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 5'000'000u
+               ,
+      distinct =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 100'000u
+               ;
+   
+   ::std::mt19937_64
+      generator( 42u );
+   
+   ::std::uniform_int_distribution<::std::size_t>
+      ids( 0u, distinct - 1u );
+   
+   ::std::uniform_real_distribution<double>
+      salaries( 1000., 10000. );
+   
+   ::std::vector<Person>
+      records( size );
+   
+   for( auto & record : records )
+   {
+      record.id_ = "id" + ::std::to_string( ids( generator ) );
+      
+      record.salary_ = ::std::round( salaries( generator ) );
+   }
+   
+   using
+      Groups = decltype
+         (
+         ranges::group_aggregate
+            (
+            records, &Person::id_, aggregate::sum { &Person::salary_ }, aggregate::count { }
+            )
+         )
+         ;
+   
+   Groups
+      groups,
+      parallel;
+   
+   ::std::unordered_map< ::std::string, ::std::pair<double, ::std::size_t> >
+      map;
+   
+   auto const
+      group_time =
+         milliseconds
+            (
+            [&]
+            {
+               groups =
+                  ranges::group_aggregate
+                     (
+                     records,
+                     &Person::id_,
+                     aggregate::sum { &Person::salary_ },
+                     aggregate::count { }
+                     )
+                     ;
+            }
+            )
+            ;
+   
+   auto const
+      parallel_time =
+         milliseconds
+            (
+            [&]
+            {
+               parallel =
+                  ranges::parallel_group_aggregate
+                     (
+                     records,
+                     &Person::id_,
+                     aggregate::sum { &Person::salary_ },
+                     aggregate::count { }
+                     )
+                     ;
+            }
+            )
+            ;
+   
+   auto const
+      map_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( auto const & record : records )
+               {
+                  auto &
+                     [ total, count ] = map[ record.id_ ];
+                  
+                  total += record.salary_;
+                  
+                  ++count;
+               }
+            }
+            )
+            ;
+   
+   //
+   // The salaries are whole numbers, so the sums are exact
+   // whatever the order of the additions:
+   //
+   
+   assert( groups.size() == map.size() and parallel.size() == map.size() );
+   
+   for( auto const & [ id, accumulators ] : groups )
+   {
+      assert( ( map.at( id ) == ::std::pair { ::std::get<0>( accumulators ), ::std::get<1>( accumulators ) } ) );
+   }
+   
+   for( auto const & [ id, accumulators ] : parallel )
+   {
+      assert( ( map.at( id ) == ::std::pair { ::std::get<0>( accumulators ), ::std::get<1>( accumulators ) } ) );
+   }
+   
+   ::std::cout << "sum and count of "
+               << size
+               << " salaries by "
+               << groups.size()
+               << " ids:"
+               << ::std::endl
+               << "   group_aggregate:          "
+               << group_time
+               << " ms"
+               << ::std::endl
+               << "   parallel_group_aggregate: "
+               << parallel_time
+               << " ms"
+               << ::std::endl
+               << "   unordered_map:            "
+               << map_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
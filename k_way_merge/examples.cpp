@@ -0,0 +1,1323 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <array>
+#include <list>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <queue>
+#include <string>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// Merging K sorted ranges by repeatedly scanning the K
+// current elements for the smallest one costs K - 1
+// comparisons per element. A binary heap
+// (::std::priority_queue) costs between log K and 2 log K
+// comparisons per element, to pop the smallest element and
+// to push its successor. A "loser tree" (or tournament tree)
+// costs exactly log K comparisons per element, on a path
+// that only depends on the range the element came from.
+//
+// A loser tree is a complete binary tree with one leaf per
+// input range. Every internal node stores the range which
+// lost the comparison ("match") played at that node, and
+// the overall winner is stored separately. After the winner
+// has produced its element and advanced, only the matches
+// on the path from its leaf to the root need to be
+// replayed, against the losers stored on that path.
+//
+// merge_view lazily merges K sorted ranges with a loser
+// tree. Like ::std::ranges::sort, it accepts a comparison
+// and a projection. The merge is stable: equivalent
+// elements are produced in the order of the ranges that
+// they come from.
+//
+
+struct Person final
+{
+   ::std::string
+      id_;
+   
+   double
+      salary_;
+}
+;
+
+namespace k_way
+{
+
+template
+   <
+   ::std::ranges::view V,
+   typename Comparison = ::std::ranges::less,
+   typename Projection = ::std::identity
+   >
+   requires
+      ::std::ranges::input_range<V>
+      
+      and
+      
+      ::std::indirect_strict_weak_order
+         <
+         Comparison,
+         ::std::projected< ::std::ranges::iterator_t<V const>, Projection >
+         >
+class merge_view
+   : public ::std::ranges::view_interface
+      <
+      merge_view<V, Comparison, Projection>
+      >
+{
+public:
+   merge_view(void) = default;
+   
+   explicit merge_view
+      (
+      ::std::vector<V> ranges,
+      Comparison comparison = { },
+      Projection projection = { }
+      )
+      :
+      ranges_( ::std::move( ranges ) ),
+      comparison_( ::std::move( comparison ) ),
+      projection_( ::std::move( projection ) )
+   { }
+   
+   //
+   // The merge state (the current position in every range
+   // and the loser tree) lives in the iterator, so the
+   // iterator is an input iterator: it can be copied, but
+   // only one copy may be incremented.
+   //
+   
+   class iterator
+   {
+   public:
+      using
+         iterator_concept = ::std::input_iterator_tag;
+      
+      using
+         value_type = ::std::ranges::range_value_t<V const>;
+      
+      using
+         difference_type = ::std::ptrdiff_t;
+      
+      iterator(void) = default;
+      
+      explicit iterator(merge_view const & parent)
+         : parent_( &parent )
+      {
+         auto const
+            count = parent.ranges_.size();
+         
+         positions_.reserve( count );
+         
+         ends_.reserve( count );
+         
+         for( auto const & range : parent.ranges_ )
+         {
+            positions_.push_back( ::std::ranges::begin( range ) );
+            
+            ends_.push_back( ::std::ranges::end( range ) );
+         }
+         
+         //
+         // The number of leaves is rounded up to a power of
+         // two. The extra leaves are permanently exhausted:
+         //
+         
+         leaves_ = ::std::bit_ceil( ::std::max <::std::size_t> ( count, 1u ) );
+         
+         tree_.resize( leaves_ );
+         
+         winner_ = this->build( 1u );
+      }
+      
+      decltype(auto)
+         operator* (void) const
+      {
+         return
+            *positions_[ rank( winner_ ) ];
+      }
+      
+      iterator &
+         operator++ (void)
+      {
+         auto const
+            leaf = rank( winner_ );
+         
+         ++positions_[leaf];
+         
+         auto
+            winner = this->load( leaf );
+         
+         //
+         // Replay the matches on the path from the winner's
+         // leaf to the root. Every node holds the key of its
+         // loser, so a match reads the node and compares two
+         // keys already in registers, and never dereferences
+         // the iterators of the ranges:
+         //
+         
+         for( auto node = ( leaf + leaves_ ) / 2u; node != 0u; node /= 2u )
+         {
+            auto const
+               loser = tree_[node];
+            
+            if constexpr ( packed )
+            {
+               //
+               // The outcome of a match is unpredictable, so
+               // the winner is selected rather than branched
+               // on, and the node is always written, with the
+               // other word of the two:
+               //
+               
+               auto const
+                  smaller = ::std::min( loser, winner );
+               
+               tree_[node] = loser ^ winner ^ smaller;
+               
+               winner = smaller;
+            }
+            else if( this->beats( loser, winner ) )
+            {
+               tree_[node] = winner;
+               
+               winner = loser;
+            }
+         }
+         
+         winner_ = winner;
+         
+         return
+            *this;
+      }
+      
+      void
+         operator++ (int)
+      {
+         ++*this;
+      }
+      
+      bool
+         operator== (::std::default_sentinel_t) const
+      {
+         return
+            ( rank( winner_ ) & exhausted ) != 0u;
+      }
+   
+   private:
+      //
+      // Every node of the tree holds the key of the current
+      // element of its loser, next to the rank of the loser,
+      // so that a match never dereferences the iterators of
+      // the ranges. Small, trivially copyable keys (such as
+      // integers) are copied; other keys are stored by
+      // address, unless the projection returns them by value:
+      //
+      
+      using
+         key_reference =
+            ::std::indirect_result_t
+               <
+               Projection const &,
+               ::std::ranges::iterator_t<V const>
+               >
+               ;
+      
+      using
+         key_type = ::std::remove_cvref_t<key_reference>;
+      
+      static constexpr bool
+         cache_by_value =
+            (
+               ::std::is_trivially_copyable_v<key_type>
+               
+               and
+               
+               sizeof(key_type) <= 2u * sizeof(void *)
+            )
+            
+            or
+            
+            not ::std::is_lvalue_reference_v<key_reference>
+               ;
+      
+      using
+         cached_key =
+            ::std::conditional_t
+               <
+               cache_by_value,
+               key_type,
+               key_type const *
+               >
+               ;
+      
+      //
+      // The rank of an entry is the leaf of its range, with
+      // the top bit set once the range is exhausted, so that
+      // exhausted ranges rank after every other range:
+      //
+      
+      static constexpr ::std::uint32_t
+         exhausted = ::std::uint32_t { 1u } << 31u;
+      
+      //
+      // Integer keys of up to 32 bits, ordered by
+      // ranges::less or ranges::greater, are packed with the
+      // rank into one 64-bit word, the key in the high half
+      // mapped so that unsigned order is the order of the
+      // comparison. Words then order as the matches do: by
+      // key, and ties by rank. An exhausted range has the
+      // largest key, a sentinel which loses every match, even
+      // against an equal key, because of its rank. A match is
+      // a single unsigned comparison, and its winner and loser
+      // are the minimum and the maximum of the two words:
+      //
+      
+      static constexpr bool
+         packed =
+            ::std::integral<key_type>
+            
+            and
+            
+            sizeof(key_type) <= sizeof(::std::uint32_t)
+            
+            and
+            
+            (
+               ::std::same_as<Comparison, ::std::ranges::less>
+               
+               or
+               
+               ::std::same_as<Comparison, ::std::ranges::greater>
+            )
+            ;
+      
+      struct keyed
+      {
+         cached_key
+            key { };
+         
+         ::std::uint32_t
+            rank = exhausted;
+      }
+      ;
+      
+      using
+         entry = ::std::conditional_t<packed, ::std::uint64_t, keyed>;
+      
+      static ::std::uint32_t
+         rank(entry const & from) noexcept
+      {
+         if constexpr ( packed )
+         {
+            return
+               static_cast<::std::uint32_t>( from );
+         }
+         else
+         {
+            return
+               from.rank;
+         }
+      }
+      
+      static entry
+         exhausted_entry(::std::uint32_t leaf) noexcept
+      {
+         if constexpr ( packed )
+         {
+            return
+               ::std::uint64_t { 0xFFFF'FFFFu } << 32u | ( leaf | exhausted );
+         }
+         else
+         {
+            return
+               { { }, leaf | exhausted };
+         }
+      }
+      
+      //
+      // The entry of the current element of range leaf:
+      //
+      
+      entry
+         load(::std::uint32_t leaf) const
+      {
+         if( positions_[leaf] == ends_[leaf] )
+         {
+            return
+               exhausted_entry( leaf );
+         }
+         
+         if constexpr ( packed )
+         {
+            using
+               unsigned_key = ::std::make_unsigned_t<key_type>;
+            
+            auto
+               bits =
+                  static_cast<::std::uint32_t>
+                     (
+                     static_cast<unsigned_key>( ::std::invoke( parent_->projection_, *positions_[leaf] ) )
+                     )
+                     ;
+            
+            //
+            // Flip the sign bit of signed keys, so that
+            // negative keys come first, and all of the bits
+            // of keys ordered by ranges::greater:
+            //
+            
+            if constexpr ( ::std::is_signed_v<key_type> )
+            {
+               bits ^= ::std::uint32_t { 1u } << ( 8u * sizeof(key_type) - 1u );
+            }
+            
+            if constexpr ( ::std::same_as<Comparison, ::std::ranges::greater> )
+            {
+               bits = ~bits;
+            }
+            
+            return
+               ::std::uint64_t { bits } << 32u | leaf;
+         }
+         else if constexpr ( cache_by_value )
+         {
+            return
+               { ::std::invoke( parent_->projection_, *positions_[leaf] ), leaf };
+         }
+         else
+         {
+            return
+               { &::std::invoke( parent_->projection_, *positions_[leaf] ), leaf };
+         }
+      }
+      
+      static decltype(auto)
+         key(keyed const & from)
+      {
+         if constexpr ( cache_by_value )
+         {
+            return
+               ( from.key );
+         }
+         else
+         {
+            return
+               ( *from.key );
+         }
+      }
+      
+      //
+      // True if the element of entry first should be produced
+      // before that of entry second. Ties are won by the
+      // earlier range, so that the merge is stable. Because of
+      // the tie rule, a match costs a single comparison: the
+      // earlier range wins unless the later one is strictly
+      // smaller, so the later range is always passed as the
+      // left-hand argument. Exhausted ranges are later than
+      // every other range, and never win:
+      //
+      
+      bool
+         beats(entry const & first, entry const & second) const
+      {
+         if constexpr ( packed )
+         {
+            return
+               first < second;
+         }
+         else
+         {
+            if constexpr ( not cache_by_value )
+            {
+               //
+               // The key of an exhausted range is a null
+               // pointer, which cannot be compared:
+               //
+               
+               if( ( ( first.rank | second.rank ) & exhausted ) != 0u )
+               {
+                  return
+                     first.rank < second.rank;
+               }
+            }
+            
+            bool const
+               earlier = first.rank < second.rank;
+            
+            //
+            // If either range is exhausted, the later one is:
+            //
+            
+            bool const
+               later_exhausted = ( ( first.rank | second.rank ) & exhausted ) != 0u;
+            
+            bool const
+               later_is_less =
+                  ::std::invoke
+                     (
+                     parent_->comparison_,
+                     key( earlier ? second : first ),
+                     key( earlier ? first : second )
+                     )
+                     ;
+            
+            return
+               ( later_is_less and not later_exhausted ) != earlier;
+         }
+      }
+      
+      //
+      // Plays the matches in the subtree rooted at index,
+      // stores the losers and returns the winner:
+      //
+      
+      entry
+         build(::std::size_t index)
+      {
+         if( index >= leaves_ )
+         {
+            auto const
+               leaf = static_cast<::std::uint32_t>( index - leaves_ );
+            
+            return
+               leaf < positions_.size()
+                  ? this->load( leaf )
+                  : exhausted_entry( leaf )
+                     ;
+         }
+         
+         auto
+            left = this->build( 2u * index ),
+            right = this->build( 2u * index + 1u );
+         
+         if( this->beats( right, left ) )
+         {
+            ::std::swap( left, right );
+         }
+         
+         tree_[index] = right;
+         
+         return
+            left;
+      }
+      
+      merge_view const *
+         parent_ = nullptr;
+      
+      ::std::vector< ::std::ranges::iterator_t<V const> >
+         positions_;
+      
+      ::std::vector< ::std::ranges::sentinel_t<V const> >
+         ends_;
+      
+      ::std::size_t
+         leaves_ = 0u;
+      
+      //
+      // tree_[0] is unused: the overall winner is stored in
+      // winner_.
+      //
+      
+      ::std::vector<entry>
+         tree_;
+      
+      entry
+         winner_ = exhausted_entry( 0u );
+   }
+   ;
+   
+   iterator
+      begin(void) const
+   {
+      return
+         iterator( *this );
+   }
+   
+   ::std::default_sentinel_t
+      end(void) const
+   {
+      return
+         { };
+   }
+
+private:
+   ::std::vector<V>
+      ranges_;
+   
+   Comparison
+      comparison_;
+   
+   Projection
+      projection_;
+}
+;
+
+//
+// Merges a run-time number of ranges, stored in a vector:
+//
+
+template
+   <
+   ::std::ranges::viewable_range R,
+   typename Comparison = ::std::ranges::less,
+   typename Projection = ::std::identity
+   >
+auto
+merge_all
+   (
+   ::std::vector<R> & ranges,
+   Comparison comparison = { },
+   Projection projection = { }
+   )
+{
+   using
+      View = ::std::views::all_t<R &>;
+   
+   ::std::vector<View>
+      views;
+   
+   views.reserve( ranges.size() );
+   
+   for( auto & range : ranges )
+   {
+      views.push_back( ::std::views::all( range ) );
+   }
+   
+   return
+      merge_view<View, Comparison, Projection>
+         (
+         ::std::move( views ),
+         ::std::move( comparison ),
+         ::std::move( projection )
+         )
+         ;
+}
+
+//
+// An input view over any view whose elements convert to
+// Reference, behind a virtual interface. merge_view stores
+// its ranges in one vector, so ranges of different types
+// are merged through erased_view. Every element then costs
+// two virtual calls and a test for the end, so views of the
+// same type are merged directly:
+//
+
+template <typename Reference>
+class erased_view
+   : public ::std::ranges::view_interface< erased_view<Reference> >
+{
+   struct cursor
+   {
+      virtual
+         ~cursor(void) = default;
+      
+      virtual ::std::unique_ptr<cursor>
+         clone(void) const = 0;
+      
+      virtual Reference
+         read(void) const = 0;
+      
+      virtual void
+         next(void) = 0;
+      
+      virtual bool
+         done(void) const = 0;
+   }
+   ;
+   
+   struct holder
+   {
+      virtual
+         ~holder(void) = default;
+      
+      virtual ::std::unique_ptr<cursor>
+         begin(void) const = 0;
+   }
+   ;
+   
+   template <typename V>
+   struct cursor_of final
+      : cursor
+   {
+      cursor_of
+         (
+         ::std::ranges::iterator_t<V const> position,
+         ::std::ranges::sentinel_t<V const> last
+         )
+         :
+         position_( ::std::move( position ) ),
+         last_( ::std::move( last ) )
+      { }
+      
+      ::std::unique_ptr<cursor>
+         clone(void) const override
+      {
+         return
+            ::std::make_unique<cursor_of>( *this );
+      }
+      
+      Reference
+         read(void) const override
+      {
+         return
+            *position_;
+      }
+      
+      void
+         next(void) override
+      {
+         ++position_;
+      }
+      
+      bool
+         done(void) const override
+      {
+         return
+            position_ == last_;
+      }
+      
+      ::std::ranges::iterator_t<V const>
+         position_;
+      
+      ::std::ranges::sentinel_t<V const>
+         last_;
+   }
+   ;
+   
+   template <typename V>
+   struct holder_of final
+      : holder
+   {
+      explicit holder_of(V view)
+         :
+         view_( ::std::move( view ) )
+      { }
+      
+      ::std::unique_ptr<cursor>
+         begin(void) const override
+      {
+         return
+            ::std::make_unique< cursor_of<V> >
+               (
+               ::std::ranges::begin( view_ ),
+               ::std::ranges::end( view_ )
+               )
+               ;
+      }
+      
+      V
+         view_;
+   }
+   ;
+
+public:
+   class iterator
+   {
+   public:
+      using
+         iterator_concept = ::std::input_iterator_tag;
+      
+      using
+         value_type = ::std::remove_cvref_t<Reference>;
+      
+      using
+         difference_type = ::std::ptrdiff_t;
+      
+      iterator(void) = default;
+      
+      explicit iterator(::std::unique_ptr<cursor> position)
+         :
+         position_( ::std::move( position ) )
+      { }
+      
+      iterator(iterator const & other)
+         :
+         position_( other.position_ ? other.position_->clone() : nullptr )
+      { }
+      
+      iterator(iterator &&) = default;
+      
+      iterator &
+         operator= (iterator const & other)
+      {
+         return
+            *this = iterator( other );
+      }
+      
+      iterator &
+         operator= (iterator &&) = default;
+      
+      Reference
+         operator* (void) const
+      {
+         return
+            position_->read();
+      }
+      
+      iterator &
+         operator++ (void)
+      {
+         position_->next();
+         
+         return
+            *this;
+      }
+      
+      void
+         operator++ (int)
+      {
+         ++*this;
+      }
+      
+      friend bool
+         operator== (iterator const & position, ::std::default_sentinel_t)
+      {
+         return
+            position.position_->done();
+      }
+   
+   private:
+      ::std::unique_ptr<cursor>
+         position_;
+   }
+   ;
+   
+   erased_view(void) = default;
+   
+   template <::std::ranges::view V>
+      requires
+         ( not ::std::same_as<V, erased_view> )
+         
+         and
+         
+         ::std::ranges::input_range<V const>
+         
+         and
+         
+         ::std::convertible_to< ::std::ranges::range_reference_t<V const>, Reference >
+   explicit erased_view(V view)
+      :
+      holder_( ::std::make_shared< holder_of<V> const >( ::std::move( view ) ) )
+   { }
+   
+   iterator
+      begin(void) const
+   {
+      return
+         iterator( holder_->begin() );
+   }
+   
+   ::std::default_sentinel_t
+      end(void) const
+   {
+      return
+         { };
+   }
+
+private:
+   ::std::shared_ptr<holder const>
+      holder_;
+}
+;
+
+namespace detail
+{
+
+//
+// The number of leading arguments of merge_all which are
+// ranges; the remaining ones are the comparison and the
+// projection:
+//
+
+template <typename ... Arguments>
+constexpr ::std::size_t
+   leading_ranges(void)
+{
+   bool const
+      is_range[] { ::std::ranges::viewable_range<Arguments> ..., false };
+   
+   ::std::size_t
+      count = 0u;
+   
+   while( is_range[count] )
+   {
+      ++count;
+   }
+   
+   return
+      count;
+}
+
+template <typename Comparison, typename Projection, typename ... V>
+auto
+merge_views(Comparison comparison, Projection projection, V ... views)
+{
+   using
+      First = ::std::tuple_element_t< 0u, ::std::tuple<V ...> >;
+   
+   if constexpr ( ( ::std::same_as<V, First> and ... ) )
+   {
+      return
+         merge_view<First, Comparison, Projection>
+            (
+            ::std::vector<First> { ::std::move( views ) ... },
+            ::std::move( comparison ),
+            ::std::move( projection )
+            )
+            ;
+   }
+   else
+   {
+      using
+         View =
+            erased_view
+               <
+               ::std::common_reference_t< ::std::ranges::range_reference_t<V const> ... >
+               >
+               ;
+      
+      return
+         merge_view<View, Comparison, Projection>
+            (
+            ::std::vector<View> { View( ::std::move( views ) ) ... },
+            ::std::move( comparison ),
+            ::std::move( projection )
+            )
+            ;
+   }
+}
+
+}
+
+//
+// Merges two or more ranges passed as arguments, optionally
+// followed by a comparison and a projection, as in
+// merge_all( first, second, ::std::ranges::greater{ } ).
+// Views of different types are merged through erased_view:
+//
+
+template <typename ... Arguments>
+   requires
+      ( detail::leading_ranges<Arguments ...>() >= 2u )
+      
+      and
+      
+      ( sizeof...(Arguments) <= detail::leading_ranges<Arguments ...>() + 2u )
+auto
+merge_all(Arguments && ... arguments)
+{
+   constexpr ::std::size_t
+      count = detail::leading_ranges<Arguments ...>();
+   
+   auto
+      forwarded = ::std::forward_as_tuple( ::std::forward<Arguments>(arguments) ... );
+   
+   auto
+      comparison =
+         [&]
+         {
+            if constexpr ( sizeof...(Arguments) > count )
+            {
+               return
+                  ::std::get<count>( forwarded );
+            }
+            else
+            {
+               return
+                  ::std::ranges::less { };
+            }
+         }
+         ();
+   
+   auto
+      projection =
+         [&]
+         {
+            if constexpr ( sizeof...(Arguments) > count + 1u )
+            {
+               return
+                  ::std::get<count + 1u>( forwarded );
+            }
+            else
+            {
+               return
+                  ::std::identity { };
+            }
+         }
+         ();
+   
+   return
+      [&]<::std::size_t ... Index>(::std::index_sequence<Index ...>)
+      {
+         return
+            detail::merge_views
+               (
+               ::std::move( comparison ),
+               ::std::move( projection ),
+               ::std::views::all( ::std::get<Index>( ::std::move( forwarded ) ) ) ...
+               )
+               ;
+      }
+      ( ::std::make_index_sequence<count>() );
+}
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<int> const
+      first { 1, 4, 7 },
+      second { 2, 5, 8 },
+      third { 3, 6, 9 };
+   
+   for( int v : k_way::merge_all( first, second, third ) )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   //
+   // Merge shards of people sorted by ID, as by
+   // ::std::ranges::sort( items, { }, &Person::id_ ):
+   //
+   
+   ::std::vector< ::std::vector<Person> >
+      shards
+         {
+            { { "alice", 1. }, { "dave", 4. } },
+            { },
+            { { "bob", 2. }, { "carol", 3. }, { "erin", 5. } }
+         }
+         ;
+   
+   for
+      (
+      auto const & person
+         :
+      k_way::merge_all( shards, { }, &Person::id_ )
+      )
+   {
+      ::std::cout << person.id_ << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   //
+   // Ranges of different types are merged through
+   // erased_view, and a comparison and a projection may
+   // follow the ranges. Ties go to the earlier range:
+   //
+   
+   ::std::vector<int> const
+      evens { 8, 6, 4, 2 };
+   
+   ::std::array<int, 3u> const
+      odds { 9, 5, 1 };
+   
+   ::std::list<int> const
+      mixed { 7, 6, 3 };
+   
+   ::std::vector<int>
+      merged;
+   
+   ::std::ranges::copy
+      (
+      k_way::merge_all( evens, odds, mixed, ::std::ranges::greater { } ),
+      ::std::back_inserter( merged )
+      )
+      ;
+   
+   assert( ( merged == ::std::vector<int> { 9, 8, 7, 6, 6, 5, 4, 3, 2, 1 } ) );
+   
+   ::std::vector<Person> const
+      staff { { "alice", 3. }, { "bob", 5. } },
+      contractors { { "carol", 3. }, { "dave", 4. } };
+   
+   ::std::vector< ::std::string >
+      names;
+   
+   for
+      (
+      auto const & person
+         :
+      k_way::merge_all( staff, contractors, ::std::ranges::less { }, &Person::salary_ )
+      )
+   {
+      names.push_back( person.id_ );
+   }
+   
+   assert( ( names == ::std::vector< ::std::string > { "alice", "carol", "dave", "bob" } ) );
+   
+   //
+   // Small integer keys are packed with the range they come
+   // from. The extreme keys tie with the key of exhausted
+   // ranges, and still win:
+   //
+   
+   constexpr int
+      lowest = ::std::numeric_limits<int>::lowest(),
+      highest = ::std::numeric_limits<int>::max();
+   
+   ::std::vector< ::std::pair<int, char> > const
+      left { { lowest, 'a' }, { 0, 'b' }, { highest, 'c' } },
+      right { { lowest, 'd' }, { highest, 'e' } };
+   
+   ::std::string
+      order;
+   
+   for( auto const & [ number, letter ] : k_way::merge_all( left, right, ::std::ranges::less { }, &::std::pair<int, char>::first ) )
+   {
+      order += letter;
+   }
+   
+   assert( order == "adbce" );
+   
+   order.clear();
+   
+   for( auto const & [ number, letter ] : k_way::merge_all( right | ::std::views::reverse, left | ::std::views::reverse, ::std::ranges::greater { }, &::std::pair<int, char>::first ) )
+   {
+      order += letter;
+   }
+   
+   assert( order == "ecbda" );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark merging K = 2 ... 1024 sorted shards with the
+   // loser tree, with a binary heap, and with rounds of
+   // pairwise ::std::merge. The total number of elements can
+   // be passed as the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 4'000'000u
+               ;
+   
+   ::std::mt19937
+      generator( 42u );
+   
+   for( ::std::size_t shard_count = 2u; shard_count <= 1024u; shard_count *= 2u )
+   {
+      ::std::vector< ::std::vector<int> >
+         shards( shard_count );
+      
+      for( ::std::size_t index = 0; index < size; ++index )
+      {
+         shards[ generator() % shard_count ].push_back
+            (
+            static_cast<int>( generator() )
+            )
+            ;
+      }
+      
+      for( auto & shard : shards )
+      {
+         ::std::ranges::sort( shard );
+      }
+      
+      ::std::vector<int>
+         loser_tree,
+         heap,
+         pairwise;
+      
+      loser_tree.reserve( size );
+      
+      heap.reserve( size );
+      
+      auto const
+         loser_tree_time =
+            milliseconds
+               (
+               [&]
+               {
+                  ::std::ranges::copy
+                     (
+                     k_way::merge_all( shards ),
+                     ::std::back_inserter( loser_tree )
+                     )
+                     ;
+               }
+               )
+               ;
+      
+      auto const
+         heap_time =
+            milliseconds
+               (
+               [&]
+               {
+                  using
+                     Entry = ::std::pair<int, ::std::size_t>;
+                  
+                  ::std::priority_queue
+                     <
+                     Entry,
+                     ::std::vector<Entry>,
+                     ::std::greater<Entry>
+                     >
+                     queue;
+                  
+                  ::std::vector<::std::size_t>
+                     positions( shard_count, 0u );
+                  
+                  for( ::std::size_t shard = 0; shard < shard_count; ++shard )
+                  {
+                     if( not shards[shard].empty() )
+                     {
+                        queue.emplace( shards[shard][0], shard );
+                     }
+                  }
+                  
+                  while( not queue.empty() )
+                  {
+                     auto const
+                        [ value, shard ] = queue.top();
+                     
+                     queue.pop();
+                     
+                     heap.push_back( value );
+                     
+                     if( ++positions[shard] < shards[shard].size() )
+                     {
+                        queue.emplace( shards[shard][ positions[shard] ], shard );
+                     }
+                  }
+               }
+               )
+               ;
+      
+      auto const
+         pairwise_time =
+            milliseconds
+               (
+               [&]
+               {
+                  auto
+                     runs = shards;
+                  
+                  while( runs.size() > 1u )
+                  {
+                     ::std::vector< ::std::vector<int> >
+                        merged;
+                     
+                     for( ::std::size_t index = 0; index < runs.size(); index += 2u )
+                     {
+                        if( index + 1u == runs.size() )
+                        {
+                           merged.push_back( ::std::move( runs[index] ) );
+                           
+                           continue;
+                        }
+                        
+                        ::std::vector<int>
+                           run( runs[index].size() + runs[index + 1u].size() );
+                        
+                        ::std::ranges::merge( runs[index], runs[index + 1u], run.begin() );
+                        
+                        merged.push_back( ::std::move( run ) );
+                     }
+                     
+                     runs.swap( merged );
+                  }
+                  
+                  pairwise = ::std::move( runs.front() );
+               }
+               )
+               ;
+      
+      assert( loser_tree == heap and loser_tree == pairwise );
+      
+      ::std::cout << "K = "
+                  << shard_count
+                  << ": loser tree "
+                  << loser_tree_time
+                  << " ms, priority_queue "
+                  << heap_time
+                  << " ms, pairwise std::merge "
+                  << pairwise_time
+                  << " ms"
+                  << ::std::endl
+                     ;
+   }
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,555 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cctype>
+#include <cassert>
+
+#include <iostream>
+
+//
+// POSIX memory mapping:
+//
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//
+// A memory-mapped file is a contiguous sequence of bytes in
+// the address space of the process. Pages are read from
+// the file on first access, without an intermediate copy
+// into a user-space buffer (as read() and ::std::ifstream
+// would make).
+//
+// mapped_file_view exposes a mapped file as a contiguous
+// range of T, so it can be used wherever a span or a vector
+// could be used, including as the source of a view
+// pipeline:
+//
+//    mapped_file_view<char>
+//       file( path );
+//
+//    for( auto line : file | views::split( '\n' ) ) { ... }
+//
+// It is derived from ::std::ranges::view_interface, which
+// provides empty(), size(), operator[], front(), back() and
+// operator bool from begin() and end(). Views are expected
+// to be cheap to copy, and range adaptors copy lvalue views
+// into the pipeline, so copies of a mapped_file_view share
+// ownership of one mapping. The file is unmapped when the
+// last copy is destroyed.
+//
+
+//
+// read_only maps the file with PROT_READ, and the elements
+// are const. copy_on_write maps a private, writable copy:
+// modified pages are copied on first write and the file
+// itself is never modified.
+//
+
+enum class map_mode
+{
+   read_only,
+   copy_on_write
+}
+;
+
+//
+// Hints passed to madvise(), which may be combined with |:
+//
+
+enum class map_advice : unsigned
+{
+   normal = 0u,
+   sequential = 1u << 0,
+   random = 1u << 1,
+   will_need = 1u << 2,
+   huge_pages = 1u << 3
+}
+;
+
+constexpr map_advice
+operator| (map_advice first, map_advice second)
+{
+   return
+      static_cast<map_advice>
+         (
+         static_cast<unsigned>( first ) | static_cast<unsigned>( second )
+         )
+         ;
+}
+
+constexpr bool
+has_advice(map_advice advice, map_advice flag)
+{
+   return
+      ( static_cast<unsigned>( advice ) & static_cast<unsigned>( flag ) ) != 0u;
+}
+
+template
+   <
+   typename T = char,
+   map_mode Mode = map_mode::read_only
+   >
+   requires ::std::is_trivially_copyable_v<T>
+class mapped_file_view final
+   : public ::std::ranges::view_interface< mapped_file_view<T, Mode> >
+{
+public:
+   using
+      element_type =
+         ::std::conditional_t< Mode == map_mode::read_only, T const, T >;
+   
+   mapped_file_view(void) = default;
+   
+   //
+   // Throws ::std::system_error if the file cannot be
+   // opened or mapped. Any trailing bytes which do not make
+   // up a whole T are not part of the view:
+   //
+   
+   explicit mapped_file_view
+      (
+      ::std::filesystem::path const & path,
+      map_advice advice = map_advice::normal
+      )
+   {
+      int const
+         descriptor = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+      
+      if( descriptor < 0 )
+      {
+         throw
+            ::std::system_error
+               (
+               errno, ::std::generic_category(), "open " + path.string()
+               )
+               ;
+      }
+      
+      struct ::stat
+         status;
+      
+      if( ::fstat( descriptor, &status ) != 0 )
+      {
+         auto const
+            error = errno;
+         
+         ::close( descriptor );
+         
+         throw
+            ::std::system_error
+               (
+               error, ::std::generic_category(), "fstat " + path.string()
+               )
+               ;
+      }
+      
+      auto const
+         bytes = static_cast<::std::size_t>( status.st_size );
+      
+      void *
+         address = nullptr;
+      
+      //
+      // Mapping zero bytes is an error, so an empty file is
+      // an empty view:
+      //
+      
+      if( bytes != 0u )
+      {
+         int const
+            protection =
+               ( Mode == map_mode::read_only )
+                  ? PROT_READ
+                  : PROT_READ | PROT_WRITE
+                     ;
+         
+         address =
+            ::mmap
+               (
+               nullptr, bytes, protection, MAP_PRIVATE, descriptor, 0
+               )
+               ;
+      }
+      
+      auto const
+         error = errno;
+      
+      //
+      // The mapping remains valid after the descriptor is
+      // closed:
+      //
+      
+      ::close( descriptor );
+      
+      if( address == MAP_FAILED )
+      {
+         throw
+            ::std::system_error
+               (
+               error, ::std::generic_category(), "mmap " + path.string()
+               )
+               ;
+      }
+      
+      mapping_ = ::std::make_shared<mapping const>( address, bytes );
+      
+      this->advise( advice );
+   }
+   
+   //
+   // Hints are advisory: the kernel may ignore them, and
+   // huge_pages is only available on Linux (and only for
+   // some file systems), so failures are not reported:
+   //
+   
+   void
+      advise(map_advice advice) const noexcept
+   {
+      if( not mapping_ or mapping_->address_ == nullptr )
+      {
+         return;
+      }
+      
+      auto const
+         address = mapping_->address_;
+      
+      auto const
+         bytes = mapping_->bytes_;
+      
+      if( has_advice( advice, map_advice::sequential ) )
+      {
+         ::madvise( address, bytes, MADV_SEQUENTIAL );
+      }
+      
+      if( has_advice( advice, map_advice::random ) )
+      {
+         ::madvise( address, bytes, MADV_RANDOM );
+      }
+      
+      if( has_advice( advice, map_advice::will_need ) )
+      {
+         ::madvise( address, bytes, MADV_WILLNEED );
+      }
+      
+      #ifdef MADV_HUGEPAGE
+      
+      if( has_advice( advice, map_advice::huge_pages ) )
+      {
+         ::madvise( address, bytes, MADV_HUGEPAGE );
+      }
+      
+      #endif
+   }
+   
+   element_type *
+      begin(void) const
+   {
+      return
+         mapping_
+            ? static_cast<element_type *>( mapping_->address_ )
+            : nullptr
+               ;
+   }
+   
+   element_type *
+      end(void) const
+   {
+      return
+         mapping_
+            ? this->begin() + mapping_->bytes_ / sizeof(T)
+            : nullptr
+               ;
+   }
+   
+private:
+   struct mapping final
+   {
+      mapping(void * address, ::std::size_t bytes)
+         : address_( address ), bytes_( bytes )
+      { }
+      
+      mapping(mapping const &) = delete;
+      
+      mapping & operator= (mapping const &) = delete;
+      
+      ~mapping(void)
+      {
+         if( address_ != nullptr )
+         {
+            ::munmap( address_, bytes_ );
+         }
+      }
+      
+      void *
+         address_;
+      
+      ::std::size_t
+         bytes_;
+   }
+   ;
+   
+   ::std::shared_ptr<mapping const>
+      mapping_;
+}
+;
+
+static_assert
+   (
+   ::std::ranges::view< mapped_file_view<char> >
+   
+   and
+   
+   ::std::ranges::contiguous_range< mapped_file_view<char> >
+   
+   and
+   
+   ::std::ranges::sized_range< mapped_file_view<char> >
+   )
+   ;
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   namespace views = ::std::ranges::views;
+   
+   auto const
+      path =
+         ::std::filesystem::temp_directory_path()
+            /
+         "cpp-2x-mapped-file-view.txt"
+            ;
+   
+   {
+   
+   ::std::ofstream
+      file( path );
+   
+   file << "    remove spaces   \n"
+        << "  first line\n"
+        << "second line\n"
+           ;
+   
+   }
+   
+   {
+   
+   mapped_file_view<char>
+      file( path, map_advice::sequential | map_advice::will_need );
+   
+   //
+   // The pipelines from the ranges examples apply to whole
+   // files. In C++20, splitting a contiguous range yields
+   // contiguous subranges, which can be viewed as
+   // ::std::string_views without copying:
+   //
+   
+   for
+      (
+      auto const & line
+         :
+      file
+         | views::split( '\n' )
+         | views::transform
+            (
+            [] (auto const & line)
+            {
+               return
+                  ::std::string_view( line.begin(), line.end() );
+            }
+            )
+      )
+   {
+      for( char c : line | views::drop_while( ::isspace ) )
+      {
+         ::std::cout << static_cast<char>( ::toupper( c ) );
+      }
+      
+      ::std::cout << ::std::endl;
+   }
+   
+   }
+   
+   {
+   
+   //
+   // A copy-on-write mapping can be modified without
+   // modifying the file:
+   //
+   
+   mapped_file_view<char, map_mode::copy_on_write>
+      file( path );
+   
+   ::std::ranges::replace( file, ' ', '_' );
+   
+   assert( file.front() == '_' );
+   
+   mapped_file_view<char> const
+      original( path );
+   
+   assert( original.front() == ' ' );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark counting the lines and the characters of a
+   // file with ::std::ifstream and ::std::getline, and with
+   // a mapped file. The number of lines can be passed as the
+   // first command-line argument:
+   //
+   
+   ::std::size_t const
+      lines =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 2'000'000u
+               ;
+   
+   {
+   
+   ::std::ofstream
+      file( path );
+   
+   for( ::std::size_t index = 0; index < lines; ++index )
+   {
+      file << "line " << index << " of the benchmark file\n";
+   }
+   
+   }
+   
+   ::std::size_t
+      stream_lines = 0,
+      stream_characters = 0,
+      mapped_lines = 0,
+      mapped_characters = 0;
+   
+   auto const
+      stream_time =
+         milliseconds
+            (
+            [&]
+            {
+               ::std::ifstream
+                  file( path );
+               
+               ::std::string
+                  line;
+               
+               while( ::std::getline( file, line ) )
+               {
+                  ++stream_lines;
+                  
+                  stream_characters += line.size();
+               }
+            }
+            )
+            ;
+   
+   auto const
+      mapped_time =
+         milliseconds
+            (
+            [&]
+            {
+               mapped_file_view<char>
+                  file( path, map_advice::sequential );
+               
+               for( auto const & line : file | views::split( '\n' ) )
+               {
+                  ++mapped_lines;
+                  
+                  mapped_characters += ::std::ranges::size( line );
+               }
+               
+               //
+               // split yields an empty subrange after the
+               // final '\n', which getline does not:
+               //
+               
+               if( not file.empty() and file.back() == '\n' )
+               {
+                  --mapped_lines;
+               }
+            }
+            )
+            ;
+   
+   assert( stream_lines == mapped_lines );
+   
+   assert( stream_characters == mapped_characters );
+   
+   ::std::cout << lines
+               << " lines:"
+               << ::std::endl
+               << "   ifstream + getline: "
+               << stream_time
+               << " ms"
+               << ::std::endl
+               << "   mapped_file_view:   "
+               << mapped_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   ::std::filesystem::remove( path );
+   
+   return 0;
+}
@@ -0,0 +1,1490 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <concepts>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+//
+// The extents of a multidimensional array. Each extent is
+// either known at compile time, or ::std::dynamic_extent,
+// in which case it is stored. An array of which every
+// extent is static has the size of an empty class:
+//
+
+template <::std::size_t... Extents>
+class extents final
+{
+   static constexpr ::std::size_t
+      rank_ = sizeof...( Extents );
+   
+   static constexpr ::std::size_t
+      rank_dynamic_ = ( ::std::size_t( 0 ) + ... + ( Extents == ::std::dynamic_extent ) );
+   
+   static constexpr ::std::array<::std::size_t, rank_>
+      static_extents_ { Extents... };
+
+public:
+   static constexpr ::std::size_t
+      rank(void) noexcept
+   {
+      return
+         rank_;
+   }
+   
+   static constexpr ::std::size_t
+      rank_dynamic(void) noexcept
+   {
+      return
+         rank_dynamic_;
+   }
+   
+   static constexpr ::std::size_t
+      static_extent(::std::size_t r) noexcept
+   {
+      return
+         static_extents_[r];
+   }
+   
+   constexpr extents(void) noexcept = default;
+   
+   //
+   // Either the dynamic extents, or all of them (then the
+   // static ones must match):
+   //
+   
+   template <::std::integral... Sizes>
+      requires ( sizeof...( Sizes ) != 0u and sizeof...( Sizes ) == rank_dynamic_ )
+   constexpr explicit extents(Sizes... sizes) noexcept
+      : dynamic_ { static_cast<::std::size_t>( sizes )... }
+   {
+   }
+   
+   template <::std::integral... Sizes>
+      requires ( sizeof...( Sizes ) == rank_ and rank_dynamic_ != rank_ )
+   constexpr explicit extents(Sizes... sizes) noexcept
+   {
+      ::std::array<::std::size_t, rank_> const
+         all { static_cast<::std::size_t>( sizes )... };
+      
+      for( ::std::size_t r = 0, dynamic = 0; r < rank_; ++r )
+      {
+         if( static_extent( r ) != ::std::dynamic_extent )
+         {
+            assert( all[r] == static_extent( r ) );
+         }
+         else if constexpr ( rank_dynamic_ != 0u )
+         {
+            dynamic_[ dynamic++ ] = all[r];
+         }
+      }
+   }
+   
+   //
+   // With constant r, as in the index computations of the
+   // layouts once unrolled, a static extent is a constant:
+   //
+   
+   constexpr ::std::size_t
+      extent(::std::size_t r) const noexcept
+   {
+      if constexpr ( rank_dynamic_ == 0u )
+      {
+         return
+            static_extent( r );
+      }
+      else
+      {
+         if( static_extent( r ) != ::std::dynamic_extent )
+         {
+            return
+               static_extent( r );
+         }
+         
+         ::std::size_t
+            dynamic = 0;
+         
+         for( ::std::size_t other = 0; other < r; ++other )
+         {
+            dynamic += static_extent( other ) == ::std::dynamic_extent;
+         }
+         
+         return
+            dynamic_[dynamic];
+      }
+   }
+   
+   //
+   // The product of the extents in [first, last):
+   //
+   
+   constexpr ::std::size_t
+      product(::std::size_t first, ::std::size_t last) const noexcept
+   {
+      ::std::size_t
+         result = 1;
+      
+      for( ; first < last; ++first )
+      {
+         result *= extent( first );
+      }
+      
+      return
+         result;
+   }
+   
+   constexpr ::std::size_t
+      size(void) const noexcept
+   {
+      return
+         product( 0, rank_ );
+   }
+   
+   template <::std::size_t... Other>
+   constexpr bool
+      operator== (extents<Other...> const & other) const noexcept
+   {
+      if constexpr ( sizeof...( Other ) != rank_ )
+      {
+         return
+            false;
+      }
+      else
+      {
+         for( ::std::size_t r = 0; r < rank_; ++r )
+         {
+            if( extent( r ) != other.extent( r ) )
+            {
+               return
+                  false;
+            }
+         }
+         
+         return
+            true;
+      }
+   }
+
+private:
+   //
+   // ::std::array<T, 0> is not an empty class:
+   //
+   
+   struct no_dynamic_extents
+   {
+   }
+   ;
+   
+   [[no_unique_address]] ::std::conditional_t<rank_dynamic_ == 0u, no_dynamic_extents, ::std::array<::std::size_t, rank_dynamic_>>
+      dynamic_ { };
+}
+;
+
+//
+// Extents which are all dynamic, such as dextents<2>:
+//
+
+template <::std::size_t... R>
+extents<( static_cast<void>( R ), ::std::dynamic_extent )...>
+   all_dynamic(::std::index_sequence<R...>);
+
+template <::std::size_t Rank>
+using dextents = decltype( all_dynamic( ::std::make_index_sequence<Rank>() ) );
+
+//
+// A layout maps a multidimensional index to an offset in
+// the array. Row-major, the last index is contiguous, as in
+// C arrays:
+//
+
+struct layout_right
+{
+   template <typename Extents>
+   class mapping final
+   {
+   public:
+      typedef
+         Extents
+         extents_type
+            ;
+      
+      typedef
+         layout_right
+         layout_type
+            ;
+      
+      static constexpr bool
+         is_always_unique = true,
+         is_always_exhaustive = true,
+         is_always_strided = true
+            ;
+      
+      constexpr mapping(void) noexcept = default;
+      
+      constexpr explicit mapping(Extents const & sizes) noexcept
+         : extents_( sizes )
+      {
+      }
+      
+      constexpr Extents const &
+         extents(void) const noexcept
+      {
+         return
+            extents_;
+      }
+      
+      //
+      // Horner's scheme, ( i0 e1 + i1 ) e2 + i2:
+      //
+      
+      template <::std::integral... Indices>
+         requires ( sizeof...( Indices ) == Extents::rank() )
+      constexpr ::std::size_t
+         operator() (Indices... indices) const noexcept
+      {
+         ::std::size_t
+            offset = 0,
+            r = 0
+               ;
+         
+         ( ( offset = offset * extents_.extent( r++ ) + static_cast<::std::size_t>( indices ) ), ... );
+         
+         return
+            offset;
+      }
+      
+      constexpr ::std::size_t
+         stride(::std::size_t r) const noexcept
+      {
+         return
+            extents_.product( r + 1u, Extents::rank() );
+      }
+      
+      constexpr ::std::size_t
+         required_span_size(void) const noexcept
+      {
+         return
+            extents_.size();
+      }
+   
+   private:
+      [[no_unique_address]] Extents
+         extents_;
+   }
+   ;
+}
+;
+
+//
+// Column-major, the first index is contiguous, as in
+// Fortran arrays:
+//
+
+struct layout_left
+{
+   template <typename Extents>
+   class mapping final
+   {
+   public:
+      typedef
+         Extents
+         extents_type
+            ;
+      
+      typedef
+         layout_left
+         layout_type
+            ;
+      
+      static constexpr bool
+         is_always_unique = true,
+         is_always_exhaustive = true,
+         is_always_strided = true
+            ;
+      
+      constexpr mapping(void) noexcept = default;
+      
+      constexpr explicit mapping(Extents const & sizes) noexcept
+         : extents_( sizes )
+      {
+      }
+      
+      constexpr Extents const &
+         extents(void) const noexcept
+      {
+         return
+            extents_;
+      }
+      
+      template <::std::integral... Indices>
+         requires ( sizeof...( Indices ) == Extents::rank() )
+      constexpr ::std::size_t
+         operator() (Indices... indices) const noexcept
+      {
+         ::std::size_t
+            offset = 0,
+            stride = 1,
+            r = 0
+               ;
+         
+         ( ( offset += static_cast<::std::size_t>( indices ) * stride, stride *= extents_.extent( r++ ) ), ... );
+         
+         return
+            offset;
+      }
+      
+      constexpr ::std::size_t
+         stride(::std::size_t r) const noexcept
+      {
+         return
+            extents_.product( 0, r );
+      }
+      
+      constexpr ::std::size_t
+         required_span_size(void) const noexcept
+      {
+         return
+            extents_.size();
+      }
+   
+   private:
+      [[no_unique_address]] Extents
+         extents_;
+   }
+   ;
+}
+;
+
+//
+// Arbitrary strides, as for a column of a row-major matrix,
+// or for the result of submdspan:
+//
+
+struct layout_stride
+{
+   template <typename Extents>
+   class mapping final
+   {
+   public:
+      typedef
+         Extents
+         extents_type
+            ;
+      
+      typedef
+         layout_stride
+         layout_type
+            ;
+      
+      static constexpr bool
+         is_always_unique = true,
+         is_always_exhaustive = false,
+         is_always_strided = true
+            ;
+      
+      constexpr mapping(void) noexcept = default;
+      
+      constexpr mapping(Extents const & sizes, ::std::array<::std::size_t, Extents::rank()> const & strides) noexcept
+         : extents_( sizes ), strides_( strides )
+      {
+      }
+      
+      //
+      // From any other strided layout:
+      //
+      
+      template <typename Mapping>
+         requires ( Mapping::is_always_strided and ::std::same_as<typename Mapping::extents_type, Extents> )
+      constexpr explicit mapping(Mapping const & other) noexcept
+         : extents_( other.extents() )
+      {
+         for( ::std::size_t r = 0; r < Extents::rank(); ++r )
+         {
+            strides_[r] = other.stride( r );
+         }
+      }
+      
+      constexpr Extents const &
+         extents(void) const noexcept
+      {
+         return
+            extents_;
+      }
+      
+      template <::std::integral... Indices>
+         requires ( sizeof...( Indices ) == Extents::rank() )
+      constexpr ::std::size_t
+         operator() (Indices... indices) const noexcept
+      {
+         ::std::size_t
+            offset = 0,
+            r = 0
+               ;
+         
+         ( ( offset += static_cast<::std::size_t>( indices ) * strides_[ r++ ] ), ... );
+         
+         return
+            offset;
+      }
+      
+      constexpr ::std::size_t
+         stride(::std::size_t r) const noexcept
+      {
+         return
+            strides_[r];
+      }
+      
+      //
+      // One past the offset of the last element:
+      //
+      
+      constexpr ::std::size_t
+         required_span_size(void) const noexcept
+      {
+         ::std::size_t
+            last = 0;
+         
+         for( ::std::size_t r = 0; r < Extents::rank(); ++r )
+         {
+            if( extents_.extent( r ) == 0u )
+            {
+               return
+                  0;
+            }
+            
+            last += ( extents_.extent( r ) - 1u ) * strides_[r];
+         }
+         
+         return
+            last + 1u;
+      }
+   
+   private:
+      [[no_unique_address]] Extents
+         extents_;
+      
+      ::std::array<::std::size_t, Extents::rank()>
+         strides_ { };
+   }
+   ;
+}
+;
+
+//
+// A blocked layout for matrices: tiles of TileRows x
+// TileColumns elements are each contiguous and row-major,
+// and the tiles are in row-major order. Neighbours in both
+// dimensions are then usually in the same tile, which is
+// a few pages at most, so that column-wise traversals such
+// as in a transpose stay in cache and in the TLB. The tile
+// dimensions are powers of two, so that the divisions of
+// the index computation are shifts; the last row and
+// column of tiles are padded:
+//
+
+template <::std::size_t TileRows, ::std::size_t TileColumns>
+   requires ( ::std::has_single_bit( TileRows ) and ::std::has_single_bit( TileColumns ) )
+struct layout_tiled
+{
+   template <typename Extents>
+      requires ( Extents::rank() == 2u )
+   class mapping final
+   {
+   public:
+      typedef
+         Extents
+         extents_type
+            ;
+      
+      typedef
+         layout_tiled
+         layout_type
+            ;
+      
+      static constexpr bool
+         is_always_unique = true,
+         is_always_exhaustive = false,
+         is_always_strided = false
+            ;
+      
+      static constexpr ::std::size_t
+         tile_rows = TileRows,
+         tile_columns = TileColumns,
+         tile_size = TileRows * TileColumns
+            ;
+      
+      constexpr mapping(void) noexcept = default;
+      
+      constexpr explicit mapping(Extents const & sizes) noexcept
+         : extents_( sizes ), tiles_per_row_( ( sizes.extent( 1 ) + TileColumns - 1u ) / TileColumns )
+      {
+      }
+      
+      constexpr Extents const &
+         extents(void) const noexcept
+      {
+         return
+            extents_;
+      }
+      
+      template <::std::integral Row, ::std::integral Column>
+      constexpr ::std::size_t
+         operator() (Row row_index, Column column_index) const noexcept
+      {
+         auto const
+            row = static_cast<::std::size_t>( row_index ),
+            column = static_cast<::std::size_t>( column_index )
+               ;
+         
+         return
+            ( ( row / TileRows ) * tiles_per_row_ + column / TileColumns ) * tile_size
+               + ( row % TileRows ) * TileColumns + column % TileColumns
+                  ;
+      }
+      
+      constexpr ::std::size_t
+         required_span_size(void) const noexcept
+      {
+         return
+            ( extents_.extent( 0 ) + TileRows - 1u ) / TileRows * tiles_per_row_ * tile_size;
+      }
+   
+   private:
+      [[no_unique_address]] Extents
+         extents_;
+      
+      ::std::size_t
+         tiles_per_row_ = 0;
+   }
+   ;
+}
+;
+
+//
+// An accessor turns a data handle and an offset into a
+// reference. The default is a pointer:
+//
+
+template <typename T>
+struct default_accessor
+{
+   typedef
+      T
+      element_type
+         ;
+   
+   typedef
+      T *
+      data_handle_type
+         ;
+   
+   typedef
+      T &
+      reference
+         ;
+   
+   typedef
+      default_accessor
+      offset_policy
+         ;
+   
+   constexpr reference
+      access(data_handle_type data, ::std::size_t offset) const noexcept
+   {
+      return
+         data[offset];
+   }
+   
+   constexpr typename offset_policy::data_handle_type
+      offset(data_handle_type data, ::std::size_t offset) const noexcept
+   {
+      return
+         data + offset;
+   }
+}
+;
+
+//
+// A restrict-qualified pointer, promising the compiler that
+// the elements are accessed through no other view while
+// this one is in use, so that stores through other views do
+// not force reloads:
+//
+
+template <typename T>
+struct restrict_accessor
+{
+   typedef
+      T
+      element_type
+         ;
+   
+   typedef
+      T * __restrict
+      data_handle_type
+         ;
+   
+   typedef
+      T &
+      reference
+         ;
+   
+   typedef
+      restrict_accessor
+      offset_policy
+         ;
+   
+   constexpr reference
+      access(data_handle_type data, ::std::size_t offset) const noexcept
+   {
+      return
+         data[offset];
+   }
+   
+   constexpr T *
+      offset(data_handle_type data, ::std::size_t offset) const noexcept
+   {
+      return
+         data + offset;
+   }
+}
+;
+
+//
+// A pointer which is a multiple of Alignment bytes, so that
+// the compiler may use aligned vector loads and need not
+// peel iterations to reach an aligned address. Offsetting
+// the pointer loses the guarantee:
+//
+
+template <typename T, ::std::size_t Alignment>
+   requires ( ::std::has_single_bit( Alignment ) and Alignment >= alignof( T ) )
+struct aligned_accessor
+{
+   typedef
+      T
+      element_type
+         ;
+   
+   typedef
+      T *
+      data_handle_type
+         ;
+   
+   typedef
+      T &
+      reference
+         ;
+   
+   typedef
+      default_accessor<T>
+      offset_policy
+         ;
+   
+   constexpr reference
+      access(data_handle_type data, ::std::size_t offset) const noexcept
+   {
+      return
+         ::std::assume_aligned<Alignment>( data )[offset];
+   }
+   
+   constexpr typename offset_policy::data_handle_type
+      offset(data_handle_type data, ::std::size_t offset) const noexcept
+   {
+      return
+         data + offset;
+   }
+}
+;
+
+//
+// A non-owning multidimensional view: a data handle, a
+// mapping of the layout for the extents, and an accessor.
+// Elements are accessed with operator(), as the
+// multidimensional operator[] is C++23:
+//
+
+template <typename T, typename Extents, typename Layout = layout_right, typename Accessor = default_accessor<T>>
+class mdspan final
+{
+public:
+   typedef
+      Extents
+      extents_type
+         ;
+   
+   typedef
+      Layout
+      layout_type
+         ;
+   
+   typedef
+      Accessor
+      accessor_type
+         ;
+   
+   typedef
+      typename Layout::template mapping<Extents>
+      mapping_type
+         ;
+   
+   typedef
+      T
+      element_type
+         ;
+   
+   typedef
+      typename Accessor::data_handle_type
+      data_handle_type
+         ;
+   
+   typedef
+      typename Accessor::reference
+      reference
+         ;
+   
+   static constexpr ::std::size_t
+      rank(void) noexcept
+   {
+      return
+         Extents::rank();
+   }
+   
+   constexpr mdspan(void) noexcept = default;
+   
+   //
+   // The dynamic extents, or all of them:
+   //
+   
+   template <::std::integral... Sizes>
+      requires ( sizeof...( Sizes ) == Extents::rank_dynamic() or sizeof...( Sizes ) == Extents::rank() )
+   constexpr explicit mdspan(data_handle_type data, Sizes... sizes) noexcept
+      : data_( data ), mapping_( Extents( sizes... ) )
+   {
+   }
+   
+   constexpr mdspan(data_handle_type data, mapping_type const & mapping, Accessor const & accessor = { }) noexcept
+      : data_( data ), mapping_( mapping ), accessor_( accessor )
+   {
+   }
+   
+   template <::std::integral... Indices>
+      requires ( sizeof...( Indices ) == Extents::rank() )
+   constexpr reference
+      operator() (Indices... indices) const noexcept
+   {
+      return
+         accessor_.access( data_, mapping_( indices... ) );
+   }
+   
+   constexpr Extents const &
+      extents(void) const noexcept
+   {
+      return
+         mapping_.extents();
+   }
+   
+   constexpr ::std::size_t
+      extent(::std::size_t r) const noexcept
+   {
+      return
+         extents().extent( r );
+   }
+   
+   constexpr ::std::size_t
+      size(void) const noexcept
+   {
+      return
+         extents().size();
+   }
+   
+   constexpr bool
+      empty(void) const noexcept
+   {
+      return
+         size() == 0u;
+   }
+   
+   constexpr ::std::size_t
+      stride(::std::size_t r) const noexcept
+         requires ( mapping_type::is_always_strided )
+   {
+      return
+         mapping_.stride( r );
+   }
+   
+   constexpr auto
+      data_handle(void) const noexcept
+   {
+      return
+         data_;
+   }
+   
+   constexpr mapping_type const &
+      mapping(void) const noexcept
+   {
+      return
+         mapping_;
+   }
+   
+   constexpr Accessor const &
+      accessor(void) const noexcept
+   {
+      return
+         accessor_;
+   }
+
+private:
+   data_handle_type
+      data_ = nullptr;
+   
+   [[no_unique_address]] mapping_type
+      mapping_;
+   
+   [[no_unique_address]] Accessor
+      accessor_;
+}
+;
+
+template <typename T, ::std::integral... Sizes>
+mdspan(T *, Sizes...) -> mdspan<T, dextents<sizeof...( Sizes )>>;
+
+template <typename T, typename Mapping>
+mdspan(T *, Mapping const &) -> mdspan<T, typename Mapping::extents_type, typename Mapping::layout_type>;
+
+//
+// The slice specifiers of submdspan: an index, which
+// removes the dimension, full_extent, or a half-open range
+// [first, last) of indices:
+//
+
+struct full_extent_t
+{
+   explicit full_extent_t(void) = default;
+}
+;
+
+inline constexpr full_extent_t
+   full_extent { };
+
+template <typename Slice>
+concept IndexRange =
+   requires(Slice const & slice)
+   {
+      { slice.first } -> ::std::convertible_to<::std::size_t>;
+      { slice.second } -> ::std::convertible_to<::std::size_t>;
+   }
+   ;
+
+template <typename Slice>
+concept SliceSpecifier = ::std::integral<Slice> or ::std::same_as<Slice, full_extent_t> or IndexRange<Slice>;
+
+//
+// A view of a part of a strided mdspan, with the strides of
+// the kept dimensions and the data handle moved to the
+// first element. The tiled layout is not strided, so its
+// parts are not mdspans:
+//
+
+template <typename T, typename Extents, typename Layout, typename Accessor, SliceSpecifier... Slices>
+   requires ( sizeof...( Slices ) == Extents::rank() and Layout::template mapping<Extents>::is_always_strided )
+constexpr auto
+   submdspan(mdspan<T, Extents, Layout, Accessor> const & source, Slices... slices)
+{
+   constexpr ::std::size_t
+      rank = ( ::std::size_t( 0 ) + ... + ( not ::std::integral<Slices> ) );
+   
+   ::std::array<::std::size_t, rank>
+      sizes { },
+      strides { }
+         ;
+   
+   ::std::size_t
+      offset = 0,
+      r = 0,
+      kept = 0
+         ;
+   
+   auto const
+      slice =
+         [&] <typename Slice> (Slice const & specifier)
+         {
+            if constexpr ( ::std::integral<Slice> )
+            {
+               assert( static_cast<::std::size_t>( specifier ) < source.extent( r ) );
+               
+               offset += static_cast<::std::size_t>( specifier ) * source.stride( r );
+            }
+            else if constexpr ( ::std::same_as<Slice, full_extent_t> )
+            {
+               sizes[kept] = source.extent( r );
+               
+               strides[ kept++ ] = source.stride( r );
+            }
+            else
+            {
+               auto const
+                  first = static_cast<::std::size_t>( specifier.first ),
+                  last = static_cast<::std::size_t>( specifier.second )
+                     ;
+               
+               assert( first <= last and last <= source.extent( r ) );
+               
+               offset += first * source.stride( r );
+               
+               sizes[kept] = last - first;
+               
+               strides[ kept++ ] = source.stride( r );
+            }
+            
+            ++r;
+         }
+         ;
+   
+   ( slice( slices ), ... );
+   
+   typedef
+      dextents<rank>
+      sub_extents
+         ;
+   
+   typedef
+      typename Accessor::offset_policy
+      sub_accessor
+         ;
+   
+   return
+      mdspan<T, sub_extents, layout_stride, sub_accessor>
+         (
+         source.accessor().offset( source.data_handle(), offset ),
+         typename layout_stride::mapping<sub_extents>
+            (
+            ::std::apply( [] (auto... values) { return sub_extents( values... ); }, sizes ),
+            strides
+            ),
+         sub_accessor { }
+         )
+         ;
+}
+
+//
+// Allocates arrays aligned to cache lines, for the
+// aligned_accessor:
+//
+
+template <typename T>
+struct cache_aligned_allocator
+{
+   typedef
+      T
+      value_type
+         ;
+   
+   static constexpr ::std::align_val_t
+      alignment { 64u };
+   
+   cache_aligned_allocator(void) = default;
+   
+   template <typename U>
+   cache_aligned_allocator(cache_aligned_allocator<U> const &) noexcept
+   {
+   }
+   
+   T *
+      allocate(::std::size_t size)
+   {
+      return
+         static_cast<T *>( ::operator new( size * sizeof( T ), alignment ) );
+   }
+   
+   void
+      deallocate(T * pointer, ::std::size_t) noexcept
+   {
+      ::operator delete( pointer, alignment );
+   }
+   
+   template <typename U>
+   bool
+      operator== (cache_aligned_allocator<U> const &) const noexcept
+   {
+      return
+         true;
+   }
+}
+;
+
+//
+// The kernels work with any matrix view. A 5-point Jacobi
+// stencil over the interior:
+//
+
+template <typename In, typename Out>
+void
+   stencil
+      (
+      In const &
+         in,
+      Out const &
+         out
+      )
+{
+   for( ::std::size_t row = 1; row + 1u < in.extent( 0 ); ++row )
+   {
+      for( ::std::size_t column = 1; column + 1u < in.extent( 1 ); ++column )
+      {
+         out( row, column ) = 0.25f * ( in( row - 1u, column ) + in( row + 1u, column ) + in( row, column - 1u ) + in( row, column + 1u ) );
+      }
+   }
+   
+   return;
+}
+
+//
+// The same, with the index math written by hand:
+//
+
+void
+   stencil
+      (
+      float const *
+         in,
+      float *
+         out,
+      ::std::size_t
+         size
+      )
+{
+   for( ::std::size_t row = 1; row + 1u < size; ++row )
+   {
+      for( ::std::size_t column = 1; column + 1u < size; ++column )
+      {
+         out[ row * size + column ] = 0.25f * ( in[ ( row - 1u ) * size + column ] + in[ ( row + 1u ) * size + column ] + in[ row * size + column - 1u ] + in[ row * size + column + 1u ] );
+      }
+   }
+   
+   return;
+}
+
+template <typename In, typename Out>
+void
+   transpose
+      (
+      In const &
+         in,
+      Out const &
+         out
+      )
+{
+   for( ::std::size_t row = 0; row < in.extent( 0 ); ++row )
+   {
+      for( ::std::size_t column = 0; column < in.extent( 1 ); ++column )
+      {
+         out( column, row ) = in( row, column );
+      }
+   }
+   
+   return;
+}
+
+//
+// Loops blocked by Block x Block, so that each block of the
+// output is written while it is in cache:
+//
+
+template <::std::size_t Block, typename In, typename Out>
+void
+   blocked_transpose
+      (
+      In const &
+         in,
+      Out const &
+         out
+      )
+{
+   for( ::std::size_t first_row = 0; first_row < in.extent( 0 ); first_row += Block )
+   {
+      for( ::std::size_t first_column = 0; first_column < in.extent( 1 ); first_column += Block )
+      {
+         auto const
+            last_row = ::std::min( first_row + Block, in.extent( 0 ) ),
+            last_column = ::std::min( first_column + Block, in.extent( 1 ) )
+               ;
+         
+         for( ::std::size_t row = first_row; row < last_row; ++row )
+         {
+            for( ::std::size_t column = first_column; column < last_column; ++column )
+            {
+               out( column, row ) = in( row, column );
+            }
+         }
+      }
+   }
+   
+   return;
+}
+
+template <typename Left, typename Right>
+bool
+   equal
+      (
+      Left const &
+         left,
+      Right const &
+         right
+      )
+{
+   if( left.extents() != right.extents() )
+   {
+      return
+         false;
+   }
+   
+   for( ::std::size_t row = 0; row < left.extent( 0 ); ++row )
+   {
+      for( ::std::size_t column = 0; column < left.extent( 1 ); ++column )
+      {
+         if( left( row, column ) != right( row, column ) )
+         {
+            return
+               false;
+         }
+      }
+   }
+   
+   return
+      true;
+}
+
+template <typename Function>
+double
+   milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   //
+   // Static extents take no space:
+   //
+   
+   static_assert( sizeof( mdspan<int, extents<3, 4>> ) == sizeof( int * ) );
+   
+   static_assert( sizeof( mdspan<int, extents<3, ::std::dynamic_extent>> ) == 2u * sizeof( int * ) );
+   
+   static_assert( dextents<3>::rank() == 3u and dextents<3>::rank_dynamic() == 3u );
+   
+   int
+      array[3][4]
+         {
+         { 0, 1, 2, 3 },
+         { 4, 5, 6, 7 },
+         { 8, 9, 10, 11 }
+         }
+         ;
+   
+   mdspan<int, extents<3, 4>> const
+      matrix( &array[0][0] );
+   
+   assert( matrix( 1, 2 ) == 6 and matrix.stride( 0 ) == 4u and matrix.size() == 12u );
+   
+   //
+   // The same elements column-major, with one dynamic
+   // extent:
+   //
+   
+   mdspan<int, extents<4, ::std::dynamic_extent>, layout_left> const
+      columns( &array[0][0], 3 );
+   
+   assert( columns( 2, 1 ) == 6 and columns.extent( 1 ) == 3u and columns.stride( 1 ) == 4u );
+   
+   //
+   // Every other column, with explicit strides:
+   //
+   
+   mdspan<int, dextents<2>, layout_stride> const
+      even( &array[0][0], layout_stride::mapping<dextents<2>>( dextents<2>( 3, 2 ), { 4u, 2u } ) );
+   
+   assert( even( 2, 1 ) == 10 and even.mapping().required_span_size() == 11u );
+   
+   //
+   // Slices: a row, a column, and a block:
+   //
+   
+   auto const
+      row = submdspan( matrix, 1, full_extent );
+   
+   static_assert( decltype( row )::rank() == 1u );
+   
+   assert( row.extent( 0 ) == 4u and row( 3 ) == 7 );
+   
+   auto const
+      column = submdspan( matrix, full_extent, 2 );
+   
+   assert( column.extent( 0 ) == 3u and column.stride( 0 ) == 4u and column( 2 ) == 10 );
+   
+   auto const
+      block = submdspan( matrix, ::std::pair { 1, 3 }, ::std::pair { 1, 3 } );
+   
+   assert( block.extent( 0 ) == 2u and block( 0, 0 ) == 5 and block( 1, 1 ) == 10 );
+   
+   block( 1, 1 ) = -10;
+   
+   assert( array[2][2] == -10 );
+   
+   //
+   // A slice of a slice:
+   //
+   
+   assert( submdspan( block, 1, full_extent )( 0 ) == 9 );
+   
+   //
+   // Three dimensions, deduced from the arguments:
+   //
+   
+   ::std::vector<double>
+      cube( 2u * 3u * 4u );
+   
+   mdspan const
+      volume( cube.data(), 2, 3, 4 );
+   
+   static_assert( ::std::same_as<decltype( volume ), mdspan<double, dextents<3>> const> );
+   
+   volume( 1, 2, 3 ) = 1.0;
+   
+   assert( cube.back() == 1.0 and submdspan( volume, 1, full_extent, 3 )( 2 ) == 1.0 );
+   
+   //
+   // A tiled matrix of 5 x 5 in tiles of 2 x 4 elements, so
+   // that the last row and column of tiles are padded:
+   //
+   
+   layout_tiled<2, 4>::mapping<dextents<2>> const
+      tiles( dextents<2>( 5, 5 ) );
+   
+   assert( tiles.required_span_size() == 3u * 2u * 8u );
+   
+   assert( tiles( 0, 3 ) == 3u and tiles( 1, 0 ) == 4u and tiles( 0, 4 ) == 8u and tiles( 2, 0 ) == 16u );
+   
+   }
+   
+   {
+   
+   //
+   // The benchmarks work on square matrices of floats, of
+   // 2048 x 2048 unless another size is passed:
+   //
+   
+   constexpr ::std::size_t
+      static_size = 2048u;
+   
+   ::std::size_t const
+      size = argc > 1 ? ::std::strtoull( argv[1], nullptr, 10 ) : static_size,
+      repetitions = 10u
+         ;
+   
+   typedef
+      layout_tiled<32, 32>
+      tiled
+         ;
+   
+   tiled::mapping<dextents<2>> const
+      tiled_mapping( dextents<2>( size, size ) );
+   
+   auto const
+      capacity = tiled_mapping.required_span_size();
+   
+   ::std::vector<float, cache_aligned_allocator<float>>
+      in_data( capacity ),
+      out_data( capacity ),
+      expected_data( capacity )
+         ;
+   
+   mdspan<float, dextents<2>> const
+      in( in_data.data(), size, size ),
+      out( out_data.data(), size, size ),
+      expected( expected_data.data(), size, size )
+         ;
+   
+   mdspan<float, dextents<2>, tiled> const
+      tiled_in( in_data.data(), tiled_mapping ),
+      tiled_out( out_data.data(), tiled_mapping )
+         ;
+   
+   auto const
+      fill =
+         [&] (auto const & matrix)
+         {
+            for( ::std::size_t row = 0; row < size; ++row )
+            {
+               for( ::std::size_t column = 0; column < size; ++column )
+               {
+                  matrix( row, column ) = static_cast<float>( ( row * 7u + column * 13u ) % 1024u );
+               }
+            }
+            
+            ::std::ranges::fill( out_data, 0.0f );
+         }
+         ;
+   
+   bool
+      first_result = true;
+   
+   auto const
+      run =
+         [&] (char const * name, auto const & result, auto && kernel)
+         {
+            auto const
+               time =
+                  milliseconds
+                     (
+                     [&]
+                     {
+                        for( ::std::size_t repetition = 0; repetition < repetitions; ++repetition )
+                        {
+                           kernel();
+                        }
+                     }
+                     )
+                     ;
+            
+            assert( equal( result, expected ) );
+            
+            ::std::cout << ( ::std::exchange( first_result, false ) ? "" : ", " )
+                        << name
+                        << " "
+                        << time / static_cast<double>( repetitions )
+                           ;
+         }
+         ;
+   
+   //
+   // The stencil, row-major:
+   //
+   
+   fill( in );
+   
+   stencil( in_data.data(), expected_data.data(), size );
+   
+   ::std::cout << size
+               << " x "
+               << size
+               << " stencil, milliseconds per sweep: "
+                  ;
+   
+   run( "by hand", out, [&] { stencil( in_data.data(), out_data.data(), size ); } );
+   
+   run( "layout_right", out, [&] { stencil( in, out ); } );
+   
+   if( size == static_size )
+   {
+      mdspan<float, extents<static_size, static_size>> const
+         static_in( in_data.data() ),
+         static_out( out_data.data() )
+            ;
+      
+      run( "static extents", out, [&] { stencil( static_in, static_out ); } );
+   }
+   
+   {
+   
+   mdspan<float, dextents<2>, layout_right, restrict_accessor<float>> const
+      restrict_in( in_data.data(), size, size ),
+      restrict_out( out_data.data(), size, size )
+         ;
+   
+   run( "restrict", out, [&] { stencil( restrict_in, restrict_out ); } );
+   
+   mdspan<float, dextents<2>, layout_right, aligned_accessor<float, 64>> const
+      aligned_in( in_data.data(), size, size ),
+      aligned_out( out_data.data(), size, size )
+         ;
+   
+   run( "aligned", out, [&] { stencil( aligned_in, aligned_out ); } );
+   
+   }
+   
+   //
+   // The stencil, tiled:
+   //
+   
+   fill( tiled_in );
+   
+   run( "tiled", tiled_out, [&] { stencil( tiled_in, tiled_out ); } );
+   
+   ::std::cout << ::std::endl;
+   
+   //
+   // The transpose:
+   //
+   
+   fill( in );
+   
+   transpose( in, expected );
+   
+   first_result = true;
+   
+   ::std::cout << size
+               << " x "
+               << size
+               << " transpose, milliseconds: "
+                  ;
+   
+   run( "layout_right", out, [&] { transpose( in, out ); } );
+   
+   run( "layout_right blocked", out, [&] { blocked_transpose<32>( in, out ); } );
+   
+   fill( tiled_in );
+   
+   run( "tiled", tiled_out, [&] { transpose( tiled_in, tiled_out ); } );
+   
+   run( "tiled blocked", tiled_out, [&] { blocked_transpose<tiled::mapping<dextents<2>>::tile_rows>( tiled_in, tiled_out ); } );
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,1042 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+//
+// The Point of the spaceship operator examples, with a
+// defaulted <=> which compares x, then y:
+//
+
+struct Point
+{
+   int
+      x,
+      y
+      ;
+   
+   auto operator <=> (Point const & other) const = default;
+}
+;
+
+//
+// Point4 of the same examples compares y first, in a <=>
+// which is not constexpr:
+//
+
+struct Point4
+{
+   int
+      x,
+      y
+      ;
+   
+   ::std::strong_ordering
+      operator<=> (Point4 const & other) const
+   {
+      if ( auto cmp = y <=> other.y; cmp != 0 )
+      {
+         return
+            cmp;
+      }
+      
+      return ( x <=> other.x )
+         ;
+   }
+   
+   bool operator== (Point4 const & other) const = default;
+}
+;
+
+//
+// Fields of different sizes and signedness:
+//
+
+struct Pixel
+{
+   ::std::uint8_t
+      red,
+      green,
+      blue,
+      alpha
+      ;
+   
+   auto operator <=> (Pixel const & other) const = default;
+}
+;
+
+struct Event
+{
+   ::std::int16_t
+      priority;
+   
+   ::std::uint32_t
+      time;
+   
+   auto operator <=> (Event const & other) const = default;
+}
+;
+
+namespace ranges
+{
+
+//
+// The number of fields of an aggregate, up to 4, found by
+// counting the initializers it accepts. field_initializer
+// converts only to integral types, so aggregates with
+// other fields have no count:
+//
+
+struct field_initializer final
+{
+   template <::std::integral T>
+   operator T (void) const;
+}
+;
+
+template <typename T, typename... Initializers>
+concept integral_aggregate_initializable =
+   ::std::is_aggregate_v<T>
+   
+   and
+   
+   requires
+   {
+      T { ::std::declval<Initializers>()... };
+   }
+   ;
+
+template <typename T>
+constexpr ::std::size_t
+integral_initializer_count(void)
+{
+   using
+      I = field_initializer;
+   
+   if constexpr( integral_aggregate_initializable<T, I, I, I, I, I> )
+   {
+      return
+         0u;
+   }
+   else if constexpr( integral_aggregate_initializable<T, I, I, I, I> )
+   {
+      return
+         4u;
+   }
+   else if constexpr( integral_aggregate_initializable<T, I, I, I> )
+   {
+      return
+         3u;
+   }
+   else if constexpr( integral_aggregate_initializable<T, I, I> )
+   {
+      return
+         2u;
+   }
+   else if constexpr( integral_aggregate_initializable<T, I> )
+   {
+      return
+         1u;
+   }
+   else
+   {
+      return
+         0u;
+   }
+}
+
+//
+// Through brace elision, an array field accepts one
+// initializer per element, and a base class one per field
+// of the base, but a structured binding names each of them
+// once, or not at all. An empty pair of braces initializes
+// a whole field, or a whole base, so the count of
+// initializers must match the count of elements, which is
+// found with braces, up to 5:
+//
+
+template <typename T>
+constexpr ::std::size_t
+element_count(void)
+{
+   if constexpr( requires { T { { }, { }, { }, { }, { } }; } )
+   {
+      return
+         5u;
+   }
+   else if constexpr( requires { T { { }, { }, { }, { } }; } )
+   {
+      return
+         4u;
+   }
+   else if constexpr( requires { T { { }, { }, { } }; } )
+   {
+      return
+         3u;
+   }
+   else if constexpr( requires { T { { }, { } }; } )
+   {
+      return
+         2u;
+   }
+   else if constexpr( requires { T { { } }; } )
+   {
+      return
+         1u;
+   }
+   else
+   {
+      return
+         0u;
+   }
+}
+
+//
+// Base classes come first in aggregate initialization, so
+// an aggregate has one if its first element can be
+// initialized from a type which converts only to its
+// bases:
+//
+
+template <typename T>
+struct base_initializer final
+{
+   template <typename Base>
+      requires
+         ( ::std::is_base_of_v<Base, T> and not ::std::is_same_v<Base, T> )
+   operator Base (void) const;
+}
+;
+
+template <typename T>
+concept has_base =
+   ::std::is_aggregate_v<T>
+   
+   and
+   
+   requires
+   {
+      T { base_initializer<T>() };
+   }
+   ;
+
+template <typename T>
+constexpr ::std::size_t
+integral_field_count(void)
+{
+   constexpr auto
+      count = integral_initializer_count<T>();
+   
+   if constexpr( count != element_count<T>() or has_base<T> )
+   {
+      return
+         0u;
+   }
+   else
+   {
+      return
+         count;
+   }
+}
+
+//
+// The fields of an aggregate as a tuple of references,
+// through structured bindings:
+//
+
+template <typename T>
+constexpr auto
+tie_fields(T & value)
+{
+   constexpr auto
+      count = integral_field_count< ::std::remove_const_t<T> >();
+   
+   if constexpr( count == 1u )
+   {
+      auto & [ a ] = value;
+      
+      return
+         ::std::tie( a );
+   }
+   else if constexpr( count == 2u )
+   {
+      auto & [ a, b ] = value;
+      
+      return
+         ::std::tie( a, b );
+   }
+   else if constexpr( count == 3u )
+   {
+      auto & [ a, b, c ] = value;
+      
+      return
+         ::std::tie( a, b, c );
+   }
+   else
+   {
+      auto & [ a, b, c, d ] = value;
+      
+      return
+         ::std::tie( a, b, c, d );
+   }
+}
+
+template <typename... Fields>
+::std::tuple< ::std::remove_const_t<Fields>... >
+decay_fields(::std::tuple<Fields & ...>);
+
+template <typename T>
+using
+   field_types = decltype( decay_fields( tie_fields( ::std::declval<T &>() ) ) );
+
+template <typename T>
+inline constexpr ::std::size_t
+   field_bits =
+      []<typename... Fields> (::std::tuple<Fields...> *)
+      {
+         return
+            ( 0u + ... + ( ::std::same_as<Fields, bool> ? 1u : 8u * sizeof( Fields ) ) );
+      }
+      ( static_cast<field_types<T> *>( nullptr ) )
+      ;
+
+//
+// Whether <=> orders T as the lexicographic comparison of
+// its fields, as a defaulted <=> does. The comparison is
+// evaluated at compile time on pairs which differ first in
+// each field, with the remaining fields set so that any
+// other order would disagree. A <=> which is not constexpr
+// cannot be checked and is rejected, so that types which
+// order differently are not sorted by a wrong key:
+//
+
+template <typename T>
+constexpr bool
+orders_lexicographically(void)
+{
+   return
+      []<typename... Fields, ::std::size_t... Indices>
+         (::std::tuple<Fields...> *, ::std::index_sequence<Indices...>)
+      {
+         auto const
+            make =
+               [] (::std::size_t differing, bool greater)
+               {
+                  return
+                     T
+                        {
+                        (
+                        Indices < differing
+                           ? Fields( 0 )
+                           : Indices == differing
+                              ? Fields( greater ? 1 : 0 )
+                              : greater
+                                 ? ::std::numeric_limits<Fields>::lowest()
+                                 : ::std::numeric_limits<Fields>::max()
+                        )...
+                        }
+                        ;
+               }
+               ;
+         
+         for( ::std::size_t field = 0; field < sizeof...( Fields ); ++field )
+         {
+            auto const
+               smaller = make( field, false ),
+               larger = make( field, true );
+            
+            if( not ( ( smaller <=> larger ) < 0 and ( larger <=> smaller ) > 0 and ( smaller <=> smaller ) == 0 ) )
+            {
+               return
+                  false;
+            }
+         }
+         
+         return
+            true;
+      }
+      ( static_cast<field_types<T> *>( nullptr ), ::std::make_index_sequence< integral_field_count<T>() >() )
+      ;
+}
+
+//
+// Aggregates of up to four integral fields, of at most 64
+// bits in total, strongly ordered by a <=> which compares
+// their fields lexicographically:
+//
+
+template <typename T>
+concept PackedKeyOrdered =
+   ( integral_field_count<T>() > 0u )
+   
+   and
+   
+   ::std::is_trivially_copyable_v<T>
+   
+   and
+   
+   ::std::three_way_comparable<T, ::std::strong_ordering>
+   
+   and
+   
+   ( field_bits<T> <= 64u )
+   
+   and
+   
+   requires
+   {
+      typename ::std::bool_constant< orders_lexicographically<T>() >;
+   }
+   
+   and
+   
+   orders_lexicographically<T>()
+   ;
+
+//
+// An unsigned integer wide enough for the fields of T:
+//
+
+template <PackedKeyOrdered T>
+using
+   packed_key_t =
+      ::std::conditional_t
+         <
+         ( field_bits<T> <= 32u ),
+         ::std::uint32_t,
+         ::std::uint64_t
+         >
+         ;
+
+//
+// Each field, made unsigned with its sign bit flipped so
+// that the order of the integers is kept, is shifted into
+// the key after the previous ones: comparing keys compares
+// the fields lexicographically.
+//
+
+template <typename Field, typename Key>
+constexpr Key
+encode_field(Field field)
+{
+   if constexpr( ::std::same_as<Field, bool> )
+   {
+      return
+         field ? 1u : 0u;
+   }
+   else
+   {
+      using
+         unsigned_type = ::std::make_unsigned_t<Field>;
+      
+      auto
+         bits = static_cast<unsigned_type>( field );
+      
+      if constexpr( ::std::is_signed_v<Field> )
+      {
+         bits ^= static_cast<unsigned_type>( unsigned_type { 1u } << ( 8u * sizeof( Field ) - 1u ) );
+      }
+      
+      return
+         static_cast<Key>( bits );
+   }
+}
+
+template <typename Field, typename Key>
+constexpr Field
+decode_field(Key key)
+{
+   if constexpr( ::std::same_as<Field, bool> )
+   {
+      return
+         ( key & 1u ) != 0u;
+   }
+   else
+   {
+      using
+         unsigned_type = ::std::make_unsigned_t<Field>;
+      
+      auto
+         bits = static_cast<unsigned_type>( key );
+      
+      if constexpr( ::std::is_signed_v<Field> )
+      {
+         bits ^= static_cast<unsigned_type>( unsigned_type { 1u } << ( 8u * sizeof( Field ) - 1u ) );
+      }
+      
+      return
+         static_cast<Field>( bits );
+   }
+}
+
+template <typename Field>
+inline constexpr unsigned
+   encoded_bits = ::std::same_as<Field, bool> ? 1u : 8u * sizeof( Field );
+
+struct packed_key_fn final
+{
+   template <PackedKeyOrdered T>
+   constexpr packed_key_t<T>
+      operator() (T const & value) const
+   {
+      using
+         key_type = packed_key_t<T>;
+      
+      return
+         ::std::apply
+            (
+            [] (auto const & ... fields)
+            {
+               key_type
+                  key = 0u;
+               
+               (
+               (
+               key =
+                  static_cast<key_type>
+                     (
+                     ( encoded_bits< ::std::remove_cvref_t<decltype( fields )> > == 8u * sizeof( key_type ) ? 0u : key << encoded_bits< ::std::remove_cvref_t<decltype( fields )> > )
+                     |
+                     encode_field< ::std::remove_cvref_t<decltype( fields )>, key_type >( fields )
+                     )
+               )
+               ,
+               ...
+               )
+               ;
+               
+               return
+                  key;
+            }
+            ,
+            tie_fields( value )
+            )
+            ;
+   }
+}
+;
+
+//
+// The order-preserving key of a value, usable as a
+// projection: a < b if and only if packed_key( a ) <
+// packed_key( b ):
+//
+
+inline constexpr packed_key_fn
+   packed_key;
+
+//
+// The value of a key. Since the fields are the whole value
+// of T, a key decodes to a value equal to the one encoded:
+//
+
+template <PackedKeyOrdered T>
+constexpr T
+unpack_key(packed_key_t<T> key)
+{
+   return
+      []<typename... Fields, ::std::size_t... Indices>
+         (packed_key_t<T> key, ::std::tuple<Fields...> *, ::std::index_sequence<Indices...>)
+      {
+         //
+         // The shift of every field, counted from the last:
+         //
+         
+         constexpr ::std::array<unsigned, sizeof...( Fields )>
+            bits { encoded_bits<Fields>... };
+         
+         constexpr auto
+            shifts =
+               [&]
+               {
+                  ::std::array<unsigned, sizeof...( Fields )>
+                     result { };
+                  
+                  unsigned
+                     shift = 0u;
+                  
+                  for( ::std::size_t field = sizeof...( Fields ); field-- > 0u; )
+                  {
+                     result[field] = shift;
+                     
+                     shift += bits[field];
+                  }
+                  
+                  return
+                     result;
+               }
+               ()
+               ;
+         
+         return
+            T { decode_field<Fields>( static_cast<packed_key_t<T>>( key >> shifts[Indices] ) )... };
+      }
+      ( key, static_cast<field_types<T> *>( nullptr ), ::std::make_index_sequence< integral_field_count<T>() >() )
+      ;
+}
+
+//
+// Sorts unsigned keys with a least significant digit radix
+// sort, 11 bits per pass, with histograms which fit in the
+// L1 cache:
+//
+//    * Keys are sorted by their difference with the
+//      smallest key, so that only the digits of the range of
+//      the keys are sorted: 6 passes for 64-bit keys at
+//      most, 4 for Points whose x spans a few thousand
+//      values.
+//    * The histograms of every digit are counted in one pass
+//      over the keys, and the passes of digits which are the
+//      same for every key are skipped.
+//
+
+template <::std::unsigned_integral Key>
+void
+radix_sort(::std::vector<Key> & keys)
+{
+   if( keys.empty() )
+   {
+      return;
+   }
+   
+   constexpr unsigned
+      bits = 11u;
+   
+   constexpr Key
+      mask = ( Key { 1u } << bits ) - 1u;
+   
+   auto const
+      [ smallest, largest ] = ::std::ranges::minmax( keys );
+   
+   auto const
+      digits = ( static_cast<unsigned>( ::std::bit_width( static_cast<Key>( largest - smallest ) ) ) + bits - 1u ) / bits;
+   
+   ::std::vector< ::std::array<::std::size_t, mask + 1u> >
+      histograms( digits );
+   
+   for( auto const key : keys )
+   {
+      for( unsigned digit = 0; digit < digits; ++digit )
+      {
+         ++histograms[digit][ ( static_cast<Key>( key - smallest ) >> ( bits * digit ) ) & mask ];
+      }
+   }
+   
+   ::std::vector<Key>
+      buffer( keys.size() );
+   
+   for( unsigned digit = 0; digit < digits; ++digit )
+   {
+      auto &
+         histogram = histograms[digit];
+      
+      if( ::std::ranges::count( histogram, keys.size() ) == 1 )
+      {
+         continue;
+      }
+      
+      //
+      // The offsets of every bucket:
+      //
+      
+      ::std::size_t
+         offset = 0u;
+      
+      for( auto & count : histogram )
+      {
+         offset += ::std::exchange( count, offset );
+      }
+      
+      for( auto const key : keys )
+      {
+         buffer[ histogram[ ( static_cast<Key>( key - smallest ) >> ( bits * digit ) ) & mask ]++ ] = key;
+      }
+      
+      keys.swap( buffer );
+   }
+}
+
+//
+// Sorts a range of values in the order of their <=>, by
+// radix sorting their keys and unpacking the keys into the
+// range:
+//
+
+template <::std::ranges::random_access_range Range>
+   requires
+      (
+      PackedKeyOrdered< ::std::ranges::range_value_t<Range> >
+      and
+      ::std::ranges::sized_range<Range>
+      )
+::std::ranges::borrowed_iterator_t<Range>
+packed_sort(Range && range)
+{
+   using
+      value_type = ::std::ranges::range_value_t<Range>;
+   
+   ::std::vector< packed_key_t<value_type> >
+      keys( ::std::ranges::size( range ) );
+   
+   ::std::ranges::transform( range, keys.begin(), packed_key );
+   
+   radix_sort( keys );
+   
+   return
+      ::std::ranges::transform( keys, ::std::ranges::begin( range ), &unpack_key<value_type> ).out;
+}
+
+//
+// Searches of a sorted range, comparing one key rather
+// than the fields one by one:
+//
+
+template <::std::ranges::forward_range Range>
+   requires ( PackedKeyOrdered< ::std::ranges::range_value_t<Range> > )
+::std::ranges::borrowed_iterator_t<Range>
+packed_lower_bound(Range && range, ::std::ranges::range_value_t<Range> const & value)
+{
+   return
+      ::std::ranges::lower_bound( range, packed_key( value ), ::std::ranges::less(), packed_key );
+}
+
+template <::std::ranges::forward_range Range>
+   requires ( PackedKeyOrdered< ::std::ranges::range_value_t<Range> > )
+::std::ranges::borrowed_subrange_t<Range>
+packed_equal_range(Range && range, ::std::ranges::range_value_t<Range> const & value)
+{
+   return
+      ::std::ranges::equal_range( range, packed_key( value ), ::std::ranges::less(), packed_key );
+}
+
+}
+
+static_assert( ranges::PackedKeyOrdered<Point> and ranges::PackedKeyOrdered<Pixel> and ranges::PackedKeyOrdered<Event> );
+
+static_assert( ::std::same_as< ranges::packed_key_t<Pixel>, ::std::uint32_t > and ::std::same_as< ranges::packed_key_t<Point>, ::std::uint64_t > );
+
+//
+// Point4 orders y first, ::std::string is not integral and
+// four 32-bit fields do not fit in 64 bits. Transposed
+// orders y first in a constexpr <=>, so that the order is
+// checked, and brace elision gives Pair and Derived two
+// initializers but one element each:
+//
+
+struct Transposed
+{
+   int
+      x,
+      y
+      ;
+   
+   constexpr ::std::strong_ordering
+      operator<=> (Transposed const & other) const
+   {
+      if ( auto cmp = y <=> other.y; cmp != 0 )
+      {
+         return
+            cmp;
+      }
+      
+      return ( x <=> other.x )
+         ;
+   }
+   
+   bool operator== (Transposed const & other) const = default;
+}
+;
+
+struct Pair
+{
+   int
+      values[2];
+   
+   auto operator <=> (Pair const & other) const = default;
+}
+;
+
+struct Base
+{
+   int
+      x;
+   
+   auto operator <=> (Base const & other) const = default;
+}
+;
+
+struct Derived
+   : Base
+{
+   int
+      y;
+   
+   auto operator <=> (Derived const & other) const = default;
+}
+;
+
+struct Named
+{
+   int
+      id;
+   
+   ::std::string
+      name;
+   
+   auto operator <=> (Named const & other) const = default;
+}
+;
+
+struct Wide
+{
+   int
+      a,
+      b,
+      c,
+      d
+      ;
+   
+   auto operator <=> (Wide const & other) const = default;
+}
+;
+
+static_assert( not ranges::PackedKeyOrdered<Point4> and not ranges::PackedKeyOrdered<Named> and not ranges::PackedKeyOrdered<Wide> );
+
+static_assert( not ranges::PackedKeyOrdered<Transposed> and not ranges::PackedKeyOrdered<Pair> and not ranges::PackedKeyOrdered<Derived> );
+
+static_assert( ranges::integral_field_count<Transposed>() == 2u and ranges::orders_lexicographically<Point>() and not ranges::orders_lexicographically<Transposed>() );
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   //
+   // Keys keep the order of <=>:
+   //
+   
+   ::std::mt19937
+      generator( 7 );
+   
+   ::std::uniform_int_distribution<int>
+      small( -3, 3 );
+   
+   ::std::vector<Event>
+      events( 1000 );
+   
+   for( auto & event : events )
+   {
+      event = { static_cast<::std::int16_t>( small( generator ) ), static_cast<::std::uint32_t>( generator() % 5u ) };
+   }
+   
+   for( auto const & first : events )
+   {
+      for( auto const & second : events )
+      {
+         assert( ( first <=> second ) == ( ranges::packed_key( first ) <=> ranges::packed_key( second ) ) );
+      }
+      
+      assert( ranges::unpack_key<Event>( ranges::packed_key( first ) ) == first );
+   }
+   
+   auto
+      expected = events;
+   
+   ::std::ranges::sort( expected );
+   
+   ranges::packed_sort( events );
+   
+   assert( events == expected );
+   
+   auto const
+      found = ranges::packed_equal_range( events, Event { 1, 2 } );
+   
+   assert( ::std::ranges::equal( found, ::std::ranges::equal_range( expected, Event { 1, 2 } ) ) );
+   
+   ::std::vector<Pixel>
+      pixels { { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 0 }, { 0, 0, 255, 255 } };
+   
+   ranges::packed_sort( pixels );
+   
+   assert( ::std::ranges::is_sorted( pixels ) );
+   
+   assert( ranges::packed_lower_bound( pixels, Pixel { 0, 0, 255, 100 } ) == pixels.begin() + 1 );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark sorting Points. The number of Points can be
+   // passed as the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 10'000'000u
+               ;
+   
+   ::std::mt19937
+      generator( 42 );
+   
+   ::std::uniform_int_distribution<int>
+      distribution( ::std::numeric_limits<int>::lowest(), ::std::numeric_limits<int>::max() ),
+      few( -1000, 1000 );
+   
+   ::std::vector<Point>
+      points( size );
+   
+   for( auto & point : points )
+   {
+      //
+      // Many equal x, so that y is compared too:
+      //
+      
+      point = { few( generator ), distribution( generator ) };
+   }
+   
+   auto
+      sorted = points;
+   
+   auto const
+      sort_time = milliseconds( [&] { ::std::ranges::sort( sorted ); } );
+   
+   auto
+      projected = points;
+   
+   auto const
+      projected_time = milliseconds( [&] { ::std::ranges::sort( projected, ::std::ranges::less(), ranges::packed_key ); } );
+   
+   assert( projected == sorted );
+   
+   auto
+      radix_sorted = points;
+   
+   auto const
+      radix_time = milliseconds( [&] { ranges::packed_sort( radix_sorted ); } );
+   
+   assert( radix_sorted == sorted );
+   
+   ::std::cout << size
+               << " Points: ranges::sort "
+               << sort_time
+               << " ms, ranges::sort by packed_key "
+               << projected_time
+               << " ms, packed_sort "
+               << radix_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   //
+   // Searches. The sums of the positions found are printed,
+   // so that the searches cannot be removed:
+   //
+   
+   ::std::size_t
+      hits = 0u,
+      packed_hits = 0u;
+   
+   auto const
+      search_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t index = 0; index < size; index += 10u )
+               {
+                  hits += ::std::ranges::lower_bound( sorted, points[index] ) - sorted.begin();
+               }
+            }
+            )
+            ;
+   
+   auto const
+      packed_search_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t index = 0; index < size; index += 10u )
+               {
+                  packed_hits += ranges::packed_lower_bound( sorted, points[index] ) - sorted.begin();
+               }
+            }
+            )
+            ;
+   
+   assert( hits == packed_hits );
+   
+   ::std::cout << size / 10u
+               << " searches: ranges::lower_bound "
+               << search_time
+               << " ms (sum of positions "
+               << hits
+               << "), packed_lower_bound "
+               << packed_search_time
+               << " ms (sum of positions "
+               << packed_hits
+               << ")"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,745 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <exception>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token>
+#include <latch>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// A view pipeline such as:
+//
+//    items
+//       | views::filter( predicate )
+//       | views::transform( function )
+//
+// is evaluated lazily, one element at a time, by whichever
+// thread iterates over it. If the underlying range is
+// random-access then it can instead be split into chunks,
+// and the same pipeline can be applied to every chunk
+// independently on a pool of threads.
+//
+// In C++20, range adaptor closures compose with the pipe
+// operator without being applied to a range:
+//
+//    auto
+//       pipeline =
+//          views::filter( predicate )
+//             | views::transform( function );
+//
+// so a pipeline can be passed to a function and applied to
+// each chunk (a ::std::ranges::subrange) separately:
+//
+//    chunk | pipeline
+//
+// The per-chunk results are then combined in chunk order,
+// either with a reduction or by concatenation, so the
+// result is the same as a sequential evaluation (as long as
+// the reduction operation is associative).
+//
+
+//
+// A fixed-size pool of worker threads. C++20 adds
+// ::std::jthread, a thread which joins automatically on
+// destruction and which owns a ::std::stop_source that is
+// used to ask the thread to exit, and ::std::latch, a
+// single-use countdown that threads can wait on:
+//
+
+class thread_pool final
+{
+public:
+   explicit thread_pool
+      (
+      unsigned threads = ::std::thread::hardware_concurrency()
+      )
+   {
+      threads = ::std::max( threads, 1u );
+      
+      workers_.reserve( threads );
+      
+      for( unsigned index = 0; index < threads; ++index )
+      {
+         workers_.emplace_back
+            (
+            [this] (::std::stop_token stop)
+            {
+               this->work( stop );
+            }
+            )
+            ;
+      }
+   }
+   
+   thread_pool(thread_pool const &) = delete;
+   
+   thread_pool & operator= (thread_pool const &) = delete;
+   
+   ~thread_pool(void)
+   {
+      //
+      // Ask every worker to stop. The ::std::jthread
+      // destructors then join the workers:
+      //
+      
+      for( auto & worker : workers_ )
+      {
+         worker.request_stop();
+      }
+   }
+   
+   unsigned
+      size(void) const
+   {
+      return
+         static_cast<unsigned>( workers_.size() );
+   }
+   
+   //
+   // Calls function(index) for every index in [0, count)
+   // and blocks until all of the calls have returned. Every
+   // worker claims the next unclaimed index, so that slow
+   // chunks do not hold up the other workers. The first
+   // exception thrown by function, if any, is rethrown:
+   //
+   
+   template <typename Function>
+   void
+      for_each_index(::std::size_t count, Function && function)
+   {
+      if( count == 0 )
+      {
+         return;
+      }
+      
+      auto const
+         tasks = ::std::min <::std::size_t> ( count, workers_.size() );
+      
+      ::std::atomic <::std::size_t>
+         next { 0 };
+      
+      ::std::latch
+         done( static_cast<::std::ptrdiff_t>( tasks ) );
+      
+      ::std::exception_ptr
+         exception;
+      
+      ::std::mutex
+         exception_mutex;
+      
+      {
+      
+      ::std::scoped_lock
+         lock( mutex_ );
+      
+      for( ::std::size_t task = 0; task < tasks; ++task )
+      {
+         tasks_.emplace_back
+            (
+            [&]
+            {
+               try
+               {
+                  for
+                     (
+                     auto index = next.fetch_add( 1 );
+                     index < count;
+                     index = next.fetch_add( 1 )
+                     )
+                  {
+                     function( index );
+                  }
+               }
+               catch( ... )
+               {
+                  ::std::scoped_lock
+                     lock( exception_mutex );
+                  
+                  if( not exception )
+                  {
+                     exception = ::std::current_exception();
+                  }
+                  
+                  //
+                  // Stop the other workers claiming chunks:
+                  //
+                  
+                  next = count;
+               }
+               
+               done.count_down();
+            }
+            )
+            ;
+      }
+      
+      }
+      
+      condition_.notify_all();
+      
+      done.wait();
+      
+      if( exception )
+      {
+         ::std::rethrow_exception( exception );
+      }
+   }
+
+private:
+   void
+      work(::std::stop_token stop)
+   {
+      while( true )
+      {
+         ::std::function <void (void)>
+            task;
+         
+         {
+         
+         ::std::unique_lock
+            lock( mutex_ );
+         
+         //
+         // ::std::condition_variable_any can wait on a stop
+         // token. The wait returns false if a stop was
+         // requested:
+         //
+         
+         if
+            (
+            not condition_.wait
+               (
+               lock,
+               stop,
+               [this] { return not tasks_.empty(); }
+               )
+            )
+         {
+            return;
+         }
+         
+         task = ::std::move( tasks_.front() );
+         
+         tasks_.pop_front();
+         
+         }
+         
+         task();
+      }
+   }
+   
+   ::std::mutex
+      mutex_;
+   
+   ::std::condition_variable_any
+      condition_;
+   
+   ::std::deque< ::std::function <void (void)> >
+      tasks_;
+   
+   //
+   // Declared last, so that the workers are joined before
+   // the members that they use are destroyed:
+   //
+   
+   ::std::vector <::std::jthread>
+      workers_;
+}
+;
+
+namespace parallel
+{
+
+//
+// Chunks default to 256 KiB of input elements, which is
+// small enough to stay in a typical L2 cache while the
+// pipeline runs, and large enough to amortize the cost of
+// scheduling a chunk:
+//
+
+inline constexpr ::std::size_t
+   default_chunk_bytes = 256u * 1024u;
+
+template <typename R>
+concept
+   Chunkable =
+      ::std::ranges::random_access_range<R>
+      
+      and
+      
+      ::std::ranges::sized_range<R>
+         ;
+
+template <Chunkable R>
+struct chunks
+{
+   R &
+      range_;
+   
+   ::std::size_t
+      chunk_size_;
+   
+   ::std::size_t
+      size(void) const
+   {
+      return
+         ( ::std::ranges::size( range_ ) + chunk_size_ - 1 )
+            /
+         chunk_size_
+            ;
+   }
+   
+   auto
+      operator[] (::std::size_t index) const
+   {
+      auto const
+         size = ::std::ranges::size( range_ );
+      
+      auto const
+         first = ::std::ranges::begin( range_ );
+      
+      using
+         difference = ::std::ranges::range_difference_t<R>;
+      
+      return
+         ::std::ranges::subrange
+            (
+            first + static_cast<difference>( index * chunk_size_ ),
+            first
+               +
+            static_cast<difference>
+               (
+               ::std::min( size, ( index + 1 ) * chunk_size_ )
+               )
+            )
+            ;
+   }
+}
+;
+
+template <Chunkable R>
+chunks<R>
+   make_chunks(R & range, ::std::size_t chunk_bytes)
+{
+   return
+      {
+      range,
+      ::std::max <::std::size_t>
+         (
+         1u,
+         chunk_bytes / sizeof( ::std::ranges::range_value_t<R> )
+         )
+      }
+      ;
+}
+
+//
+// Calls function on every element of (range | pipeline).
+// The elements are references into the underlying range if
+// the pipeline preserves references (as filter does), so
+// the underlying data can be modified:
+//
+
+template <Chunkable R, typename Pipeline, typename Function>
+void
+for_each
+   (
+   thread_pool & pool,
+   R & range,
+   Pipeline const & pipeline,
+   Function function,
+   ::std::size_t chunk_bytes = default_chunk_bytes
+   )
+{
+   auto const
+      parts = make_chunks( range, chunk_bytes );
+   
+   pool.for_each_index
+      (
+      parts.size(),
+      [&] (::std::size_t index)
+      {
+         for( auto && element : parts[index] | pipeline )
+         {
+            function( element );
+         }
+      }
+      )
+      ;
+}
+
+//
+// Reduces the elements of (range | pipeline) with an
+// associative operation. Every chunk is reduced
+// separately, starting from its first element, and the
+// per-chunk results are then reduced in chunk order
+// starting from init:
+//
+
+template
+   <
+   Chunkable R,
+   typename Pipeline,
+   typename T,
+   typename Operation = ::std::plus<>
+   >
+T
+reduce
+   (
+   thread_pool & pool,
+   R & range,
+   Pipeline const & pipeline,
+   T init,
+   Operation operation = { },
+   ::std::size_t chunk_bytes = default_chunk_bytes
+   )
+{
+   auto const
+      parts = make_chunks( range, chunk_bytes );
+   
+   //
+   // A chunk in which the pipeline produces no elements
+   // (eg. everything is filtered out) has no result:
+   //
+   
+   ::std::vector< ::std::optional<T> >
+      partial( parts.size() );
+   
+   pool.for_each_index
+      (
+      parts.size(),
+      [&] (::std::size_t index)
+      {
+         ::std::optional<T>
+            result;
+         
+         for( auto && element : parts[index] | pipeline )
+         {
+            result =
+               result
+                  ? T( operation( ::std::move( *result ), element ) )
+                  : T( element )
+                     ;
+         }
+         
+         partial[index] = ::std::move( result );
+      }
+      )
+      ;
+   
+   for( auto & result : partial )
+   {
+      if( result )
+      {
+         init = operation( ::std::move( init ), ::std::move( *result ) );
+      }
+   }
+   
+   return
+      init;
+}
+
+//
+// Collects the elements of (range | pipeline) into a
+// vector, in the same order as a sequential evaluation.
+// Every chunk is collected into its own vector, and the
+// chunk vectors are then moved into the result in parallel
+// at offsets given by a prefix sum of the chunk sizes:
+//
+
+template <Chunkable R, typename Pipeline>
+auto
+collect
+   (
+   thread_pool & pool,
+   R & range,
+   Pipeline const & pipeline,
+   ::std::size_t chunk_bytes = default_chunk_bytes
+   )
+{
+   using
+      Chunk = decltype( make_chunks( range, chunk_bytes )[0] );
+   
+   using
+      Value =
+         ::std::ranges::range_value_t
+            <
+            decltype( ::std::declval<Chunk>() | pipeline )
+            >
+            ;
+   
+   auto const
+      parts = make_chunks( range, chunk_bytes );
+   
+   ::std::vector< ::std::vector<Value> >
+      partial( parts.size() );
+   
+   pool.for_each_index
+      (
+      parts.size(),
+      [&] (::std::size_t index)
+      {
+         for( auto && element : parts[index] | pipeline )
+         {
+            partial[index].emplace_back( element );
+         }
+      }
+      )
+      ;
+   
+   ::std::vector <::std::size_t>
+      offsets( partial.size() + 1, 0u );
+   
+   for( ::std::size_t index = 0; index < partial.size(); ++index )
+   {
+      offsets[index + 1] = offsets[index] + partial[index].size();
+   }
+   
+   ::std::vector<Value>
+      result( offsets.back() );
+   
+   pool.for_each_index
+      (
+      partial.size(),
+      [&] (::std::size_t index)
+      {
+         ::std::ranges::move
+            (
+            partial[index],
+            result.begin()
+               +
+            static_cast<::std::ptrdiff_t>( offsets[index] )
+            )
+            ;
+      }
+      )
+      ;
+   
+   return
+      result;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+   namespace views = ::std::ranges::views;
+   
+   auto const
+      is_odd = [] (int v) { return v % 2 == 1; };
+   
+   auto const
+      square = [] (int v) { return static_cast<long long>( v ) * v; };
+   
+   //
+   // Pipelines are range adaptor closures, composed without
+   // a range:
+   //
+   
+   auto const
+      pipeline = views::filter( is_odd ) | views::transform( square );
+   
+   thread_pool
+      pool;
+   
+   {
+   
+   ::std::vector<int>
+      items { 1, 2, 3, 4, 5, 6, 7 };
+   
+   //
+   // A parallel version of the filter/mutate loop from the
+   // ranges examples. A small chunk size is used so that
+   // the seven elements are split between several chunks:
+   //
+   
+   parallel::for_each
+      (
+      pool,
+      items,
+      views::filter( is_odd ),
+      [] (int & v) { v *= -v; },
+      2u * sizeof(int)
+      )
+      ;
+   
+   for( int v : items )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   ::std::vector<int>
+      items { 1, 2, 3, 4, 5, 6, 7 };
+   
+   //
+   // Reduction and ordered concatenation:
+   //
+   
+   [[maybe_unused]] auto const
+      sum =
+         parallel::reduce
+            (
+            pool, items, pipeline, 0ll, ::std::plus<>{ }, 2u * sizeof(int)
+            )
+            ;
+   
+   auto const
+      squares =
+         parallel::collect( pool, items, pipeline, 2u * sizeof(int) );
+   
+   assert( sum == 1 + 9 + 25 + 49 );
+   
+   assert
+      (
+      ::std::ranges::equal( squares, items | pipeline )
+      )
+      ;
+   
+   for( auto v : squares )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   //
+   // Scaling benchmark: reduce (items | pipeline) with 1, 2,
+   // 4, ... threads. The number of elements can be passed
+   // as the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 20'000'000u
+               ;
+   
+   ::std::vector<int>
+      items( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      items[index] = static_cast<int>( index % 1000u );
+   }
+   
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   long long
+      expected = 0;
+   
+   for( auto v : items | pipeline )
+   {
+      expected += v;
+   }
+   
+   auto const
+      sequential =
+         ::std::chrono::duration <double, ::std::milli>
+            (
+            ::std::chrono::steady_clock::now() - start
+            )
+            .count()
+               ;
+   
+   ::std::cout << "sequential: "
+               << sequential
+               << " ms (sum "
+               << expected
+               << ")"
+               << ::std::endl
+                  ;
+   
+   unsigned const
+      hardware = ::std::max( ::std::thread::hardware_concurrency(), 1u );
+   
+   for( unsigned threads = 1; ; threads *= 2 )
+   {
+      threads = ::std::min( threads, hardware );
+      
+      thread_pool
+         scaling_pool( threads );
+      
+      auto const
+         start = ::std::chrono::steady_clock::now();
+      
+      auto const
+         sum = parallel::reduce( scaling_pool, items, pipeline, 0ll );
+      
+      auto const
+         elapsed =
+            ::std::chrono::duration <double, ::std::milli>
+               (
+               ::std::chrono::steady_clock::now() - start
+               )
+               .count()
+                  ;
+      
+      assert( sum == expected );
+      
+      ::std::cout << threads
+                  << " thread(s): "
+                  << elapsed
+                  << " ms (sum "
+                  << sum
+                  << "), speed-up "
+                  << sequential / elapsed
+                  << ::std::endl
+                     ;
+      
+      if( threads == hardware )
+      {
+         break;
+      }
+   }
+   
+   }
+   
+   return 0;
+}
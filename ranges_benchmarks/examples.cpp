@@ -0,0 +1,930 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+//
+// How much do views cost compared with the loops they
+// replace? This program times every view used in the ranges
+// examples against an equivalent hand-written loop, for
+// several element types and sizes, and prints the results as
+// JSON, eg.:
+//
+//    {
+//    "instructions_available": true,
+//    "results":
+//       [
+//       { "view": "filter", "type": "int", "size": 65536, "implementation": "view", "ns_per_element": 0.93, "instructions_per_element": 4.1 },
+//       ...
+//       ]
+//    }
+//
+// Both implementations of a case compute the same checksum
+// of the elements they visit, which is checked, so that
+// neither can be optimised away. They are called through
+// function pointers, so that they are compiled separately
+// from the timing loop.
+//
+// Retired instructions are counted with a hardware
+// performance counter opened with perf_event_open(2) where
+// the kernel allows it (see
+// /proc/sys/kernel/perf_event_paranoid); otherwise, and on
+// other systems, instructions_per_element is null.
+//
+
+class instruction_counter final
+{
+public:
+   instruction_counter(void)
+   {
+#if __has_include(<linux/perf_event.h>)
+      ::perf_event_attr
+         attributes { };
+      
+      attributes.type = PERF_TYPE_HARDWARE;
+      
+      attributes.size = sizeof( attributes );
+      
+      attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+      
+      attributes.disabled = 1;
+      
+      attributes.exclude_kernel = 1;
+      
+      attributes.exclude_hv = 1;
+      
+      descriptor_ =
+         static_cast<int>( ::syscall( SYS_perf_event_open, &attributes, 0, -1, -1, 0 ) );
+#endif
+   }
+   
+   instruction_counter(instruction_counter const &) = delete;
+   
+   instruction_counter &
+      operator= (instruction_counter const &) = delete;
+   
+   ~instruction_counter(void)
+   {
+#if __has_include(<linux/perf_event.h>)
+      if( descriptor_ >= 0 )
+      {
+         ::close( descriptor_ );
+      }
+#endif
+   }
+   
+   bool
+      available(void) const
+   {
+      return
+         descriptor_ >= 0;
+   }
+   
+   void
+      start(void)
+   {
+#if __has_include(<linux/perf_event.h>)
+      if( descriptor_ >= 0 )
+      {
+         ::ioctl( descriptor_, PERF_EVENT_IOC_RESET, 0 );
+         
+         ::ioctl( descriptor_, PERF_EVENT_IOC_ENABLE, 0 );
+      }
+#endif
+   }
+   
+   ::std::uint64_t
+      stop(void)
+   {
+      ::std::uint64_t
+         count = 0u;
+
+#if __has_include(<linux/perf_event.h>)
+      if( descriptor_ >= 0 )
+      {
+         ::ioctl( descriptor_, PERF_EVENT_IOC_DISABLE, 0 );
+         
+         if( ::read( descriptor_, &count, sizeof( count ) ) != sizeof( count ) )
+         {
+            count = 0u;
+         }
+      }
+#endif
+      
+      return
+         count;
+   }
+
+private:
+   int
+      descriptor_ = -1;
+}
+;
+
+//
+// Integer checksums are unsigned, so that they wrap rather
+// than overflow:
+//
+
+template <typename T>
+struct checksum final
+{
+   using
+      type = T;
+}
+;
+
+template <::std::integral T>
+struct checksum<T> final
+{
+   using
+      type = ::std::make_unsigned_t<T>;
+}
+;
+
+template <typename T>
+using
+   checksum_t = typename checksum<T>::type;
+
+template <typename T>
+inline constexpr char const *
+   type_name = "";
+
+template <>
+inline constexpr char const *
+   type_name<int> = "int";
+
+template <>
+inline constexpr char const *
+   type_name<::std::int64_t> = "int64";
+
+template <>
+inline constexpr char const *
+   type_name<double> = "double";
+
+//
+// The inputs of the benchmarks. In flat, the first quarter
+// of the elements are below 1000 (for drop_while and
+// take_while), the others are 1000 or more, and every
+// 1000th element is a zero (for split):
+//
+
+template <typename T>
+struct data_set final
+{
+   explicit data_set(::std::size_t size)
+      : flat( size ), tuples( size ), pairs( size )
+   {
+      for( ::std::size_t index = 0; index < size; ++index )
+      {
+         auto const
+            value = static_cast<T>( index % 1000u + ( index >= size / 4u ? 1000u : 0u ) );
+         
+         flat[index] = index % 1000u == 0u ? T { 0 } : value;
+         
+         tuples[index] = { static_cast<int>( index ), value };
+         
+         pairs[index] = { value, static_cast<T>( index ) };
+      }
+      
+      for( ::std::size_t index = 0; index < size; index += 32u )
+      {
+         nested.emplace_back
+            (
+            flat.begin() + static_cast<::std::ptrdiff_t>( index ),
+            flat.begin() + static_cast<::std::ptrdiff_t>( ::std::min( size, index + 32u ) )
+            )
+            ;
+      }
+   }
+   
+   ::std::vector<T>
+      flat;
+   
+   ::std::vector< ::std::vector<T> >
+      nested;
+   
+   ::std::vector< ::std::tuple<int, T> >
+      tuples;
+   
+   ::std::vector< ::std::pair<T, T> >
+      pairs;
+}
+;
+
+template <typename T>
+struct benchmark_case final
+{
+   char const *
+      name;
+   
+   checksum_t<T>
+      (* view)(data_set<T> const &);
+   
+   checksum_t<T>
+      (* loop)(data_set<T> const &);
+}
+;
+
+template <typename T>
+constexpr bool
+is_even(T value)
+{
+   return
+      ( static_cast<::std::int64_t>( value ) & 1 ) == 0;
+}
+
+template <typename T>
+constexpr bool
+is_small(T value)
+{
+   return
+      value < T { 1000 };
+}
+
+template <typename T>
+constexpr T
+twice_plus_one(T value)
+{
+   return
+      value * T { 2 } + T { 1 };
+}
+
+template <typename T>
+::std::vector< benchmark_case<T> >
+benchmark_cases(void)
+{
+   namespace
+      views = ::std::views;
+   
+   using
+      C = checksum_t<T>;
+   
+   return
+      {
+         {
+            "reverse",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::reverse )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto index = data.flat.size(); index-- > 0u; )
+               {
+                  sum += static_cast<C>( data.flat[index] );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "drop",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::drop( data.flat.size() / 4u ) )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto index = data.flat.size() / 4u; index < data.flat.size(); ++index )
+               {
+                  sum += static_cast<C>( data.flat[index] );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "take",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::take( data.flat.size() / 2u ) )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( ::std::size_t index = 0; index < data.flat.size() / 2u; ++index )
+               {
+                  sum += static_cast<C>( data.flat[index] );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "iota",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto value : views::iota( ::std::size_t { 0 }, data.flat.size() ) )
+               {
+                  sum += static_cast<C>( static_cast<T>( value ) );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( ::std::size_t value = 0; value < data.flat.size(); ++value )
+               {
+                  sum += static_cast<C>( static_cast<T>( value ) );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "drop_while",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::drop_while( is_small<T> ) )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               ::std::size_t
+                  index = 0;
+               
+               while( index < data.flat.size() and is_small( data.flat[index] ) )
+               {
+                  ++index;
+               }
+               
+               for( ; index < data.flat.size(); ++index )
+               {
+                  sum += static_cast<C>( data.flat[index] );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "take_while",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::take_while( is_small<T> ) )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for
+                  (
+                  ::std::size_t index = 0;
+                  index < data.flat.size() and is_small( data.flat[index] );
+                  ++index
+                  )
+               {
+                  sum += static_cast<C>( data.flat[index] );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "transform",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::transform( twice_plus_one<T> ) )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat )
+               {
+                  sum += static_cast<C>( twice_plus_one( value ) );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "filter",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat | views::filter( is_even<T> ) )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat )
+               {
+                  if( is_even( value ) )
+                  {
+                     sum += static_cast<C>( value );
+                  }
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "join",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.nested | views::join )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto const & inner : data.nested )
+               {
+                  for( T value : inner )
+                  {
+                     sum += static_cast<C>( value );
+                  }
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "split",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto part : data.flat | views::split( T { 0 } ) )
+               {
+                  for( T value : part )
+                  {
+                     sum += static_cast<C>( value );
+                  }
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.flat )
+               {
+                  if( value != T { 0 } )
+                  {
+                     sum += static_cast<C>( value );
+                  }
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "elements",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.tuples | views::elements<1> )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto const & tuple : data.tuples )
+               {
+                  sum += static_cast<C>( ::std::get<1>( tuple ) );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "keys",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.pairs | views::keys )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto const & pair : data.pairs )
+               {
+                  sum += static_cast<C>( pair.first );
+               }
+               
+               return
+                  sum;
+            }
+         },
+         {
+            "values",
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( T value : data.pairs | views::values )
+               {
+                  sum += static_cast<C>( value );
+               }
+               
+               return
+                  sum;
+            },
+            
+            [] (data_set<T> const & data)
+            {
+               C
+                  sum { };
+               
+               for( auto const & pair : data.pairs )
+               {
+                  sum += static_cast<C>( pair.second );
+               }
+               
+               return
+                  sum;
+            }
+         }
+      }
+      ;
+}
+
+struct measurement final
+{
+   double
+      nanoseconds = ::std::numeric_limits<double>::infinity();
+   
+   double
+      instructions = ::std::numeric_limits<double>::infinity();
+}
+;
+
+//
+// The best per-element time and instruction count of a few
+// rounds, each of which runs the function often enough to
+// process about target elements:
+//
+
+template <typename T>
+measurement
+measure
+   (
+   checksum_t<T> (* function)(data_set<T> const &),
+   data_set<T> const & data,
+   ::std::size_t target,
+   instruction_counter & counter,
+   checksum_t<T> & checksum
+   )
+{
+   //
+   // An empty data set is counted as one element, so that
+   // neither the number of repetitions nor the time per
+   // element divides by zero:
+   //
+   
+   auto const
+      size = ::std::max <::std::size_t> ( 1u, data.flat.size() );
+   
+   auto const
+      repetitions = ::std::max <::std::size_t> ( 1u, target / size );
+   
+   measurement
+      best;
+   
+   for( int round = 0; round < 3; ++round )
+   {
+      checksum_t<T>
+         total { };
+      
+      counter.start();
+      
+      auto const
+         start = ::std::chrono::steady_clock::now();
+      
+      for( ::std::size_t repetition = 0; repetition < repetitions; ++repetition )
+      {
+         total += function( data );
+      }
+      
+      auto const
+         stop = ::std::chrono::steady_clock::now();
+      
+      auto const
+         instructions = counter.stop();
+      
+      checksum = total;
+      
+      auto const
+         elements = static_cast<double>( repetitions * size );
+      
+      best.nanoseconds =
+         ::std::min
+            (
+            best.nanoseconds,
+            ::std::chrono::duration <double, ::std::nano> ( stop - start ).count() / elements
+            )
+            ;
+      
+      best.instructions =
+         ::std::min( best.instructions, static_cast<double>( instructions ) / elements );
+   }
+   
+   return
+      best;
+}
+
+template <typename T>
+void
+run_benchmarks
+   (
+   ::std::vector<::std::size_t> const & sizes,
+   ::std::size_t target,
+   instruction_counter & counter,
+   bool & first
+   )
+{
+   for( auto size : sizes )
+   {
+      data_set<T> const
+         data( size );
+      
+      for( auto const & [ name, view, loop ] : benchmark_cases<T>() )
+      {
+         checksum_t<T>
+            view_checksum { },
+            loop_checksum { };
+         
+         auto const
+            results =
+               ::std::array
+                  {
+                  ::std::pair { "view", measure<T>( view, data, target, counter, view_checksum ) },
+                  ::std::pair { "loop", measure<T>( loop, data, target, counter, loop_checksum ) }
+                  }
+                  ;
+         
+         assert( view_checksum == loop_checksum );
+         
+         for( auto const & [ implementation, result ] : results )
+         {
+            ::std::cout << ( first ? "      " : ",\n      " )
+                        << "{ \"view\": \""
+                        << name
+                        << "\", \"type\": \""
+                        << type_name<T>
+                        << "\", \"size\": "
+                        << size
+                        << ", \"implementation\": \""
+                        << implementation
+                        << "\", \"ns_per_element\": "
+                        << result.nanoseconds
+                        << ", \"instructions_per_element\": "
+                           ;
+            
+            if( counter.available() )
+            {
+               ::std::cout << result.instructions;
+            }
+            else
+            {
+               ::std::cout << "null";
+            }
+            
+            ::std::cout << " }";
+            
+            first = false;
+         }
+      }
+   }
+}
+
+int main(int argc, char ** argv)
+{
+   //
+   // The largest size and the number of elements processed
+   // per measurement can be passed as the first and second
+   // command-line arguments:
+   //
+   
+   ::std::size_t const
+      largest =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 4'194'304u
+               ,
+      target =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 20'000'000u
+               ;
+   
+   ::std::vector<::std::size_t>
+      sizes;
+   
+   for( ::std::size_t size : { 1'024u, 65'536u } )
+   {
+      if( size < largest )
+      {
+         sizes.push_back( size );
+      }
+   }
+   
+   sizes.push_back( largest );
+   
+   instruction_counter
+      counter;
+   
+   bool
+      first = true;
+   
+   ::std::cout << "{\n   \"instructions_available\": "
+               << ( counter.available() ? "true" : "false" )
+               << ",\n   \"results\":\n      [\n"
+                  ;
+   
+   run_benchmarks<int>( sizes, target, counter, first );
+   
+   run_benchmarks<::std::int64_t>( sizes, target, counter, first );
+   
+   run_benchmarks<double>( sizes, target, counter, first );
+   
+   ::std::cout << "\n      ]\n}" << ::std::endl;
+   
+   return 0;
+}
@@ -0,0 +1,589 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <iterator>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <set>
+#include <new>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// C++20 has no way to turn a view back into a container:
+// ::std::ranges::to arrives in C++23. The usual workaround,
+//
+//    auto
+//       view = items | views::filter( is_odd );
+//
+//    ::std::vector<int>
+//       odd( view.begin(), view.end() );
+//
+// fails when the view is not a common range, and grows the
+// vector one reallocation at a time, because the iterators
+// of most views are not random-access and the vector cannot
+// know the size in advance.
+//
+// to<Container>(...) is a pipe closure which collects a
+// range into a container, and reserves its capacity first:
+//
+//    * if the range is sized, with its exact size;
+//    * if size_hint::counted is passed and the range is a
+//      forward range, with the size found by a counting
+//      pass over the range (worthwhile when the range is
+//      cheap to traverse and the elements are expensive to
+//      move, eg. a filter with a cheap predicate);
+//    * otherwise, not at all.
+//
+// The other arguments are passed to the constructor of the
+// container, eg. a ::std::pmr::memory_resource pointer for
+// a ::std::pmr::vector, so that the container allocates
+// from an arena. The container can be named in full,
+// to<::std::vector<long>>(), or as a template whose element
+// type is deduced from the range, to<::std::vector>().
+//
+
+enum class size_hint
+{
+   sized,
+   counted
+}
+;
+
+template <typename C>
+concept Reservable =
+   requires (C & container, ::std::size_t size)
+   {
+      container.reserve( size );
+      { container.capacity() } -> ::std::convertible_to<::std::size_t>;
+   }
+   ;
+
+template <typename C, typename T>
+concept BackInsertable =
+   requires (C & container, T && value)
+   {
+      container.push_back( ::std::forward<T>( value ) );
+   }
+   ;
+
+template <typename C, typename T>
+concept Insertable =
+   requires (C & container, T && value)
+   {
+      container.insert( container.end(), ::std::forward<T>( value ) );
+   }
+   ;
+
+//
+// Collects range into a container made from args:
+//
+
+template <typename C, ::std::ranges::input_range R, typename ... Args>
+   requires ::std::constructible_from<C, Args...>
+C
+collect(R && range, size_hint hint, Args && ... args)
+{
+   C
+      container( ::std::forward<Args>( args )... );
+   
+   if constexpr ( Reservable<C> )
+   {
+      if constexpr ( ::std::ranges::sized_range<R> )
+      {
+         container.reserve( static_cast<::std::size_t>( ::std::ranges::size( range ) ) );
+      }
+      else if constexpr ( ::std::ranges::forward_range<R> )
+      {
+         if( hint == size_hint::counted )
+         {
+            container.reserve( static_cast<::std::size_t>( ::std::ranges::distance( range ) ) );
+         }
+      }
+   }
+   
+   using
+      Reference = ::std::ranges::range_reference_t<R>;
+   
+   for( auto && element : range )
+   {
+      if constexpr ( BackInsertable<C, Reference> )
+      {
+         container.push_back( ::std::forward<decltype(element)>( element ) );
+      }
+      else
+      {
+         static_assert( Insertable<C, Reference>, "to: the container cannot be filled" );
+         
+         container.insert( container.end(), ::std::forward<decltype(element)>( element ) );
+      }
+   }
+   
+   return
+      container;
+}
+
+template <typename C, typename ... Args>
+class to_closure final
+{
+public:
+   explicit to_closure(size_hint hint, Args ... args)
+      : hint_( hint ), args_( ::std::move( args )... )
+   {
+   }
+   
+   template <::std::ranges::input_range R>
+   C
+      operator() (R && range) const
+   {
+      return
+         ::std::apply
+            (
+            [&] (Args const & ... args)
+            {
+               return
+                  collect<C>( ::std::forward<R>( range ), hint_, args... );
+            }
+            ,
+            args_
+            )
+            ;
+   }
+   
+   template <::std::ranges::input_range R>
+   friend C
+      operator| (R && range, to_closure const & closure)
+   {
+      return
+         closure( ::std::forward<R>( range ) );
+   }
+
+private:
+   size_hint
+      hint_;
+   
+   ::std::tuple<Args...>
+      args_;
+}
+;
+
+//
+// The closure for a container template deduces the element
+// type when it is applied to a range:
+//
+
+template <template <typename ...> typename C, typename ... Args>
+class to_template_closure final
+{
+public:
+   explicit to_template_closure(size_hint hint, Args ... args)
+      : hint_( hint ), args_( ::std::move( args )... )
+   {
+   }
+   
+   template <::std::ranges::input_range R>
+   auto
+      operator() (R && range) const
+   {
+      return
+         ::std::apply
+            (
+            [&] (Args const & ... args)
+            {
+               return
+                  collect< C< ::std::ranges::range_value_t<R> > >
+                     (
+                     ::std::forward<R>( range ), hint_, args...
+                     )
+                     ;
+            }
+            ,
+            args_
+            )
+            ;
+   }
+   
+   template <::std::ranges::input_range R>
+   friend auto
+      operator| (R && range, to_template_closure const & closure)
+   {
+      return
+         closure( ::std::forward<R>( range ) );
+   }
+
+private:
+   size_hint
+      hint_;
+   
+   ::std::tuple<Args...>
+      args_;
+}
+;
+
+template <typename C, typename ... Args>
+to_closure<C, ::std::decay_t<Args>...>
+to(size_hint hint, Args && ... args)
+{
+   return
+      to_closure<C, ::std::decay_t<Args>...>( hint, ::std::forward<Args>( args )... );
+}
+
+template <typename C>
+to_closure<C>
+to(void)
+{
+   return
+      to_closure<C>( size_hint::sized );
+}
+
+template <template <typename ...> typename C, typename ... Args>
+to_template_closure<C, ::std::decay_t<Args>...>
+to(size_hint hint, Args && ... args)
+{
+   return
+      to_template_closure<C, ::std::decay_t<Args>...>( hint, ::std::forward<Args>( args )... );
+}
+
+template <template <typename ...> typename C>
+to_template_closure<C>
+to(void)
+{
+   return
+      to_template_closure<C>( size_hint::sized );
+}
+
+//
+// Count the allocations made by the benchmarks:
+//
+
+namespace
+{
+
+::std::size_t
+   allocations = 0u;
+
+}
+
+void *
+operator new(::std::size_t size)
+{
+   ++allocations;
+   
+   if( auto pointer = ::std::malloc( size == 0u ? 1u : size ) )
+   {
+      return
+         pointer;
+   }
+   
+   throw
+      ::std::bad_alloc();
+}
+
+void *
+operator new(::std::size_t size, ::std::align_val_t alignment)
+{
+   ++allocations;
+   
+   auto const
+      align = static_cast<::std::size_t>( alignment );
+   
+   if( auto pointer = ::std::aligned_alloc( align, ( size + align - 1u ) / align * align ) )
+   {
+      return
+         pointer;
+   }
+   
+   throw
+      ::std::bad_alloc();
+}
+
+void
+operator delete(void * pointer) noexcept
+{
+   ::std::free( pointer );
+}
+
+void
+operator delete(void * pointer, ::std::size_t) noexcept
+{
+   ::std::free( pointer );
+}
+
+void
+operator delete(void * pointer, ::std::align_val_t) noexcept
+{
+   ::std::free( pointer );
+}
+
+void
+operator delete(void * pointer, ::std::size_t, ::std::align_val_t) noexcept
+{
+   ::std::free( pointer );
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+struct Person final
+{
+   ::std::string
+      id_;
+   
+   double
+      salary_;
+}
+;
+
+int main(int argc, char ** argv)
+{
+   namespace
+      views = ::std::views;
+   
+   {
+   
+   ::std::vector<int> const
+      items { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+   
+   auto const
+      is_odd = [] (int item) { return item % 2 != 0; };
+   
+   //
+   // The element type can be deduced:
+   //
+   
+   auto const
+      odd = items | views::filter( is_odd ) | to<::std::vector>();
+   
+   assert( ( odd == ::std::vector<int> { 1, 3, 5, 7, 9 } ) );
+   
+   //
+   // A view which is not a common range:
+   //
+   
+   auto const
+      squares =
+         views::iota( 1 )
+         |
+         views::transform( [] (int item) { return long { item } * item; } )
+         |
+         views::take_while( [] (long item) { return item < 50; } )
+         |
+         to<::std::vector<long>>()
+            ;
+   
+   assert( ( squares == ::std::vector<long> { 1, 4, 9, 16, 25, 36, 49 } ) );
+   
+   //
+   // Into a set, and into a vector allocated from an arena:
+   //
+   
+   auto const
+      unique = ::std::vector { 3, 1, 3, 2, 1 } | to<::std::set>();
+   
+   assert( ( unique == ::std::set { 1, 2, 3 } ) );
+   
+   ::std::pmr::monotonic_buffer_resource
+      arena;
+   
+   auto const
+      in_arena = items | views::reverse | to<::std::pmr::vector>( size_hint::sized, &arena );
+   
+   assert( in_arena.front() == 9 and in_arena.get_allocator().resource() == &arena );
+   
+   for( int v : odd )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark collecting people into vectors. The number
+   // of people can be passed as the first command-line
+   // argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 2'000'000u
+               ;
+   
+   ::std::vector<Person>
+      people( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      people[index] = { "p" + ::std::to_string( index ), static_cast<double>( index % 1000u ) };
+   }
+   
+   //
+   // The ids are short enough to be stored inside the
+   // strings, so the allocations counted are those of the
+   // vectors:
+   //
+   
+   auto const
+      is_well_paid = [] (Person const & person) { return person.salary_ >= 500.; };
+   
+   auto const
+      report =
+         [&] (char const * name, auto && collect_people)
+         {
+            ::std::size_t
+               count = 0u;
+            
+            auto const
+               before = allocations;
+            
+            auto const
+               time =
+                  milliseconds
+                     (
+                     [&]
+                     {
+                        count = collect_people().size();
+                     }
+                     )
+                     ;
+            
+            ::std::cout << "   "
+                        << name
+                        << time
+                        << " ms, "
+                        << allocations - before
+                        << " allocations for "
+                        << count
+                        << " people"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   ::std::cout << "copy all people:" << ::std::endl;
+   
+   report
+      (
+      "push_back loop:           ",
+      [&]
+      {
+         ::std::vector<Person>
+            copy;
+         
+         for( auto const & person : people | views::reverse )
+         {
+            copy.push_back( person );
+         }
+         
+         return
+            copy;
+      }
+      )
+      ;
+   
+   report
+      (
+      "to<vector>() (sized):     ",
+      [&] { return people | views::reverse | to<::std::vector>(); }
+      )
+      ;
+   
+   ::std::cout << "copy well-paid people:" << ::std::endl;
+   
+   report
+      (
+      "to<vector>():             ",
+      [&] { return people | views::filter( is_well_paid ) | to<::std::vector>(); }
+      )
+      ;
+   
+   report
+      (
+      "to<vector>(counted):      ",
+      [&]
+      {
+         return
+            people | views::filter( is_well_paid ) | to<::std::vector>( size_hint::counted );
+      }
+      )
+      ;
+   
+   {
+   
+   ::std::pmr::monotonic_buffer_resource
+      arena;
+   
+   report
+      (
+      "to<pmr::vector>(counted): ",
+      [&]
+      {
+         return
+            people
+            |
+            views::filter( is_well_paid )
+            |
+            to<::std::pmr::vector>( size_hint::counted, &arena )
+               ;
+      }
+      )
+      ;
+   
+   }
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,1315 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <ranges>
+#include <source_location>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+
+#include <iostream>
+
+//
+// The IsClock concept of the concepts examples:
+//
+
+template <typename T>
+concept IsClock = requires(T object, double parameter)
+{
+   object.start();
+   object.stop();
+   object.reset();
+   
+   ++object;
+   --object;
+   object += parameter;
+   
+   { object.time_now() } noexcept
+      ->
+         ::std::convertible_to
+            <
+            ::std::string
+            >
+            ;
+   
+   { T::resolution() }
+      ->
+         ::std::same_as
+            <
+            float
+            >
+            ;
+   
+   typename T::ClockResolutionType;
+   
+   requires
+      
+      ::std::default_initializable<T>
+      
+      and
+      
+      ::std::copy_constructible<T>
+         ;
+   
+   requires
+      (
+         sizeof( decltype( T::resolution() ) )
+         
+         <=
+         
+         sizeof( double )
+      )
+      ;
+}
+;
+
+//
+// A profiler needs to read raw timestamps, not only to time
+// intervals, so it takes clocks which also have a static,
+// noexcept ticks() and a tick rate:
+//
+
+template <typename T>
+concept IsProfilerClock =
+   IsClock<T>
+   
+   and
+   
+   requires
+   {
+      { T::ticks() } noexcept -> ::std::same_as<::std::uint64_t>;
+      { T::ticks_per_second() } -> ::std::convertible_to<double>;
+   }
+   ;
+
+//
+// A minimal clock over the x86 time stamp counter (see the
+// TSC clock example). As there, the counter is only used if
+// it is invariant, ticking at a constant rate on every
+// core; otherwise (or on other processors) the clock falls
+// back to CLOCK_MONOTONIC_RAW, in nanoseconds. Zones read
+// the counter without fences: a fence would order the read
+// with the profiled code, at a cost larger than the zones
+// themselves.
+//
+
+class tsc_clock final
+{
+public:
+   typedef
+      float
+      ClockResolutionType
+         ;
+   
+   void
+      start(void) noexcept
+   {
+      start_ = ticks();
+   }
+   
+   void
+      stop(void) noexcept
+   {
+      elapsed_ += ticks() - start_;
+   }
+   
+   void
+      reset(void) noexcept
+   {
+      elapsed_ = 0u;
+   }
+   
+   tsc_clock &
+      operator++ (void) noexcept
+   {
+      ++elapsed_;
+      
+      return
+         *this;
+   }
+   
+   tsc_clock &
+      operator-- (void) noexcept
+   {
+      --elapsed_;
+      
+      return
+         *this;
+   }
+   
+   tsc_clock &
+      operator+= (double seconds) noexcept
+   {
+      //
+      // Through a signed integer, as seconds may be negative:
+      //
+      
+      elapsed_ += static_cast<::std::uint64_t>( static_cast<::std::int64_t>( seconds * ticks_per_second() ) );
+      
+      return
+         *this;
+   }
+   
+   ::std::string
+      time_now(void) const noexcept
+   {
+      //
+      // Short enough for the small string optimisation:
+      //
+      
+      ::std::array<char, 15>
+         characters { };
+      
+      auto const
+         end =
+            ::std::to_chars
+               (
+               characters.data(),
+               characters.data() + characters.size(),
+               static_cast<double>( elapsed_ ) / ticks_per_second(),
+               ::std::chars_format::fixed,
+               6
+               )
+               .ptr
+                  ;
+      
+      return
+         ::std::string( characters.data(), end );
+   }
+   
+   static ClockResolutionType
+      resolution(void)
+   {
+      return
+         static_cast<ClockResolutionType>( 1. / ticks_per_second() );
+   }
+   
+   static ::std::uint64_t
+      ticks(void) noexcept
+   {
+#if defined(__x86_64__) || defined(__i386__)
+      if( uses_tsc() )
+      {
+         return
+            __rdtsc();
+      }
+#endif
+      
+      ::timespec
+         time { };
+      
+      ::clock_gettime( CLOCK_MONOTONIC_RAW, &time );
+      
+      return
+         static_cast<::std::uint64_t>( time.tv_sec ) * 1'000'000'000u
+         +
+         static_cast<::std::uint64_t>( time.tv_nsec );
+   }
+   
+   //
+   // Calibrated once, against steady_clock, over 20 ms. The
+   // fallback counts nanoseconds:
+   //
+   
+   static double
+      ticks_per_second(void)
+   {
+      static double const
+         rate =
+            [] (void)
+            {
+               if( not uses_tsc() )
+               {
+                  return
+                     1e9;
+               }
+               
+               auto const
+                  start_time = ::std::chrono::steady_clock::now();
+               
+               auto const
+                  start_ticks = ticks();
+               
+               while( ::std::chrono::steady_clock::now() - start_time < ::std::chrono::milliseconds( 20 ) )
+               {
+               }
+               
+               auto const
+                  stop_ticks = ticks();
+               
+               auto const
+                  seconds = ::std::chrono::duration<double>( ::std::chrono::steady_clock::now() - start_time ).count();
+               
+               return
+                  static_cast<double>( stop_ticks - start_ticks ) / seconds;
+            }
+            ()
+            ;
+      
+      return
+         rate;
+   }
+
+private:
+   //
+   // CPUID leaf 0x80000007, EDX bit 8, read once:
+   //
+   
+   static bool
+      uses_tsc(void) noexcept
+   {
+#if defined(__x86_64__) || defined(__i386__)
+      static bool const
+         invariant =
+            [] (void)
+            {
+               unsigned
+                  eax = 0u,
+                  ebx = 0u,
+                  ecx = 0u,
+                  edx = 0u;
+               
+               return
+                  ::__get_cpuid( 0x80000007u, &eax, &ebx, &ecx, &edx ) != 0
+                  
+                  and
+                  
+                  ( edx & ( 1u << 8u ) ) != 0u;
+            }
+            ()
+            ;
+      
+      return
+         invariant;
+#else
+      return
+         false;
+#endif
+   }
+   
+   ::std::uint64_t
+      start_ = 0u,
+      elapsed_ = 0u;
+}
+;
+
+static_assert( IsProfilerClock<tsc_clock> );
+
+//
+// profiler<Clock> records the zones entered by every
+// thread:
+//
+//    * A zone is an RAII object, scoped_zone, which records
+//      its name, its nesting depth and the ticks of its
+//      construction and destruction.
+//    * Every thread records into its own buffer, so that
+//      recording takes no lock and shares no cache line with
+//      other threads. A thread registers its buffer, under a
+//      mutex, the first time it enters a zone.
+//    * A buffer stores its records in fixed-size chunks,
+//      which never move. The chunks for the number of records
+//      reserved per thread are allocated, and their pages
+//      touched, when the buffer is registered, so that
+//      recording a zone neither copies records nor faults in
+//      pages until the reserve runs out.
+//    * The name of a zone is a pointer to a string with
+//      static storage duration: a string literal, or by
+//      default the name of the enclosing function from
+//      ::std::source_location.
+//
+// After the profiled threads have finished, the records are
+// merged into a call tree which gives, for every path of
+// nested zones, the number of calls, the total and the self
+// time (the total minus the time in nested zones), and a
+// histogram of durations. The tree can be exported in the
+// "folded stacks" format of flame graph tools, and the
+// records as a Chrome trace (chrome://tracing, Perfetto).
+//
+
+template <IsProfilerClock Clock>
+class profiler final
+{
+public:
+   struct record final
+   {
+      char const *
+         name;
+      
+      ::std::uint32_t
+         depth;
+      
+      ::std::uint64_t
+         begin,
+         end;
+   }
+   ;
+   
+   static constexpr ::std::size_t
+      chunk_size = 1u << 12u;
+   
+   struct thread_buffer final
+   {
+      //
+      // Value-initializing the chunks writes to, and so
+      // faults in, every page:
+      //
+      
+      explicit thread_buffer(::std::size_t reserve)
+         : chunks( ::std::max <::std::size_t> ( ( reserve + chunk_size - 1u ) / chunk_size, 1u ) )
+      {
+         for( auto & storage : chunks )
+         {
+            storage = ::std::make_unique<record[]>( chunk_size );
+         }
+         
+         next = chunks.front().get();
+         
+         last = next + chunk_size;
+      }
+      
+      record *
+         allocate(void)
+      {
+         if( next == last ) [[unlikely]]
+         {
+            this->grow();
+         }
+         
+         return
+            next++;
+      }
+      
+      ::std::size_t
+         size(void) const
+      {
+         return
+            chunk * chunk_size + static_cast<::std::size_t>( next - chunks[chunk].get() );
+      }
+      
+      //
+      // The records, in the order in which the zones were
+      // entered:
+      //
+      
+      auto
+         records(void) const
+      {
+         return
+            ::std::views::iota( ::std::size_t { 0u }, this->size() )
+               |
+            ::std::views::transform
+               (
+               [this] (::std::size_t index) -> record const &
+               {
+                  return
+                     chunks[ index / chunk_size ][ index % chunk_size ];
+               }
+               )
+               ;
+      }
+      
+      ::std::vector< ::std::unique_ptr<record[]> >
+         chunks;
+      
+      ::std::size_t
+         chunk = 0u;
+      
+      record
+         * next = nullptr,
+         * last = nullptr;
+      
+      ::std::uint32_t
+         depth = 0u,
+         thread = 0u;
+   
+   private:
+      void
+         grow(void)
+      {
+         if( ++chunk == chunks.size() )
+         {
+            chunks.push_back( ::std::make_unique<record[]>( chunk_size ) );
+         }
+         
+         next = chunks[chunk].get();
+         
+         last = next + chunk_size;
+      }
+   }
+   ;
+   
+   //
+   // Durations are counted in 64 power-of-two buckets of
+   // ticks:
+   //
+   
+   struct node final
+   {
+      char const *
+         name = "";
+      
+      ::std::uint64_t
+         count = 0u,
+         total = 0u,
+         self = 0u;
+      
+      ::std::array<::std::uint64_t, 64>
+         histogram { };
+      
+      ::std::vector<::std::size_t>
+         children { };
+   }
+   ;
+   
+   explicit profiler(::std::size_t reserve_per_thread = 1u << 16u)
+      : reserve_( reserve_per_thread ), id_( next_id_.fetch_add( 1u, ::std::memory_order_relaxed ) ), origin_( Clock::ticks() )
+   {
+   }
+   
+   profiler(profiler const &) = delete;
+   
+   profiler &
+      operator= (profiler const &) = delete;
+   
+   //
+   // The buffer of the calling thread. The last buffer used
+   // is cached in a thread_local with the id of its profiler,
+   // which, unlike its address, is never reused, so that the
+   // lookup is a comparison. The buffers of other profilers
+   // are found in a map, so that a thread alternating between
+   // profilers keeps one buffer, and its depth, per profiler.
+   // The map holds weak pointers, as the buffers belong to
+   // their profiler:
+   //
+   
+   thread_buffer &
+      buffer(void)
+   {
+      struct entry final
+      {
+         ::std::uint64_t
+            generation = 0u;
+         
+         ::std::weak_ptr<thread_buffer>
+            buffer;
+      }
+      ;
+      
+      struct cache final
+      {
+         ::std::uint64_t
+            owner = 0u,
+            generation = 0u;
+         
+         thread_buffer *
+            buffer = nullptr;
+         
+         ::std::unordered_map<::std::uint64_t, entry>
+            buffers;
+      }
+      ;
+      
+      thread_local cache
+         cached;
+      
+      auto const
+         generation = generation_.load( ::std::memory_order_acquire );
+      
+      if( cached.owner != id_ or cached.generation != generation ) [[unlikely]]
+      {
+         auto
+            buffer = cached.buffers[id_].buffer.lock();
+         
+         if( not buffer or cached.buffers[id_].generation != generation )
+         {
+            //
+            // The buffers of destroyed profilers have expired:
+            //
+            
+            ::std::erase_if( cached.buffers, [] (auto const & other) { return other.second.buffer.expired(); } );
+            
+            buffer = ::std::make_shared<thread_buffer>( reserve_ );
+            
+            {
+            
+            ::std::scoped_lock
+               lock( mutex_ );
+            
+            buffers_.push_back( buffer );
+            
+            buffer->thread = static_cast<::std::uint32_t>( buffers_.size() );
+            
+            }
+            
+            cached.buffers[id_] = { generation, buffer };
+         }
+         
+         cached.owner = id_;
+         
+         cached.generation = generation;
+         
+         cached.buffer = buffer.get();
+      }
+      
+      return
+         *cached.buffer;
+   }
+   
+   //
+   // Merges the records of every thread into a call tree.
+   // The profiled threads must not be in a zone. Node 0 is
+   // the root, which holds the threads' outermost zones:
+   //
+   
+   ::std::vector<node>
+      call_tree(void) const
+   {
+      ::std::vector<node>
+         tree( 1u );
+      
+      ::std::unordered_map< ::std::string_view, ::std::size_t >
+         lookup;
+      
+      for( auto const & buffer : buffers_ )
+      {
+         //
+         // The records of a thread are in the order in which
+         // the zones were entered, so the parent of a zone is
+         // the last zone entered at a lower depth:
+         //
+         
+         ::std::vector<::std::size_t>
+            path { 0u };
+         
+         for( auto const & [ name, depth, begin, end ] : buffer->records() )
+         {
+            path.resize( depth + 1u );
+            
+            auto const
+               parent = path.back();
+            
+            auto
+               child = ::std::ranges::find_if
+                  (
+                  tree[parent].children,
+                  [&] (::std::size_t index) { return ::std::string_view( tree[index].name ) == name; }
+                  )
+                  ;
+            
+            ::std::size_t
+               index = 0u;
+            
+            if( child == tree[parent].children.end() )
+            {
+               index = tree.size();
+               
+               tree.push_back( node { .name = name } );
+               
+               tree[parent].children.push_back( index );
+            }
+            else
+            {
+               index = *child;
+            }
+            
+            auto const
+               duration = end - begin;
+            
+            auto &
+               current = tree[index];
+            
+            ++current.count;
+            
+            current.total += duration;
+            
+            current.self += duration;
+            
+            //
+            // Durations of 2^63 ticks or more go to the last
+            // bucket:
+            //
+            
+            ++current.histogram[ ::std::min< ::std::size_t >( ::std::bit_width( duration ), current.histogram.size() - 1u ) ];
+            
+            if( parent != 0u )
+            {
+               tree[parent].self -= duration;
+            }
+            
+            path.push_back( index );
+         }
+      }
+      
+      return
+         tree;
+   }
+   
+   //
+   // One line per path of zones, with the self time of the
+   // path in microseconds, for flamegraph.pl or speedscope:
+   //
+   //    main;parse;lex 1234
+   //
+   
+   void
+      write_folded(::std::ostream & stream) const
+   {
+      auto const
+         tree = this->call_tree();
+      
+      ::std::string
+         path;
+      
+      auto const
+         visit =
+            [&] (auto const & self, ::std::size_t index) -> void
+            {
+               auto const
+                  length = path.size();
+               
+               if( index != 0u )
+               {
+                  path += ( length == 0u ? "" : ";" );
+                  
+                  path += tree[index].name;
+                  
+                  auto const
+                     microseconds =
+                        static_cast<::std::uint64_t>( to_microseconds( tree[index].self ) );
+                  
+                  if( microseconds > 0u )
+                  {
+                     stream << path << " " << microseconds << "\n";
+                  }
+               }
+               
+               for( auto child : tree[index].children )
+               {
+                  self( self, child );
+               }
+               
+               path.resize( length );
+            }
+            ;
+      
+      visit( visit, 0u );
+   }
+   
+   //
+   // Every record as a complete ("X") event of the Chrome
+   // trace event format:
+   //
+   
+   void
+      write_chrome_trace(::std::ostream & stream) const
+   {
+      stream << "{\"traceEvents\":[";
+      
+      bool
+         first = true;
+      
+      for( auto const & buffer : buffers_ )
+      {
+         for( auto const & [ name, depth, begin, end ] : buffer->records() )
+         {
+            stream << ( first ? "\n" : ",\n" )
+                   << "{\"name\":\""
+                      ;
+            
+            write_json_string( stream, name );
+            
+            stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                   << buffer->thread
+                   << ",\"ts\":"
+                   << to_microseconds( begin - origin_ )
+                   << ",\"dur\":"
+                   << to_microseconds( end - begin )
+                   << "}"
+                      ;
+            
+            first = false;
+         }
+      }
+      
+      stream << "\n]}\n";
+   }
+   
+   //
+   // An indented report of the call tree, with the median and
+   // the 99th percentile of the durations estimated from the
+   // histograms:
+   //
+   
+   void
+      write_report(::std::ostream & stream) const
+   {
+      auto const
+         tree = this->call_tree();
+      
+      auto const
+         visit =
+            [&] (auto const & self, ::std::size_t index, ::std::size_t depth) -> void
+            {
+               if( index != 0u )
+               {
+                  auto const &
+                     current = tree[index];
+                  
+                  stream << ::std::string( 3u * ( depth - 1u ), ' ' )
+                         << current.name
+                         << ": count "
+                         << current.count
+                         << ", total "
+                         << to_microseconds( current.total ) / 1000.
+                         << " ms, self "
+                         << to_microseconds( current.self ) / 1000.
+                         << " ms, p50 < "
+                         << percentile_bound( current, 0.5 )
+                         << " us, p99 < "
+                         << percentile_bound( current, 0.99 )
+                         << " us"
+                         << "\n"
+                            ;
+               }
+               
+               for( auto child : tree[index].children )
+               {
+                  self( self, child, depth + 1u );
+               }
+            }
+            ;
+      
+      visit( visit, 0u, 0u );
+   }
+   
+   //
+   // Discards every record; threads register again on their
+   // next zone. A thread may still be in a zone, whose record
+   // and buffer it holds, so the buffers are retired rather
+   // than destroyed: they are freed with the profiler:
+   //
+   
+   void
+      clear(void)
+   {
+      ::std::scoped_lock
+         lock( mutex_ );
+      
+      retired_.insert( retired_.end(), buffers_.begin(), buffers_.end() );
+      
+      buffers_.clear();
+      
+      generation_.fetch_add( 1u, ::std::memory_order_release );
+      
+      origin_ = Clock::ticks();
+   }
+
+private:
+   //
+   // A string of the trace, with quotes, backslashes and
+   // control characters escaped:
+   //
+   
+   static void
+      write_json_string(::std::ostream & stream, char const * text)
+   {
+      for( ; *text != '\0'; ++text )
+      {
+         auto const
+            character = static_cast<unsigned char>( *text );
+         
+         if( character == '"' or character == '\\' )
+         {
+            stream << '\\' << *text;
+         }
+         else if( character < 0x20u )
+         {
+            stream << "\\u00"
+                   << "0123456789abcdef"[ character >> 4u ]
+                   << "0123456789abcdef"[ character & 0xfu ]
+                      ;
+         }
+         else
+         {
+            stream << *text;
+         }
+      }
+   }
+   
+   static double
+      to_microseconds(::std::uint64_t ticks)
+   {
+      return
+         static_cast<double>( ticks ) * 1e6 / Clock::ticks_per_second();
+   }
+   
+   //
+   // The upper bound, in microseconds, of the histogram
+   // bucket which contains the given quantile:
+   //
+   
+   static double
+      percentile_bound(node const & current, double quantile)
+   {
+      auto const
+         target = static_cast<::std::uint64_t>( ::std::ceil( quantile * static_cast<double>( current.count ) ) );
+      
+      ::std::uint64_t
+         seen = 0u;
+      
+      for( ::std::size_t bucket = 0; bucket < current.histogram.size(); ++bucket )
+      {
+         seen += current.histogram[bucket];
+         
+         if( seen >= target )
+         {
+            return
+               to_microseconds( ::std::uint64_t { 1u } << bucket );
+         }
+      }
+      
+      return
+         to_microseconds( current.total );
+   }
+   
+   static inline ::std::atomic<::std::uint64_t>
+      next_id_ { 1u };
+   
+   ::std::size_t
+      reserve_;
+   
+   ::std::uint64_t const
+      id_;
+   
+   ::std::uint64_t
+      origin_;
+   
+   ::std::atomic<::std::uint64_t>
+      generation_ { 0u };
+   
+   ::std::mutex
+      mutex_;
+   
+   ::std::vector< ::std::shared_ptr<thread_buffer> >
+      buffers_,
+      retired_;
+}
+;
+
+//
+// A zone. It keeps a pointer to its record, as records
+// never move:
+//
+
+template <IsProfilerClock Clock>
+class scoped_zone final
+{
+public:
+   explicit scoped_zone
+      (
+      profiler<Clock> & owner,
+      char const * name = nullptr,
+      ::std::source_location where = ::std::source_location::current()
+      )
+      : buffer_( owner.buffer() ), record_( buffer_.allocate() )
+   {
+      *record_ =
+         {
+         name ? name : where.function_name(),
+         buffer_.depth++,
+         Clock::ticks(),
+         0u
+         }
+         ;
+   }
+   
+   scoped_zone(scoped_zone const &) = delete;
+   
+   scoped_zone &
+      operator= (scoped_zone const &) = delete;
+   
+   ~scoped_zone(void)
+   {
+      record_->end = Clock::ticks();
+      
+      --buffer_.depth;
+   }
+
+private:
+   typename profiler<Clock>::thread_buffer &
+      buffer_;
+   
+   typename profiler<Clock>::record *
+      record_;
+}
+;
+
+template <typename Clock>
+scoped_zone(profiler<Clock> &) -> scoped_zone<Clock>;
+
+template <typename Clock>
+scoped_zone(profiler<Clock> &, char const *) -> scoped_zone<Clock>;
+
+//
+// A small workload to profile:
+//
+
+profiler<tsc_clock>
+   workload_profiler;
+
+double
+lex(::std::size_t size)
+{
+   scoped_zone
+      zone( workload_profiler, "lex" );
+   
+   double
+      sum = 0.;
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      sum += ::std::sqrt( static_cast<double>( index ) );
+   }
+   
+   return
+      sum;
+}
+
+double
+parse(::std::size_t size)
+{
+   scoped_zone
+      zone( workload_profiler, "parse" );
+   
+   double
+      sum = lex( size );
+   
+   for( ::std::size_t index = 0; index < size / 2u; ++index )
+   {
+      sum += ::std::sin( static_cast<double>( index ) );
+   }
+   
+   return
+      sum;
+}
+
+double
+evaluate(::std::size_t size)
+{
+   //
+   // Named after the function by default:
+   //
+   
+   scoped_zone
+      zone( workload_profiler );
+   
+   return
+      ::std::log( parse( size ) + lex( size / 4u ) );
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   //
+   // Profile the workload on a few threads:
+   //
+   
+   {
+   
+   ::std::vector<::std::jthread>
+      threads;
+   
+   for( unsigned thread = 0; thread < 3u; ++thread )
+   {
+      threads.emplace_back
+         (
+         [thread]
+         {
+            scoped_zone
+               zone( workload_profiler, "worker" );
+            
+            for( ::std::size_t job = 0; job < 20u; ++job )
+            {
+               evaluate( 10'000u * ( job % 5u + 1u + thread ) );
+            }
+         }
+         )
+         ;
+   }
+   
+   }
+   
+   workload_profiler.write_report( ::std::cout );
+   
+   auto const
+      directory = ::std::filesystem::temp_directory_path();
+   
+   {
+   
+   ::std::ofstream
+      folded( directory / "profile.folded" );
+   
+   workload_profiler.write_folded( folded );
+   
+   ::std::ofstream
+      trace( directory / "profile.json" );
+   
+   workload_profiler.write_chrome_trace( trace );
+   
+   }
+   
+   ::std::cout << "flame graph input: "
+               << ( directory / "profile.folded" ).string()
+               << ::std::endl
+               << "Chrome trace:      "
+               << ( directory / "profile.json" ).string()
+               << ::std::endl
+                  ;
+   
+   auto const
+      tree = workload_profiler.call_tree();
+   
+   assert( tree[0].children.size() == 1u and tree[ tree[0].children[0] ].count == 3u );
+   
+   }
+   
+   {
+   
+   //
+   // Profilers built in turn at the same address do not
+   // share buffers:
+   //
+   
+   [[maybe_unused]] auto const
+      run =
+         [] (void)
+         {
+            profiler<tsc_clock>
+               local( 16u );
+            
+            {
+            
+            scoped_zone
+               zone( local, "local" );
+            
+            }
+            
+            return
+               local.call_tree().size();
+         }
+         ;
+   
+   assert( run() == 2u and run() == 2u );
+   
+   //
+   // A thread alternating between two profilers keeps its
+   // depth in each:
+   //
+   
+   profiler<tsc_clock>
+      outer_profiler( 16u ),
+      inner_profiler( 16u )
+         ;
+   
+   {
+   
+   scoped_zone
+      outer( outer_profiler, "outer" );
+   
+   {
+   
+   scoped_zone
+      inner( inner_profiler, "inner" );
+   
+   }
+   
+   scoped_zone
+      nested( outer_profiler, "nested" );
+   
+   }
+   
+   auto const
+      tree = outer_profiler.call_tree();
+   
+   assert( tree.size() == 3u and tree[ tree[0].children[0] ].children.size() == 1u );
+   
+   //
+   // Names are escaped in the Chrome trace:
+   //
+   
+   {
+   
+   scoped_zone
+      quoted( inner_profiler, "say \"hi\\\"" );
+   
+   }
+   
+   ::std::ostringstream
+      trace;
+   
+   inner_profiler.write_chrome_trace( trace );
+   
+   assert( trace.str().find( R"("name":"say \"hi\\\"")" ) != ::std::string::npos );
+   
+   //
+   // A thread which outgrows its reserve records into new
+   // chunks:
+   //
+   
+   ::std::size_t const
+      chunk_size = profiler<tsc_clock>::chunk_size;
+   
+   for( ::std::size_t zone = 0; zone < 3u * chunk_size; ++zone )
+   {
+      scoped_zone
+         repeated( outer_profiler, "repeated" );
+   }
+   
+   assert( outer_profiler.call_tree().back().count == 3u * chunk_size );
+   
+   //
+   // A zone which is open when its profiler is cleared ends
+   // in the retired buffer, and the next zone records into a
+   // new one:
+   //
+   
+   {
+   
+   scoped_zone
+      open( inner_profiler, "open" );
+   
+   inner_profiler.clear();
+   
+   }
+   
+   assert( inner_profiler.call_tree().size() == 1u );
+   
+   {
+   
+   scoped_zone
+      after( inner_profiler, "after" );
+   
+   }
+   
+   assert( inner_profiler.call_tree().size() == 2u );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark the cost of an empty zone. The number of
+   // zones can be passed as the first command-line
+   // argument:
+   //
+   
+   ::std::size_t const
+      zones =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 1'000'000u
+               ;
+   
+   profiler<tsc_clock>
+      overhead( zones );
+   
+   //
+   // Register the thread, which allocates and faults in the
+   // chunks for every zone, outside of the measurement:
+   //
+   
+   overhead.buffer();
+   
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   for( ::std::size_t zone = 0; zone < zones; ++zone )
+   {
+      scoped_zone
+         empty( overhead, "empty" );
+   }
+   
+   auto const
+      stop = ::std::chrono::steady_clock::now();
+   
+   //
+   // Two reads of the clock, the lower bound of a zone:
+   //
+   
+   [[maybe_unused]] ::std::uint64_t volatile
+      ticks = 0u;
+   
+   auto const
+      start_reads = ::std::chrono::steady_clock::now();
+   
+   for( ::std::size_t zone = 0; zone < zones; ++zone )
+   {
+      ticks = tsc_clock::ticks() - tsc_clock::ticks();
+   }
+   
+   auto const
+      stop_reads = ::std::chrono::steady_clock::now();
+   
+   ::std::cout << "nanoseconds per two clock reads: "
+               << ::std::chrono::duration <double, ::std::nano> ( stop_reads - start_reads ).count() / static_cast<double>( zones )
+               << ::std::endl
+                  ;
+   
+   ::std::cout << "nanoseconds per empty zone: "
+               << ::std::chrono::duration <double, ::std::nano> ( stop - start ).count() / static_cast<double>( zones )
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
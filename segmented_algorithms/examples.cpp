@@ -0,0 +1,492 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// views::join flattens a range of ranges:
+//
+//    ::std::vector <int> const
+//       elements[] { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+//
+//    for( int v : views::join( elements ) ) { ... }
+//
+// Every increment of a join_view iterator checks whether
+// the end of the current inner range has been reached, and
+// if so moves on to the next (non-empty) inner range. That
+// check prevents the compiler from vectorizing loops over
+// the joined range, even when every inner range is
+// contiguous.
+//
+// A join_view is a "segmented" range: it is made of
+// segments (the inner ranges), each of which can be
+// traversed with a tight loop. The algorithms below
+// recognize join_views by their type, run the ordinary
+// algorithm over every segment in turn, and recurse if a
+// segment is itself segmented. Any other range is passed
+// to the ordinary algorithm unchanged.
+//
+
+namespace segmented
+{
+
+template <typename T>
+inline constexpr bool
+   is_join_view = false;
+
+template <typename V>
+inline constexpr bool
+   is_join_view< ::std::ranges::join_view <V> > = true;
+
+//
+// The segments of a join_view are reached through base(),
+// which copies the underlying view from an lvalue, and
+// moves it from an rvalue. A join_view of a view which
+// cannot be copied, such as the owning_view of
+// views::join( ::std::vector<...> { ... } ), is only
+// segmented when it is an rvalue; as an lvalue it goes to
+// the ordinary algorithm:
+//
+
+template <typename R>
+concept
+   SegmentedRange =
+      is_join_view< ::std::remove_cvref_t<R> >
+      
+      and
+      
+      requires(R && range)
+      {
+         ::std::forward<R>( range ).base();
+      }
+      ;
+
+//
+// Calls function on every segment of a (possibly nested)
+// segmented range, and on any other range as a whole:
+//
+
+template <::std::ranges::input_range R, typename Function>
+constexpr void
+for_each_segment(R && range, Function & function)
+{
+   if constexpr ( SegmentedRange<R> )
+   {
+      auto
+         outer = ::std::forward<R>( range ).base();
+      
+      for( auto && segment : outer )
+      {
+         for_each_segment( ::std::forward<decltype(segment)>( segment ), function );
+      }
+   }
+   else
+   {
+      function( range );
+   }
+}
+
+template <::std::ranges::input_range R, typename Function>
+constexpr Function
+for_each(R && range, Function function)
+{
+   auto
+      segment_function =
+         [&function] (auto && segment)
+         {
+            ::std::ranges::for_each( segment, ::std::ref( function ) );
+         }
+         ;
+   
+   for_each_segment( ::std::forward<R>( range ), segment_function );
+   
+   return
+      function;
+}
+
+template
+   <
+   ::std::ranges::input_range R,
+   ::std::weakly_incrementable Output
+   >
+constexpr Output
+copy(R && range, Output output)
+{
+   auto
+      segment_function =
+         [&output] (auto && segment)
+         {
+            output = ::std::ranges::copy( segment, ::std::move( output ) ).out;
+         }
+         ;
+   
+   for_each_segment( ::std::forward<R>( range ), segment_function );
+   
+   return
+      output;
+}
+
+template
+   <
+   ::std::ranges::input_range R,
+   typename T,
+   typename Operation = ::std::plus<>
+   >
+constexpr T
+accumulate(R && range, T init, Operation operation = { })
+{
+   auto
+      segment_function =
+         [&] (auto && segment)
+         {
+            init =
+               ::std::accumulate
+                  (
+                  ::std::ranges::begin( segment ),
+                  ::std::ranges::end( segment ),
+                  ::std::move( init ),
+                  operation
+                  )
+                  ;
+         }
+         ;
+   
+   for_each_segment( ::std::forward<R>( range ), segment_function );
+   
+   return
+      init;
+}
+
+//
+// The position of an element in a segmented range: the
+// iterator to its segment and the iterator to the element
+// within that segment. join_view does not allow its own
+// iterators to be constructed from these, so find returns
+// both. If the element is not found, segment is the end of
+// the outer range.
+//
+// The returned iterators must outlive the join_view that
+// they were found in, so find is only segmented if the
+// outer range is borrowed and its segments are lvalues.
+// Otherwise it returns an ordinary join_view iterator:
+//
+
+template <typename Outer, typename Inner>
+struct position
+{
+   Outer
+      segment;
+   
+   Inner
+      element;
+}
+;
+
+template <typename R>
+concept
+   SegmentedPositionRange =
+      SegmentedRange<R>
+      
+      and
+      
+      ::std::ranges::borrowed_range
+         <
+         decltype( ::std::declval<R &>().base() )
+         >
+      
+      and
+      
+      ::std::is_lvalue_reference_v
+         <
+         ::std::ranges::range_reference_t
+            <
+            decltype( ::std::declval<R &>().base() )
+            >
+         >
+         ;
+
+template <::std::ranges::input_range R, typename T>
+constexpr auto
+find(R && range, T const & value)
+{
+   if constexpr ( SegmentedPositionRange<R> )
+   {
+      auto
+         outer = range.base();
+      
+      using
+         Inner =
+            decltype
+               (
+               find( *::std::ranges::begin( outer ), value )
+               )
+               ;
+      
+      auto
+         segment = ::std::ranges::begin( outer );
+      
+      for( ; segment != ::std::ranges::end( outer ); ++segment )
+      {
+         auto &&
+            inner = *segment;
+         
+         auto
+            element = find( inner, value );
+         
+         if constexpr ( SegmentedPositionRange< decltype(inner) > )
+         {
+            if( element.segment != ::std::ranges::end( inner.base() ) )
+            {
+               return
+                  position< decltype(segment), Inner > { segment, element };
+            }
+         }
+         else if( element != ::std::ranges::end( inner ) )
+         {
+            return
+               position< decltype(segment), Inner > { segment, element };
+         }
+      }
+      
+      return
+         position< decltype(segment), Inner > { segment, { } };
+   }
+   else
+   {
+      return
+         ::std::ranges::find( ::std::forward<R>( range ), value );
+   }
+}
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   namespace views = ::std::ranges::views;
+   
+   {
+   
+   ::std::vector <int> const
+      elements[] { { 1, 2 }, { }, { 3, 4 }, { 5, 6 } };
+   
+   auto
+      joined = views::join( elements );
+   
+   segmented::for_each
+      (
+      joined,
+      [] (int v)
+      {
+         ::std::cout << v << " ";
+      }
+      )
+      ;
+   
+   ::std::cout << ::std::endl;
+   
+   assert( segmented::accumulate( joined, 0 ) == 21 );
+   
+   ::std::vector<int>
+      copied;
+   
+   segmented::copy( joined, ::std::back_inserter( copied ) );
+   
+   assert( ::std::ranges::equal( copied, joined ) );
+   
+   auto const
+      found = segmented::find( joined, 4 );
+   
+   assert( found.segment == ::std::ranges::begin( elements ) + 2 );
+   
+   assert( *found.element == 4 );
+   
+   auto const
+      missing = segmented::find( joined, 7 );
+   
+   assert( missing.segment == ::std::ranges::end( elements ) );
+   
+   }
+   
+   {
+   
+   //
+   // In a join of a join, the segments of the outer join
+   // are the innermost vectors:
+   //
+   
+   ::std::vector< ::std::vector< ::std::vector<int> > > const
+      nested { { { 1 }, { 2, 3 } }, { { 4, 5, 6 } } };
+   
+   auto
+      joined = nested | views::join | views::join;
+   
+   assert( segmented::accumulate( joined, 0 ) == 21 );
+   
+   //
+   // The outer range of this join is itself a join_view,
+   // which is not borrowed, so find returns an ordinary
+   // iterator:
+   //
+   
+   assert( *segmented::find( joined, 5 ) == 5 );
+   
+   }
+   
+   {
+   
+   //
+   // A join of an rvalue owns its vector. As an rvalue, it
+   // is segmented; as an lvalue, its owning_view cannot be
+   // copied out of it, so the ordinary algorithms run:
+   //
+   
+   using
+      nested = ::std::vector< ::std::vector<int> >;
+   
+   assert( segmented::accumulate( views::join( nested { { 1, 2 }, { 3 } } ), 0 ) == 6 );
+   
+   auto
+      owning = views::join( nested { { 1, 2 }, { 3 } } );
+   
+   assert( segmented::accumulate( owning, 0 ) == 6 and *segmented::find( owning, 3 ) == 3 );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark summing a join of vectors. The number of
+   // vectors and their size can be passed as the first two
+   // command-line arguments:
+   //
+   
+   ::std::size_t const
+      segments =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 1'000u
+               ,
+      segment_size =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 100'000u
+               ;
+   
+   ::std::vector< ::std::vector<int> >
+      elements( segments );
+   
+   for( auto & segment : elements )
+   {
+      segment.resize( segment_size );
+      
+      ::std::iota( segment.begin(), segment.end(), 0 );
+   }
+   
+   auto
+      joined = views::join( elements );
+   
+   long long
+      plain = 0,
+      fast = 0;
+   
+   auto const
+      plain_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( int v : joined )
+               {
+                  plain += v;
+               }
+            }
+            )
+            ;
+   
+   auto const
+      segmented_time =
+         milliseconds
+            (
+            [&]
+            {
+               fast = segmented::accumulate( joined, 0ll );
+            }
+            )
+            ;
+   
+   assert( plain == fast );
+   
+   ::std::cout << "sum of a join of "
+               << segments
+               << " vectors of "
+               << segment_size
+               << " ints:"
+               << ::std::endl
+               << "   join_view:           "
+               << plain_time
+               << " ms (sum "
+               << plain
+               << ")"
+               << ::std::endl
+               << "   segmented algorithm: "
+               << segmented_time
+               << " ms (sum "
+               << fast
+               << ")"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
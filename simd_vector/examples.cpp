@@ -0,0 +1,1326 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <iostream>
+
+//
+// The instruction set, and so the width of a native vector
+// register, is selected at compile time from the macros of
+// the compiler's target options (eg. -mavx2, -mavx512f or
+// -march=native):
+//
+
+#if defined(__AVX512F__)
+inline constexpr ::std::size_t
+   simd_register_bytes = 64u;
+#elif defined(__AVX__)
+inline constexpr ::std::size_t
+   simd_register_bytes = 32u;
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+inline constexpr ::std::size_t
+   simd_register_bytes = 16u;
+#else
+inline constexpr ::std::size_t
+   simd_register_bytes = 0u;
+#endif
+
+//
+// simd<T, N> is stored in a vector of the GCC and Clang
+// vector extensions, which the compiler lowers to the
+// instructions of the target, splitting vectors wider than
+// the registers. Other compilers, or SIMD_FORCE_SCALAR, use
+// arrays and loops:
+//
+
+#if ( defined(__GNUC__) || defined(__clang__) ) && !defined(SIMD_FORCE_SCALAR)
+#define SIMD_VECTOR_EXTENSIONS 1
+#else
+#define SIMD_VECTOR_EXTENSIONS 0
+#endif
+
+//
+// GCC warns that vectors wider than the registers of the
+// target are passed differently by different versions of
+// the compiler. The functions here are inline, so there is
+// no ABI to keep stable:
+//
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+//
+// The element types of simd: arithmetic types other than
+// bool, of 1, 2, 4 or 8 bytes, without cv-qualifiers:
+//
+
+template <typename T>
+concept SimdVectorizable =
+   ( ::std::integral<T> or ::std::floating_point<T> )
+   
+   and
+   
+   not ::std::same_as<T, bool>
+   
+   and
+   
+   ::std::same_as< T, ::std::remove_cv_t<T> >
+   
+   and
+   
+   ::std::has_single_bit( sizeof( T ) )
+   
+   and
+   
+   ( sizeof( T ) <= 8u )
+   ;
+
+//
+// The number of elements of T in a native register, or 1
+// without SIMD:
+//
+
+template <SimdVectorizable T>
+inline constexpr ::std::size_t
+   native_width = ::std::max< ::std::size_t >( simd_register_bytes / sizeof( T ), 1u );
+
+//
+// The lanes of a mask are signed integers of the size of
+// the elements, all ones when true and zero when false,
+// which is how vector comparisons return their results:
+//
+
+template <::std::size_t Size>
+struct mask_integer;
+
+template <>
+struct mask_integer<1u> { typedef ::std::int8_t type; };
+
+template <>
+struct mask_integer<2u> { typedef ::std::int16_t type; };
+
+template <>
+struct mask_integer<4u> { typedef ::std::int32_t type; };
+
+template <>
+struct mask_integer<8u> { typedef ::std::int64_t type; };
+
+template <typename T>
+using
+   mask_integer_t = typename mask_integer< sizeof( T ) >::type;
+
+template <typename T, ::std::size_t N>
+struct simd_storage final
+{
+#if SIMD_VECTOR_EXTENSIONS
+   typedef
+      T type __attribute__(( vector_size( N * sizeof( T ) ) ))
+         ;
+#else
+   typedef
+      ::std::array<T, N>
+      type
+         ;
+#endif
+}
+;
+
+template <typename T, ::std::size_t N>
+using
+   simd_storage_t = typename simd_storage<T, N>::type;
+
+//
+// Applies a function to every lane. With the vector
+// extensions, the function is applied to whole vectors:
+// the generic lambdas passed to it use operators which are
+// defined both for scalars and for vectors.
+//
+
+template <typename Result, typename Function, typename... Storages>
+Result
+lanewise(Function && function, Storages const & ... storages)
+{
+#if SIMD_VECTOR_EXTENSIONS
+   return
+      function( storages... );
+#else
+   Result
+      result;
+   
+   for( ::std::size_t lane = 0; lane < result.size(); ++lane )
+   {
+      result[lane] = function( storages[lane]... );
+   }
+   
+   return
+      result;
+#endif
+}
+
+template <SimdVectorizable T, ::std::size_t N = native_width<T>>
+   requires ( ::std::has_single_bit( N ) )
+class simd;
+
+//
+// The result of a comparison of simd<T, N>:
+//
+
+template <SimdVectorizable T, ::std::size_t N = native_width<T>>
+   requires ( ::std::has_single_bit( N ) )
+class simd_mask final
+{
+public:
+   typedef
+      simd_storage_t<mask_integer_t<T>, N>
+      storage_type
+         ;
+   
+   simd_mask(void) = default;
+   
+   explicit simd_mask(bool value)
+   {
+      for( ::std::size_t lane = 0; lane < N; ++lane )
+      {
+         lanes_[lane] = value ? -1 : 0;
+      }
+   }
+   
+   explicit simd_mask(storage_type lanes)
+      : lanes_( lanes )
+   {
+   }
+   
+   static constexpr ::std::size_t
+      size(void) noexcept
+   {
+      return
+         N;
+   }
+   
+   bool
+      operator[] (::std::size_t lane) const
+   {
+      return
+         lanes_[lane] != 0;
+   }
+   
+   storage_type const &
+      lanes(void) const noexcept
+   {
+      return
+         lanes_;
+   }
+   
+   //
+   // One bit per lane, lane 0 in the lowest bit, with a
+   // "movemask" instruction where there is one:
+   //
+   
+   ::std::uint64_t
+      bits(void) const
+      requires ( N <= 64u )
+   {
+      [[maybe_unused]] constexpr auto
+         bytes = N * sizeof( T );
+
+#if SIMD_VECTOR_EXTENSIONS && defined(__AVX2__)
+      if constexpr( bytes == 32u and sizeof( T ) != 2u )
+      {
+         auto const
+            vector = ::std::bit_cast<__m256i>( lanes_ );
+         
+         if constexpr( sizeof( T ) == 1u )
+         {
+            return
+               static_cast<::std::uint32_t>( _mm256_movemask_epi8( vector ) );
+         }
+         else if constexpr( sizeof( T ) == 4u )
+         {
+            return
+               static_cast<::std::uint32_t>( _mm256_movemask_ps( _mm256_castsi256_ps( vector ) ) );
+         }
+         else
+         {
+            return
+               static_cast<::std::uint32_t>( _mm256_movemask_pd( _mm256_castsi256_pd( vector ) ) );
+         }
+      }
+      else if constexpr( bytes == 64u and sizeof( T ) != 2u )
+      {
+         typedef
+            simd_mask<T, N / 2u>
+            half_mask
+               ;
+         
+         auto const
+            halves = ::std::bit_cast< ::std::array<typename half_mask::storage_type, 2> >( lanes_ );
+         
+         return
+            half_mask( halves[0] ).bits() | half_mask( halves[1] ).bits() << ( N / 2u );
+      }
+      else
+#endif
+#if SIMD_VECTOR_EXTENSIONS && defined(__SSE2__)
+      if constexpr( bytes == 16u and sizeof( T ) != 2u )
+      {
+         auto const
+            vector = ::std::bit_cast<__m128i>( lanes_ );
+         
+         if constexpr( sizeof( T ) == 1u )
+         {
+            return
+               static_cast<::std::uint32_t>( _mm_movemask_epi8( vector ) );
+         }
+         else if constexpr( sizeof( T ) == 4u )
+         {
+            return
+               static_cast<::std::uint32_t>( _mm_movemask_ps( _mm_castsi128_ps( vector ) ) );
+         }
+         else
+         {
+            return
+               static_cast<::std::uint32_t>( _mm_movemask_pd( _mm_castsi128_pd( vector ) ) );
+         }
+      }
+      else
+#endif
+      {
+         ::std::uint64_t
+            result = 0u;
+         
+         for( ::std::size_t lane = 0; lane < N; ++lane )
+         {
+            result |= static_cast<::std::uint64_t>( lanes_[lane] != 0 ) << lane;
+         }
+         
+         return
+            result;
+      }
+   }
+   
+   bool
+      any(void) const
+   {
+      return
+         bits() != 0u;
+   }
+   
+   bool
+      all(void) const
+   {
+      return
+         bits() == ( N == 64u ? ~::std::uint64_t { 0u } : ( ::std::uint64_t { 1u } << N ) - 1u );
+   }
+   
+   bool
+      none(void) const
+   {
+      return
+         not any();
+   }
+   
+   ::std::size_t
+      count(void) const
+   {
+      return
+         static_cast<::std::size_t>( ::std::popcount( bits() ) );
+   }
+   
+   //
+   // The index of the first true lane, or N:
+   //
+   
+   ::std::size_t
+      find_first_set(void) const
+   {
+      return
+         ::std::min< ::std::size_t >( static_cast<::std::size_t>( ::std::countr_zero( bits() ) ), N );
+   }
+   
+   friend simd_mask
+      operator& (simd_mask const & first, simd_mask const & second)
+   {
+      return
+         simd_mask( lanewise<storage_type>( [] (auto a, auto b) { return a & b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd_mask
+      operator| (simd_mask const & first, simd_mask const & second)
+   {
+      return
+         simd_mask( lanewise<storage_type>( [] (auto a, auto b) { return a | b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd_mask
+      operator^ (simd_mask const & first, simd_mask const & second)
+   {
+      return
+         simd_mask( lanewise<storage_type>( [] (auto a, auto b) { return a ^ b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd_mask
+      operator! (simd_mask const & mask)
+   {
+      return
+         simd_mask( lanewise<storage_type>( [] (auto a) { return ~a; }, mask.lanes_ ) );
+   }
+
+private:
+   storage_type
+      lanes_;
+}
+;
+
+//
+// A vector of N elements of type T. Operations which are
+// only meaningful for integers or for floating-point
+// numbers are constrained with ::std::integral and
+// ::std::floating_point:
+//
+
+template <SimdVectorizable T, ::std::size_t N>
+   requires ( ::std::has_single_bit( N ) )
+class simd final
+{
+public:
+   typedef
+      T
+      value_type
+         ;
+   
+   typedef
+      simd_mask<T, N>
+      mask_type
+         ;
+   
+   typedef
+      simd_storage_t<T, N>
+      storage_type
+         ;
+   
+   //
+   // Zero:
+   //
+   
+   simd(void)
+      : lanes_ { }
+   {
+   }
+   
+   //
+   // Broadcast:
+   //
+   
+   simd(T value)
+   {
+      for( ::std::size_t lane = 0; lane < N; ++lane )
+      {
+         lanes_[lane] = value;
+      }
+   }
+   
+   explicit simd(storage_type lanes)
+      : lanes_( lanes )
+   {
+   }
+   
+   //
+   // The elements generator( 0 ), ..., generator( N - 1 ):
+   //
+   
+   template <::std::invocable<::std::size_t> Generator>
+   explicit simd(Generator && generator)
+   {
+      for( ::std::size_t lane = 0; lane < N; ++lane )
+      {
+         lanes_[lane] = static_cast<T>( generator( lane ) );
+      }
+   }
+   
+   static constexpr ::std::size_t
+      size(void) noexcept
+   {
+      return
+         N;
+   }
+   
+   //
+   // Unaligned loads and stores of the first N elements of
+   // a span:
+   //
+   
+   static simd
+      load(::std::span<T const> elements)
+   {
+      assert( elements.size() >= N );
+      
+      simd
+         result;
+      
+      ::std::memcpy( &result.lanes_, elements.data(), sizeof( storage_type ) );
+      
+      return
+         result;
+   }
+   
+   void
+      store(::std::span<T> elements) const
+   {
+      assert( elements.size() >= N );
+      
+      ::std::memcpy( elements.data(), &lanes_, sizeof( storage_type ) );
+   }
+   
+   T
+      operator[] (::std::size_t lane) const
+   {
+      return
+         lanes_[lane];
+   }
+   
+   storage_type const &
+      lanes(void) const noexcept
+   {
+      return
+         lanes_;
+   }
+   
+   //
+   // Arithmetic:
+   //
+   
+   friend simd
+      operator+ (simd const & first, simd const & second)
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a + b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator- (simd const & first, simd const & second)
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a - b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator* (simd const & first, simd const & second)
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a * b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator/ (simd const & first, simd const & second)
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a / b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator- (simd const & value)
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a) { return -a; }, value.lanes_ ) );
+   }
+   
+   //
+   // Integers only:
+   //
+   
+   friend simd
+      operator% (simd const & first, simd const & second)
+      requires ::std::integral<T>
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a % b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator& (simd const & first, simd const & second)
+      requires ::std::integral<T>
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a & b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator| (simd const & first, simd const & second)
+      requires ::std::integral<T>
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a | b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator^ (simd const & first, simd const & second)
+      requires ::std::integral<T>
+   {
+      return
+         simd( lanewise<storage_type>( [] (auto a, auto b) { return a ^ b; }, first.lanes_, second.lanes_ ) );
+   }
+   
+   friend simd
+      operator<< (simd const & value, int shift)
+      requires ::std::integral<T>
+   {
+      return
+         simd( lanewise<storage_type>( [shift] (auto a) { return a << shift; }, value.lanes_ ) );
+   }
+   
+   friend simd
+      operator>> (simd const & value, int shift)
+      requires ::std::integral<T>
+   {
+      return
+         simd( lanewise<storage_type>( [shift] (auto a) { return a >> shift; }, value.lanes_ ) );
+   }
+   
+   simd &
+      operator+= (simd const & other)
+   {
+      return
+         *this = *this + other;
+   }
+   
+   simd &
+      operator-= (simd const & other)
+   {
+      return
+         *this = *this - other;
+   }
+   
+   simd &
+      operator*= (simd const & other)
+   {
+      return
+         *this = *this * other;
+   }
+   
+   simd &
+      operator/= (simd const & other)
+   {
+      return
+         *this = *this / other;
+   }
+   
+   //
+   // Comparisons return masks:
+   //
+   
+   friend mask_type
+      operator== (simd const & first, simd const & second)
+   {
+      return
+         compare( first, second, [] (auto a, auto b) { return a == b; } );
+   }
+   
+   friend mask_type
+      operator!= (simd const & first, simd const & second)
+   {
+      return
+         compare( first, second, [] (auto a, auto b) { return a != b; } );
+   }
+   
+   friend mask_type
+      operator< (simd const & first, simd const & second)
+   {
+      return
+         compare( first, second, [] (auto a, auto b) { return a < b; } );
+   }
+   
+   friend mask_type
+      operator<= (simd const & first, simd const & second)
+   {
+      return
+         compare( first, second, [] (auto a, auto b) { return a <= b; } );
+   }
+   
+   friend mask_type
+      operator> (simd const & first, simd const & second)
+   {
+      return
+         compare( first, second, [] (auto a, auto b) { return a > b; } );
+   }
+   
+   friend mask_type
+      operator>= (simd const & first, simd const & second)
+   {
+      return
+         compare( first, second, [] (auto a, auto b) { return a >= b; } );
+   }
+
+private:
+   template <typename Comparison>
+   static mask_type
+      compare(simd const & first, simd const & second, Comparison comparison)
+   {
+      typedef
+         typename mask_type::storage_type
+         mask_storage
+            ;
+
+#if SIMD_VECTOR_EXTENSIONS
+      return
+         mask_type( static_cast<mask_storage>( comparison( first.lanes_, second.lanes_ ) ) );
+#else
+      return
+         mask_type
+            (
+            lanewise<mask_storage>
+               (
+               [&] (T a, T b) -> mask_integer_t<T> { return comparison( a, b ) ? -1 : 0; },
+               first.lanes_,
+               second.lanes_
+               )
+            )
+            ;
+#endif
+   }
+   
+   storage_type
+      lanes_;
+}
+;
+
+//
+// The lanes of first where the mask is true, and of second
+// elsewhere:
+//
+
+template <SimdVectorizable T, ::std::size_t N>
+simd<T, N>
+select(simd_mask<T, N> const & mask, simd<T, N> const & first, simd<T, N> const & second)
+{
+   typedef
+      typename simd_mask<T, N>::storage_type
+      mask_storage
+         ;
+   
+   auto const
+      bits =
+         lanewise<mask_storage>
+            (
+            [] (auto m, auto a, auto b) { return ( m & a ) | ( ~m & b ); },
+            mask.lanes(),
+            ::std::bit_cast<mask_storage>( first.lanes() ),
+            ::std::bit_cast<mask_storage>( second.lanes() )
+            )
+            ;
+   
+   return
+      simd<T, N>( ::std::bit_cast<typename simd<T, N>::storage_type>( bits ) );
+}
+
+template <SimdVectorizable T, ::std::size_t N>
+simd<T, N>
+min(simd<T, N> const & first, simd<T, N> const & second)
+{
+   return
+      select( first < second, first, second );
+}
+
+template <SimdVectorizable T, ::std::size_t N>
+simd<T, N>
+max(simd<T, N> const & first, simd<T, N> const & second)
+{
+   return
+      select( first < second, second, first );
+}
+
+template <::std::floating_point T, ::std::size_t N>
+simd<T, N>
+sqrt(simd<T, N> const & value)
+{
+   return
+      simd<T, N>( [&] (::std::size_t lane) { return ::std::sqrt( value[lane] ); } );
+}
+
+//
+// The two halves of a vector:
+//
+
+template <::std::size_t Offset, SimdVectorizable T, ::std::size_t N>
+simd<T, N / 2u>
+half(simd<T, N> const & value)
+{
+#if SIMD_VECTOR_EXTENSIONS
+   return
+      [&] <::std::size_t... Lanes> (::std::index_sequence<Lanes...>)
+      {
+         return
+            simd<T, N / 2u>( __builtin_shufflevector( value.lanes(), value.lanes(), ( Offset + Lanes )... ) );
+      }
+      ( ::std::make_index_sequence<N / 2u>() )
+      ;
+#else
+   return
+      simd<T, N / 2u>( [&] (::std::size_t lane) { return value[ Offset + lane ]; } );
+#endif
+}
+
+//
+// Reduces the lanes with an associative operation, by
+// halving the vector: log2( N ) vector operations rather
+// than N - 1 scalar ones:
+//
+
+template <SimdVectorizable T, ::std::size_t N, typename Operation = ::std::plus<>>
+T
+reduce(simd<T, N> const & value, Operation operation = { })
+{
+   if constexpr( N == 1u )
+   {
+      return
+         value[0];
+   }
+   else
+   {
+      return
+         reduce( operation( half<0u>( value ), half<N / 2u>( value ) ), operation );
+   }
+}
+
+template <SimdVectorizable T, ::std::size_t N>
+T
+reduce_min(simd<T, N> const & value)
+{
+   return
+      reduce( value, [] (auto const & a, auto const & b) { return min( a, b ); } );
+}
+
+template <SimdVectorizable T, ::std::size_t N>
+T
+reduce_max(simd<T, N> const & value)
+{
+   return
+      reduce( value, [] (auto const & a, auto const & b) { return max( a, b ); } );
+}
+
+//
+// The lanes moved Shift lanes up, shifting in zeros:
+//
+
+template <::std::size_t Shift, SimdVectorizable T, ::std::size_t N>
+   requires ( Shift < N )
+simd<T, N>
+shift_lanes_up(simd<T, N> const & value)
+{
+#if SIMD_VECTOR_EXTENSIONS
+   return
+      [&] <::std::size_t... Lanes> (::std::index_sequence<Lanes...>)
+      {
+         typename simd<T, N>::storage_type const
+            zero { };
+         
+         return
+            simd<T, N>( __builtin_shufflevector( zero, value.lanes(), ( Lanes < Shift ? 0u : N + Lanes - Shift )... ) );
+      }
+      ( ::std::make_index_sequence<N>() )
+      ;
+#else
+   return
+      simd<T, N>( [&] (::std::size_t lane) { return lane < Shift ? T() : value[ lane - Shift ]; } );
+#endif
+}
+
+//
+// Every lane set to lane Lane of a vector, without moving it
+// through a scalar register:
+//
+
+template <::std::size_t Lane, SimdVectorizable T, ::std::size_t N>
+   requires ( Lane < N )
+simd<T, N>
+broadcast_lane(simd<T, N> const & value)
+{
+#if SIMD_VECTOR_EXTENSIONS
+   return
+      [&] <::std::size_t... Lanes> (::std::index_sequence<Lanes...>)
+      {
+         return
+            simd<T, N>( __builtin_shufflevector( value.lanes(), value.lanes(), ( Lanes * 0u + Lane )... ) );
+      }
+      ( ::std::make_index_sequence<N>() )
+      ;
+#else
+   return
+      simd<T, N>( value[Lane] );
+#endif
+}
+
+//
+// The inclusive prefix sums of the lanes, in log2( N )
+// shifts and additions:
+//
+
+template <SimdVectorizable T, ::std::size_t N, ::std::size_t Shift = 1u>
+simd<T, N>
+inclusive_scan(simd<T, N> const & value)
+{
+   if constexpr( Shift >= N )
+   {
+      return
+         value;
+   }
+   else
+   {
+      return
+         inclusive_scan<T, N, Shift * 2u>( value + shift_lanes_up<Shift>( value ) );
+   }
+}
+
+//
+// base[ indices[lane] ] for every lane. AVX2 and AVX-512
+// have gather instructions for 4- and 8-byte elements with
+// indices of the same size:
+//
+
+template <SimdVectorizable T, ::std::size_t N, ::std::integral Index>
+simd<T, N>
+gather(::std::span<T const> base, simd<Index, N> const & indices)
+{
+#if SIMD_VECTOR_EXTENSIONS && defined(__AVX2__)
+   if constexpr( sizeof( Index ) == sizeof( T ) and sizeof( T ) >= 4u and N * sizeof( T ) == 32u )
+   {
+      auto const
+         offsets = ::std::bit_cast<__m256i>( indices.lanes() );
+      
+      if constexpr( sizeof( T ) == 4u )
+      {
+         auto const
+            result = _mm256_i32gather_epi32( reinterpret_cast<int const *>( base.data() ), offsets, 4 );
+         
+         return
+            simd<T, N>( ::std::bit_cast<typename simd<T, N>::storage_type>( result ) );
+      }
+      else
+      {
+         auto const
+            result = _mm256_i64gather_epi64( reinterpret_cast<long long const *>( base.data() ), offsets, 8 );
+         
+         return
+            simd<T, N>( ::std::bit_cast<typename simd<T, N>::storage_type>( result ) );
+      }
+   }
+   else
+#endif
+#if SIMD_VECTOR_EXTENSIONS && defined(__AVX512F__)
+   if constexpr( sizeof( Index ) == sizeof( T ) and sizeof( T ) >= 4u and N * sizeof( T ) == 64u )
+   {
+      auto const
+         offsets = ::std::bit_cast<__m512i>( indices.lanes() );
+      
+      if constexpr( sizeof( T ) == 4u )
+      {
+         auto const
+            result = _mm512_i32gather_epi32( offsets, base.data(), 4 );
+         
+         return
+            simd<T, N>( ::std::bit_cast<typename simd<T, N>::storage_type>( result ) );
+      }
+      else
+      {
+         auto const
+            result = _mm512_i64gather_epi64( offsets, base.data(), 8 );
+         
+         return
+            simd<T, N>( ::std::bit_cast<typename simd<T, N>::storage_type>( result ) );
+      }
+   }
+   else
+#endif
+   {
+      return
+         simd<T, N>( [&] (::std::size_t lane) { return base[ static_cast<::std::size_t>( indices[lane] ) ]; } );
+   }
+}
+
+//
+// Kernels built on simd:
+//
+
+template <::std::floating_point T>
+T
+dot_product(::std::span<T const> first, ::std::span<T const> second)
+{
+   assert( first.size() == second.size() );
+   
+   using
+      vector = simd<T>;
+   
+   constexpr auto
+      width = vector::size();
+   
+   //
+   // Four accumulators hide the latency of the additions:
+   //
+   
+   ::std::array<vector, 4>
+      sums { };
+   
+   ::std::size_t
+      index = 0u;
+   
+   for( ; index + 4u * width <= first.size(); index += 4u * width )
+   {
+      for( ::std::size_t lane = 0; lane < 4u; ++lane )
+      {
+         sums[lane] += vector::load( first.subspan( index + lane * width ) ) * vector::load( second.subspan( index + lane * width ) );
+      }
+   }
+   
+   for( ; index + width <= first.size(); index += width )
+   {
+      sums[0] += vector::load( first.subspan( index ) ) * vector::load( second.subspan( index ) );
+   }
+   
+   auto
+      result = reduce( ( sums[0] + sums[1] ) + ( sums[2] + sums[3] ) );
+   
+   for( ; index < first.size(); ++index )
+   {
+      result += first[index] * second[index];
+   }
+   
+   return
+      result;
+}
+
+template <SimdVectorizable T>
+void
+prefix_sum(::std::span<T const> input, ::std::span<T> output)
+{
+   assert( input.size() <= output.size() );
+   
+   using
+      vector = simd<T>;
+   
+   constexpr auto
+      width = vector::size();
+   
+   vector
+      carry;
+   
+   ::std::size_t
+      index = 0u;
+   
+   for( ; index + width <= input.size(); index += width )
+   {
+      auto const
+         sums = inclusive_scan( vector::load( input.subspan( index ) ) ) + carry;
+      
+      sums.store( output.subspan( index ) );
+      
+      carry = broadcast_lane<width - 1u>( sums );
+   }
+   
+   auto
+      sum = carry[0];
+   
+   for( ; index < input.size(); ++index )
+   {
+      output[index] = sum += input[index];
+   }
+}
+
+//
+// The position of the first occurrence of a character, as
+// ::std::string_view::find, for string scanning:
+//
+
+::std::size_t
+find_character(::std::string_view text, char character)
+{
+   using
+      vector = simd<char>;
+   
+   constexpr auto
+      width = vector::size();
+   
+   vector const
+      target( character );
+   
+   ::std::size_t
+      index = 0u;
+   
+   for( ; index + width <= text.size(); index += width )
+   {
+      auto const
+         found = vector::load( ::std::span( text ).subspan( index ) ) == target;
+      
+      if( found.any() )
+      {
+         return
+            index + found.find_first_set();
+      }
+   }
+   
+   for( ; index < text.size(); ++index )
+   {
+      if( text[index] == character )
+      {
+         return
+            index;
+      }
+   }
+   
+   return
+      ::std::string_view::npos;
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+int main(int argc, char ** argv)
+{
+   ::std::cout << "native register: "
+               << simd_register_bytes
+               << " bytes, simd<float>: "
+               << simd<float>::size()
+               << " lanes"
+               << ::std::endl
+                  ;
+   
+   {
+   
+   //
+   // Arithmetic, masks and reductions:
+   //
+   
+   simd<int, 8>
+      numbers( [] (::std::size_t lane) { return static_cast<int>( lane ) - 3; } );
+   
+   auto const
+      negative = numbers < simd<int, 8>( 0 );
+   
+   assert( negative.count() == 3u and negative.bits() == 0b111u and negative.find_first_set() == 0u );
+   
+   assert( reduce( numbers ) == 4 and reduce_min( numbers ) == -3 and reduce_max( numbers ) == 4 );
+   
+   auto const
+      absolute = select( negative, -numbers, numbers );
+   
+   assert( reduce( absolute ) == 16 );
+   
+   assert( reduce( inclusive_scan( simd<int, 8>( 1 ) ) ) == 36 );
+   
+   assert( ( broadcast_lane<7u>( numbers ) == simd<int, 8>( numbers[7] ) ).all() );
+   
+   assert( ( ( numbers & simd<int, 8>( 1 ) ) == simd<int, 8>( 1 ) ).count() == 4u );
+   
+   auto const
+      roots = sqrt( simd<double, 4>( 16. ) );
+   
+   assert( reduce( roots ) == 16. );
+   
+   //
+   // The following do not compile, as % and sqrt are
+   // constrained to integers and to floating-point numbers:
+   //
+   //    simd<float>( 1.f ) % simd<float>( 2.f );
+   //    sqrt( simd<int>( 4 ) );
+   //
+   
+   ::std::vector<::std::int32_t>
+      table( 100 );
+   
+   ::std::iota( table.begin(), table.end(), 0 );
+   
+   auto const
+      squares = gather( ::std::span<::std::int32_t const>( table ), numbers * numbers );
+   
+   assert( reduce( squares ) == 44 );
+   
+   assert( find_character( "a line of text\nand another", '\n' ) == 14u );
+   
+   assert( find_character( "no new line", '\n' ) == ::std::string_view::npos );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmarks. The number of elements can be passed as
+   // the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 1u << 24u
+               ;
+   
+   ::std::mt19937
+      generator( 42 );
+   
+   ::std::uniform_real_distribution<float>
+      distribution( 0.f, 1.f );
+   
+   ::std::vector<float>
+      first( size ),
+      second( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      first[index] = distribution( generator );
+      second[index] = distribution( generator );
+   }
+   
+   float
+      scalar_result = 0.f,
+      simd_result = 0.f;
+   
+   auto const
+      scalar_time =
+         milliseconds
+            (
+            [&]
+            {
+               scalar_result = ::std::inner_product( first.begin(), first.end(), second.begin(), 0.f );
+            }
+            )
+            ;
+   
+   auto const
+      simd_time =
+         milliseconds
+            (
+            [&]
+            {
+               simd_result = dot_product( ::std::span<float const>( first ), ::std::span<float const>( second ) );
+            }
+            )
+            ;
+   
+   //
+   // Summed in float, one element after another, the scalar
+   // result loses precision as the sum grows; the lanes of
+   // the vectors add up smaller partial sums:
+   //
+   
+   auto const
+      exact = ::std::inner_product( first.begin(), first.end(), second.begin(), 0. );
+   
+   assert( ::std::abs( simd_result - exact ) <= 1e-3 * exact );
+   
+   
+   ::std::cout << "dot product of "
+               << size
+               << " floats: inner_product "
+               << scalar_time
+               << " ms (relative error "
+               << ::std::abs( scalar_result - exact ) / exact
+               << "), simd "
+               << simd_time
+               << " ms (relative error "
+               << ::std::abs( simd_result - exact ) / exact
+               << ")"
+               << ::std::endl
+                  ;
+   
+   ::std::vector<::std::uint32_t>
+      input( size ),
+      scalar_output( size ),
+      simd_output( size );
+   
+   for( auto & element : input )
+   {
+      element = static_cast<::std::uint32_t>( generator() );
+   }
+   
+   auto const
+      scalar_scan_time =
+         milliseconds
+            (
+            [&]
+            {
+               ::std::inclusive_scan( input.begin(), input.end(), scalar_output.begin() );
+            }
+            )
+            ;
+   
+   auto const
+      simd_scan_time =
+         milliseconds
+            (
+            [&]
+            {
+               prefix_sum( ::std::span<::std::uint32_t const>( input ), ::std::span<::std::uint32_t>( simd_output ) );
+            }
+            )
+            ;
+   
+   assert( scalar_output == simd_output );
+   
+   ::std::cout << "prefix sum of "
+               << size
+               << " uint32_t: inclusive_scan "
+               << scalar_scan_time
+               << " ms, simd "
+               << simd_scan_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,1056 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <concepts>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <iostream>
+
+//
+// POSIX memory mapping:
+//
+
+#include <sys/mman.h>
+
+class buffer_pool;
+
+//
+// The types of the elements of pooled buffers, which are
+// left uninitialized, as with make_unique_for_overwrite:
+//
+
+template <typename T>
+concept PoolElement =
+   ::std::is_trivially_default_constructible_v<T>
+   and ::std::is_trivially_destructible_v<T>
+   and alignof( T ) <= 64u
+   ;
+
+//
+// A buffer of count elements, which returns to its pool when
+// the lease is destroyed. Leases are moved, not copied, and
+// convert to spans, so that functions taking a
+// ::std::span<T> or a ::std::span<T const> take a lease:
+//
+
+template <PoolElement T>
+class lease final
+{
+public:
+   lease(void) noexcept = default;
+   
+   lease(lease && other) noexcept
+      : data_( ::std::exchange( other.data_, nullptr ) ),
+        size_( ::std::exchange( other.size_, 0u ) ),
+        pool_( ::std::exchange( other.pool_, nullptr ) ),
+        size_class_( other.size_class_ )
+   {
+   }
+   
+   lease &
+      operator= (lease && other) noexcept
+   {
+      if( this != &other )
+      {
+         reset();
+         
+         data_ = ::std::exchange( other.data_, nullptr );
+         
+         size_ = ::std::exchange( other.size_, 0u );
+         
+         pool_ = ::std::exchange( other.pool_, nullptr );
+         
+         size_class_ = other.size_class_;
+      }
+      
+      return
+         *this;
+   }
+   
+   ~lease(void)
+   {
+      reset();
+   }
+   
+   //
+   // Returns the buffer to the pool early:
+   //
+   
+   void
+      reset(void) noexcept;
+   
+   T *
+      data(void) const noexcept
+   {
+      return
+         data_;
+   }
+   
+   ::std::size_t
+      size(void) const noexcept
+   {
+      return
+         size_;
+   }
+   
+   bool
+      empty(void) const noexcept
+   {
+      return
+         size_ == 0u;
+   }
+   
+   T &
+      operator[] (::std::size_t index) const noexcept
+   {
+      return
+         data_[index];
+   }
+   
+   T *
+      begin(void) const noexcept
+   {
+      return
+         data_;
+   }
+   
+   T *
+      end(void) const noexcept
+   {
+      return
+         data_ + size_;
+   }
+   
+   ::std::span<T>
+      span(void) const noexcept
+   {
+      return
+         { data_, size_ };
+   }
+   
+   template <typename U>
+      requires ::std::convertible_to<T (*)[], U (*)[]>
+   operator ::std::span<U> (void) const noexcept
+   {
+      return
+         { data_, size_ };
+   }
+
+private:
+   friend buffer_pool;
+   
+   lease(T * data, ::std::size_t size, buffer_pool * pool, unsigned size_class) noexcept
+      : data_( data ), size_( size ), pool_( pool ), size_class_( size_class )
+   {
+   }
+   
+   T *
+      data_ = nullptr;
+   
+   ::std::size_t
+      size_ = 0u;
+   
+   buffer_pool *
+      pool_ = nullptr;
+   
+   unsigned
+      size_class_ = 0u;
+}
+;
+
+//
+// A pool of buffers in size classes of powers of two, from
+// 64 bytes to the size of a slab:
+//
+//    * Slabs are mapped from the system and each is cut into
+//      blocks of one size class. A block of 2^k bytes is at
+//      an offset which is a multiple of 2^k in its slab, so
+//      that buffers are aligned to their size up to the page
+//      size, and always to a cache line: buffers of different
+//      threads do not share cache lines.
+//    * Each thread has a cache of free blocks per size class,
+//      so that most acquisitions and releases are a push or
+//      a pop without synchronization. An empty cache takes
+//      half its capacity from the shared free list of the
+//      class, a full one gives half back, under the mutex of
+//      the class. A lease released on another thread returns
+//      to the cache of that thread, or to the free list of
+//      the class if the thread has no cache for the pool, so
+//      that releasing never allocates.
+//    * With huge_pages, slabs are of 2 MiB or more, and
+//      mapped from the reserved huge pages (MAP_HUGETLB) if
+//      there are any, or else aligned to 2 MiB and advised to
+//      be backed by transparent huge pages, to save TLB
+//      misses when touching many buffers.
+//    * Larger buffers are allocated with the aligned
+//      ::operator new.
+//    * Memory returns to the system when the pool is
+//      destroyed, after every lease.
+//
+
+class buffer_pool final
+{
+public:
+   static constexpr ::std::size_t
+      alignment = 64u;
+   
+   struct options
+   {
+      ::std::size_t
+         slab_size = ::std::size_t( 1u ) << 20u;
+      
+      bool
+         huge_pages = false;
+      
+      //
+      // The size of the blocks which a thread may cache per
+      // size class (at least 2 blocks, at most 64):
+      //
+      
+      ::std::size_t
+         thread_cache_bytes = ::std::size_t( 256u ) << 10u;
+   }
+   ;
+   
+   buffer_pool(void)
+      : buffer_pool( options { } )
+   {
+   }
+   
+   //
+   // Throws ::std::invalid_argument unless the slab size is a
+   // power of two from 4 KiB to 512 MiB:
+   //
+   
+   explicit buffer_pool(options const & settings)
+      : options_( settings ), id_( next_id_.fetch_add( 1u, ::std::memory_order_relaxed ) )
+   {
+      if( options_.huge_pages )
+      {
+         options_.slab_size = ::std::max( options_.slab_size, huge_page_size );
+      }
+      
+      if( not ::std::has_single_bit( options_.slab_size ) or options_.slab_size < 4096u or options_.slab_size > ( min_block_size << ( max_size_classes - 1u ) ) )
+      {
+         throw
+            ::std::invalid_argument( "buffer_pool: the slab size must be a power of two from 4 KiB to 512 MiB" );
+      }
+   }
+   
+   buffer_pool(buffer_pool const &) = delete;
+   
+   buffer_pool &
+      operator= (buffer_pool const &) = delete;
+   
+   //
+   // Every lease must have been released:
+   //
+   
+   ~buffer_pool(void)
+   {
+      for( auto const & slab : slabs_ )
+      {
+         ::munmap( slab.first, slab.second );
+      }
+   }
+   
+   //
+   // A buffer of count uninitialized elements. Throws
+   // ::std::bad_alloc if no slab can be mapped:
+   //
+   
+   template <PoolElement T>
+   lease<T>
+      acquire(::std::size_t count)
+   {
+      if( count == 0u )
+      {
+         return
+            { };
+      }
+      
+      if( count > ::std::numeric_limits<::std::size_t>::max() / sizeof( T ) )
+      {
+         throw
+            ::std::bad_array_new_length();
+      }
+      
+      auto const
+         bytes = count * sizeof( T );
+      
+      if( bytes > options_.slab_size )
+      {
+         return
+            { static_cast<T *>( ::operator new( bytes, ::std::align_val_t( alignment ) ) ), count, this, oversized };
+      }
+      
+      auto const
+         size_class = size_class_of( bytes );
+      
+      auto &
+         cached = cache().classes[size_class];
+      
+      if( cached.count == 0u ) [[unlikely]]
+      {
+         refill( size_class, cached );
+      }
+      
+      return
+         { static_cast<T *>( cached.blocks[ --cached.count ] ), count, this, size_class };
+   }
+   
+   ::std::size_t
+      slab_size(void) const noexcept
+   {
+      return
+         options_.slab_size;
+   }
+   
+   //
+   // The number of slabs mapped, and of those from the
+   // reserved huge pages:
+   //
+   
+   ::std::size_t
+      slab_count(void) const
+   {
+      ::std::scoped_lock
+         lock( slabs_mutex_ );
+      
+      return
+         slabs_.size();
+   }
+   
+   ::std::size_t
+      huge_page_slab_count(void) const
+   {
+      ::std::scoped_lock
+         lock( slabs_mutex_ );
+      
+      return
+         huge_page_slabs_;
+   }
+
+private:
+   template <PoolElement T>
+   friend class lease;
+   
+   static constexpr ::std::size_t
+      min_block_size = 64u,
+      max_size_classes = 24u,
+      max_cached_blocks = 64u,
+      huge_page_size = ::std::size_t( 2u ) << 20u
+         ;
+   
+   static constexpr unsigned
+      oversized = max_size_classes;
+   
+   //
+   // The free blocks of a size class in the cache of a
+   // thread, as a stack:
+   //
+   
+   struct cached_blocks
+   {
+      ::std::size_t
+         count = 0u;
+      
+      ::std::array<void *, max_cached_blocks>
+         blocks;
+   }
+   ;
+   
+   //
+   // The cache of a thread. Once the thread exits, the cache
+   // (with its blocks) goes to the next thread which uses
+   // the pool:
+   //
+   
+   struct thread_cache
+   {
+      ::std::atomic<bool>
+         in_use { true };
+      
+      ::std::array<cached_blocks, max_size_classes>
+         classes;
+   }
+   ;
+   
+   //
+   // The shared free list of a size class. Its capacity is
+   // kept at the number of blocks cut for the class, so that
+   // returning blocks to it never allocates:
+   //
+   
+   struct size_class_list
+   {
+      ::std::mutex
+         mutex;
+      
+      ::std::vector<void *>
+         free;
+      
+      ::std::size_t
+         blocks = 0u;
+   }
+   ;
+   
+   static unsigned
+      size_class_of(::std::size_t bytes) noexcept
+   {
+      return
+         static_cast<unsigned>( ::std::bit_width( ( ::std::max( bytes, min_block_size ) - 1u ) / min_block_size ) );
+   }
+   
+   ::std::size_t
+      block_size(unsigned size_class) const noexcept
+   {
+      return
+         min_block_size << size_class;
+   }
+   
+   ::std::size_t
+      cache_capacity(unsigned size_class) const noexcept
+   {
+      return
+         ::std::clamp( options_.thread_cache_bytes / block_size( size_class ), ::std::size_t( 2u ), max_cached_blocks );
+   }
+   
+   //
+   // The cache of the calling thread. The cache last used is
+   // held in a thread_local with the id of its pool, so that
+   // the lookup is a comparison; the id is unique to each
+   // pool, as addresses may be reused. A thread which
+   // alternates between pools changes caches each time:
+   //
+   
+   struct current_cache final
+   {
+      ::std::uint64_t
+         pool = 0u;
+      
+      ::std::shared_ptr<thread_cache>
+         cache;
+      
+      ~current_cache(void)
+      {
+         if( cache )
+         {
+            cache->in_use.store( false, ::std::memory_order_release );
+         }
+      }
+   }
+   ;
+   
+   static current_cache &
+      current(void) noexcept
+   {
+      thread_local current_cache
+         cached;
+      
+      return
+         cached;
+   }
+   
+   thread_cache &
+      cache(void)
+   {
+      auto &
+         cached = current();
+      
+      if( cached.pool != id_ ) [[unlikely]]
+      {
+         //
+         // Adopt the new cache before giving up the old one:
+         // if adopting throws, the thread still holds the
+         // cache of its previous pool, and both remain
+         // consistent:
+         //
+         
+         auto
+            adopted = adopt_cache();
+         
+         if( cached.cache )
+         {
+            cached.cache->in_use.store( false, ::std::memory_order_release );
+         }
+         
+         cached.cache = ::std::move( adopted );
+         
+         cached.pool = id_;
+      }
+      
+      return
+         *cached.cache;
+   }
+   
+   //
+   // A cache left by a thread, or else a new one:
+   //
+   
+   ::std::shared_ptr<thread_cache>
+      adopt_cache(void)
+   {
+      ::std::scoped_lock
+         lock( caches_mutex_ );
+      
+      for( auto const & cache : caches_ )
+      {
+         if( bool expected = false; cache->in_use.compare_exchange_strong( expected, true, ::std::memory_order_acquire ) )
+         {
+            return
+               cache;
+         }
+      }
+      
+      return
+         caches_.emplace_back( ::std::make_shared<thread_cache>() );
+   }
+   
+   void
+      refill(unsigned size_class, cached_blocks & cached)
+   {
+      auto &
+         list = lists_[size_class];
+      
+      ::std::scoped_lock
+         lock( list.mutex );
+      
+      if( list.free.empty() )
+      {
+         auto const
+            blocks = list.blocks + options_.slab_size / block_size( size_class );
+         
+         list.free.reserve( blocks );
+         
+         auto const
+            slab = static_cast<::std::byte *>( map_slab() );
+         
+         list.blocks = blocks;
+         
+         for( auto offset = options_.slab_size; offset != 0u; )
+         {
+            offset -= block_size( size_class );
+            
+            list.free.push_back( slab + offset );
+         }
+      }
+      
+      auto const
+         count = ::std::min( cache_capacity( size_class ) / 2u, list.free.size() );
+      
+      ::std::copy( list.free.end() - static_cast<::std::ptrdiff_t>( count ), list.free.end(), cached.blocks.begin() );
+      
+      list.free.resize( list.free.size() - count );
+      
+      cached.count = count;
+   }
+   
+   //
+   // Releasing does not allocate: a thread which has no cache
+   // for the pool returns the block to the shared free list
+   // rather than make a cache, and the free lists have the
+   // capacity for every block of their class:
+   //
+   
+   void
+      release(void * block, unsigned size_class) noexcept
+   {
+      if( size_class == oversized )
+      {
+         ::operator delete( block, ::std::align_val_t( alignment ) );
+         
+         return;
+      }
+      
+      auto &
+         list = lists_[size_class];
+      
+      auto const &
+         current_cache = current();
+      
+      if( current_cache.pool != id_ ) [[unlikely]]
+      {
+         ::std::scoped_lock
+            lock( list.mutex );
+         
+         list.free.push_back( block );
+         
+         return;
+      }
+      
+      auto &
+         cached = current_cache.cache->classes[size_class];
+      
+      if( cached.count == cache_capacity( size_class ) ) [[unlikely]]
+      {
+         auto const
+            count = cached.count / 2u;
+         
+         ::std::scoped_lock
+            lock( list.mutex );
+         
+         list.free.insert( list.free.end(), cached.blocks.begin() + static_cast<::std::ptrdiff_t>( cached.count - count ), cached.blocks.begin() + static_cast<::std::ptrdiff_t>( cached.count ) );
+         
+         cached.count -= count;
+      }
+      
+      cached.blocks[ cached.count++ ] = block;
+   }
+   
+   //
+   // Maps a slab, aligned to its size up to 2 MiB:
+   //
+   
+   void *
+      map_slab(void)
+   {
+      auto const
+         size = options_.slab_size;
+      
+      ::std::scoped_lock
+         lock( slabs_mutex_ );
+      
+      if( options_.huge_pages )
+      {
+         if( auto const address = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 ); address != MAP_FAILED )
+         {
+            ++huge_page_slabs_;
+            
+            return
+               slabs_.emplace_back( address, size ).first;
+         }
+      }
+      
+      //
+      // Maps the size plus the alignment, and unmaps what is
+      // before and after the aligned slab:
+      //
+      
+      auto const
+         slab_alignment = ::std::min( size, huge_page_size ),
+         mapped = size + slab_alignment
+            ;
+      
+      auto const
+         address = ::mmap( nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+      
+      if( address == MAP_FAILED )
+      {
+         throw
+            ::std::bad_alloc();
+      }
+      
+      auto const
+         first = reinterpret_cast<::std::uintptr_t>( address ),
+         aligned = ( first + slab_alignment - 1u ) & ~( slab_alignment - 1u )
+            ;
+      
+      if( aligned != first )
+      {
+         ::munmap( address, aligned - first );
+      }
+      
+      ::munmap( reinterpret_cast<void *>( aligned + size ), first + mapped - aligned - size );
+      
+      auto const
+         slab = reinterpret_cast<void *>( aligned );
+      
+      if( options_.huge_pages )
+      {
+         ::madvise( slab, size, MADV_HUGEPAGE );
+      }
+      
+      return
+         slabs_.emplace_back( slab, size ).first;
+   }
+   
+   static inline ::std::atomic<::std::uint64_t>
+      next_id_ { 1u };
+   
+   options
+      options_;
+   
+   ::std::uint64_t const
+      id_;
+   
+   ::std::array<size_class_list, max_size_classes>
+      lists_;
+   
+   ::std::mutex
+      caches_mutex_;
+   
+   ::std::vector< ::std::shared_ptr<thread_cache> >
+      caches_;
+   
+   mutable ::std::mutex
+      slabs_mutex_;
+   
+   ::std::vector< ::std::pair<void *, ::std::size_t> >
+      slabs_;
+   
+   ::std::size_t
+      huge_page_slabs_ = 0u;
+}
+;
+
+template <PoolElement T>
+void
+   lease<T>::reset(void) noexcept
+{
+   if( pool_ != nullptr )
+   {
+      pool_->release( data_, size_class_ );
+      
+      data_ = nullptr;
+      
+      size_ = 0u;
+      
+      pool_ = nullptr;
+   }
+   
+   return;
+}
+
+//
+// From the span examples, taking a lease as well as a
+// ::std::unique_ptr<unsigned[]>:
+//
+
+::std::size_t
+   size_of_array
+      (
+      ::std::span <unsigned const> const &
+         span
+      )
+{
+   return
+      span.size_bytes();
+}
+
+//
+// Times function, in nanoseconds:
+//
+
+template <typename Function>
+::std::uint32_t
+   nanoseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      static_cast<::std::uint32_t>( ::std::chrono::duration_cast<::std::chrono::nanoseconds>( ::std::chrono::steady_clock::now() - start ).count() );
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   buffer_pool
+      pool;
+   
+   auto
+      buffer = pool.acquire<unsigned>( 100u );
+   
+   assert( buffer.size() == 100u and reinterpret_cast<::std::uintptr_t>( buffer.data() ) % buffer_pool::alignment == 0u );
+   
+   assert( size_of_array( buffer ) == 400u );
+   
+   ::std::span<unsigned> const
+      span = buffer;
+   
+   ::std::ranges::fill( span, 7u );
+   
+   assert( buffer[99] == 7u );
+   
+   //
+   // A block of 512 bytes is aligned to 512 bytes:
+   //
+   
+   assert( reinterpret_cast<::std::uintptr_t>( buffer.data() ) % 512u == 0u );
+   
+   //
+   // A released block is reused by the same thread:
+   //
+   
+   [[maybe_unused]] auto const
+      address = buffer.data();
+   
+   buffer.reset();
+   
+   assert( buffer.empty() and buffer.data() == nullptr );
+   
+   buffer = pool.acquire<unsigned>( 128u );
+   
+   assert( buffer.data() == address );
+   
+   auto
+      moved = ::std::move( buffer );
+   
+   assert( buffer.data() == nullptr and moved.data() == address );
+   
+   //
+   // A larger size class, and a buffer larger than a slab:
+   //
+   
+   auto const
+      bytes = pool.acquire<::std::byte>( 3000u );
+   
+   auto const
+      large = pool.acquire<double>( pool.slab_size() );
+   
+   assert( reinterpret_cast<::std::uintptr_t>( bytes.data() ) % 4096u == 0u );
+   
+   assert( large.size() == pool.slab_size() and reinterpret_cast<::std::uintptr_t>( large.data() ) % buffer_pool::alignment == 0u );
+   
+   //
+   // A thread which exits leaves its cache to the next:
+   //
+   
+   for( int thread = 0; thread < 2; ++thread )
+   {
+      ::std::thread
+         (
+         [&]
+         {
+            auto const
+               small = pool.acquire<unsigned>( 16u );
+            
+            assert( small.size() == 16u );
+         }
+         )
+         .join();
+   }
+   
+   assert( pool.slab_count() == 3u );
+   
+   [[maybe_unused]] bool
+      thrown = false;
+   
+   try
+   {
+      buffer_pool const
+         invalid( buffer_pool::options { 3000u } );
+   }
+   catch( ::std::invalid_argument const & )
+   {
+      thrown = true;
+   }
+   
+   assert( thrown );
+   
+   }
+   
+   {
+   
+   //
+   // Every thread keeps 64 buffers and replaces a random
+   // one at each step, with a buffer of 64 bytes to 64 KiB
+   // (the size is log-uniform, so that smaller buffers are
+   // more frequent). The first and last elements are
+   // written, and checked before the buffer is released.
+   // The time of a step is the release of the old buffer,
+   // the allocation of the new one and the writes. 4 threads
+   // run 1M steps each, unless other counts are passed:
+   //
+   
+   ::std::size_t const
+      threads = argc > 1 ? ::std::strtoull( argv[1], nullptr, 10 ) : 4u,
+      steps = argc > 2 ? ::std::strtoull( argv[2], nullptr, 10 ) : 1'000'000u,
+      live = 64u
+         ;
+   
+   auto const
+      run =
+         [&] (char const * name, auto && allocate)
+         {
+            ::std::vector< ::std::vector<::std::uint32_t> >
+               latencies( threads );
+            
+            auto const
+               start = ::std::chrono::steady_clock::now();
+            
+            {
+            
+            ::std::vector<::std::jthread>
+               workers;
+            
+            for( ::std::size_t thread = 0; thread < threads; ++thread )
+            {
+               workers.emplace_back
+                  (
+                  [&, thread]
+                  {
+                     ::std::mt19937_64
+                        generator( thread + 1u );
+                     
+                     ::std::uniform_int_distribution<unsigned>
+                        shift( 4u, 14u ),
+                        slot( 0u, live - 1u )
+                           ;
+                     
+                     auto &
+                        latency = latencies[thread];
+                     
+                     latency.reserve( steps );
+                     
+                     ::std::vector< ::std::pair<decltype( allocate( 1u ) ), ::std::size_t> >
+                        buffers( live );
+                     
+                     for( ::std::size_t step = 0; step < steps; ++step )
+                     {
+                        auto const
+                           size = ( ::std::size_t( 1u ) << shift( generator ) ) + generator() % 16u;
+                        
+                        auto &
+                           [ buffer, count ] = buffers[ slot( generator ) ];
+                        
+                        assert( count == 0u or ( buffer[0] == count and buffer[ count - 1u ] == count ) );
+                        
+                        latency.push_back
+                           (
+                           nanoseconds
+                              (
+                              [&]
+                              {
+                                 buffer = allocate( size );
+                                 
+                                 buffer[0] = buffer[ size - 1u ] = static_cast<unsigned>( size );
+                              }
+                              )
+                           )
+                           ;
+                        
+                        count = size;
+                     }
+                  }
+                  )
+                  ;
+            }
+            
+            }
+            
+            auto const
+               seconds = ::std::chrono::duration<double>( ::std::chrono::steady_clock::now() - start ).count();
+            
+            ::std::vector<::std::uint32_t>
+               all;
+            
+            for( auto const & latency : latencies )
+            {
+               all.insert( all.end(), latency.begin(), latency.end() );
+            }
+            
+            auto const
+               percentile =
+                  [&] (double fraction)
+                  {
+                     auto const
+                        nth = all.begin() + static_cast<::std::ptrdiff_t>( fraction * static_cast<double>( all.size() - 1u ) );
+                     
+                     ::std::ranges::nth_element( all, nth );
+                     
+                     return
+                        *nth;
+                  }
+                  ;
+            
+            ::std::cout << name
+                        << ": "
+                        << static_cast<double>( all.size() ) / seconds / 1e6
+                        << "M allocations per second, p50 "
+                        << percentile( 0.5 )
+                        << " ns, p99 "
+                        << percentile( 0.99 )
+                        << " ns, p99.9 "
+                        << percentile( 0.999 )
+                        << " ns, max "
+                        << percentile( 1.0 )
+                        << " ns"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   ::std::cout << threads
+               << " threads, "
+               << steps
+               << " steps each"
+               << ::std::endl
+                  ;
+   
+   run( "make_unique", [] (::std::size_t size) { return ::std::make_unique<unsigned[]>( size ); } );
+   
+   run( "make_unique_for_overwrite", [] (::std::size_t size) { return ::std::make_unique_for_overwrite<unsigned[]>( size ); } );
+   
+   {
+   
+   buffer_pool
+      pool;
+   
+   run( "buffer_pool", [&] (::std::size_t size) { return pool.acquire<unsigned>( size ); } );
+   
+   }
+   
+   {
+   
+   buffer_pool
+      pool( buffer_pool::options { .huge_pages = true } );
+   
+   run( "buffer_pool with huge pages", [&] (::std::size_t size) { return pool.acquire<unsigned>( size ); } );
+   
+   ::std::cout << pool.slab_count()
+               << " slabs of 2 MiB, "
+               << pool.huge_page_slab_count()
+               << " of reserved huge pages"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   }
+   
+   return 0;
+}
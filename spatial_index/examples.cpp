@@ -0,0 +1,1069 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include <iostream>
+
+//
+// The Point of the spaceship operator examples:
+//
+
+struct Point
+{
+   int
+      x,
+      y
+      ;
+   
+   auto operator <=> (Point const & other) const = default;
+}
+;
+
+//
+// An axis-aligned rectangle, with inclusive bounds:
+//
+
+struct box
+{
+   Point
+      min,
+      max
+      ;
+   
+   bool
+      contains(Point const & point) const noexcept
+   {
+      return
+         point.x >= min.x and point.x <= max.x
+         and
+         point.y >= min.y and point.y <= max.y
+            ;
+   }
+   
+   bool
+      contains(box const & other) const noexcept
+   {
+      return
+         contains( other.min ) and contains( other.max );
+   }
+   
+   bool
+      intersects(box const & other) const noexcept
+   {
+      return
+         min.x <= other.max.x and other.min.x <= max.x
+         and
+         min.y <= other.max.y and other.min.y <= max.y
+            ;
+   }
+   
+   void
+      extend(Point const & point) noexcept
+   {
+      min = { ::std::min( min.x, point.x ), ::std::min( min.y, point.y ) };
+      max = { ::std::max( max.x, point.x ), ::std::max( max.y, point.y ) };
+   }
+   
+   static box
+      empty(void) noexcept
+   {
+      constexpr auto
+         lowest = ::std::numeric_limits<int>::lowest(),
+         highest = ::std::numeric_limits<int>::max();
+      
+      return
+         { { highest, highest }, { lowest, lowest } };
+   }
+}
+;
+
+//
+// Squared distances are computed in 64-bit integers, which
+// is exact for coordinates in [ -2^30, 2^30 ]:
+//
+
+::std::int64_t
+squared_distance(Point const & first, Point const & second) noexcept
+{
+   auto const
+      dx = static_cast<::std::int64_t>( first.x ) - second.x,
+      dy = static_cast<::std::int64_t>( first.y ) - second.y;
+   
+   return
+      dx * dx + dy * dy;
+}
+
+//
+// The smallest and the largest squared distance from a
+// point to the points of a box:
+//
+
+::std::int64_t
+squared_distance(Point const & point, box const & bounds) noexcept
+{
+   return
+      squared_distance
+         (
+         point,
+         Point { ::std::clamp( point.x, bounds.min.x, bounds.max.x ), ::std::clamp( point.y, bounds.min.y, bounds.max.y ) }
+         )
+         ;
+}
+
+::std::int64_t
+farthest_squared_distance(Point const & point, box const & bounds) noexcept
+{
+   return
+      squared_distance
+         (
+         point,
+         Point
+            {
+            //
+            // The differences can reach 2^31, so they are
+            // taken in 64 bits, as in squared_distance:
+            //
+            
+            ::std::int64_t { point.x } - bounds.min.x > ::std::int64_t { bounds.max.x } - point.x
+               ? bounds.min.x
+               : bounds.max.x,
+            ::std::int64_t { point.y } - bounds.min.y > ::std::int64_t { bounds.max.y } - point.y
+               ? bounds.min.y
+               : bounds.max.y
+            }
+         )
+         ;
+}
+
+//
+// The Morton (Z-order) code of a point interleaves the bits
+// of its coordinates, x in the even bits and y in the odd
+// ones. Points which are close in the plane mostly have
+// close codes. Flipping the sign bits maps the signed
+// coordinates onto unsigned ones in the same order. With
+// BMI2, pdep deposits the bits of a coordinate in every
+// other bit in one instruction:
+//
+
+::std::uint64_t
+morton_code(Point const & point) noexcept
+{
+   auto const
+      x = static_cast<::std::uint32_t>( point.x ) ^ 0x8000'0000u,
+      y = static_cast<::std::uint32_t>( point.y ) ^ 0x8000'0000u;
+
+#if defined(__BMI2__)
+   return
+      _pdep_u64( x, 0x5555'5555'5555'5555u ) | _pdep_u64( y, 0xAAAA'AAAA'AAAA'AAAAu );
+#else
+   auto const
+      spread =
+         [] (::std::uint64_t bits)
+         {
+            bits = ( bits | bits << 16u ) & 0x0000'FFFF'0000'FFFFu;
+            bits = ( bits | bits << 8u ) & 0x00FF'00FF'00FF'00FFu;
+            bits = ( bits | bits << 4u ) & 0x0F0F'0F0F'0F0F'0F0Fu;
+            bits = ( bits | bits << 2u ) & 0x3333'3333'3333'3333u;
+            bits = ( bits | bits << 1u ) & 0x5555'5555'5555'5555u;
+            
+            return
+               bits;
+         }
+         ;
+   
+   return
+      spread( x ) | spread( y ) << 1u;
+#endif
+}
+
+//
+// Calls function( begin, end ) on parts of [ 0, size ), one
+// part per thread:
+//
+
+template <typename Function>
+void
+parallel_for(::std::size_t size, Function function)
+{
+   auto const
+      threads = size < 65'536u ? 1u : ::std::max( ::std::thread::hardware_concurrency(), 1u );
+   
+   ::std::vector<::std::jthread>
+      workers;
+   
+   for( unsigned part = 0; part < threads; ++part )
+   {
+      workers.emplace_back( [&, part] { function( size * part / threads, size * ( part + 1u ) / threads ); } );
+   }
+}
+
+//
+// A static spatial index: a packed R-tree over points
+// sorted in Z-order.
+//
+//    * The points are stored in Z-order, so that the points
+//      under any node of the tree are contiguous.
+//    * Nodes have 16 children and are implicit: node i of a
+//      level has the children 16 i to 16 i + 15 of the level
+//      below, and the leaves of level 0 hold the points 16 i
+//      to 16 i + 15. A level is an array of bounding boxes.
+//    * Queries descend from the root, skip the nodes whose
+//      box cannot contain results and report every point of
+//      a node whose box is contained in the query without
+//      testing the points.
+//    * The bulk build computes and sorts the Morton codes,
+//      and computes the leaves, in parallel.
+//
+
+class spatial_index final
+{
+public:
+   static constexpr ::std::size_t
+      fanout = 16u;
+   
+   explicit spatial_index(::std::span<Point const> points)
+   {
+      build( points );
+   }
+   
+   ::std::size_t
+      size(void) const noexcept
+   {
+      return
+         points_.size();
+   }
+   
+   ::std::span<Point const>
+      points(void) const noexcept
+   {
+      return
+         points_;
+   }
+   
+   //
+   // Calls function( point ) for every point in a box:
+   //
+   
+   template <::std::invocable<Point const &> Function>
+   void
+      for_each_in(box const & query, Function && function) const
+   {
+      search
+         (
+         [&] (box const & bounds) { return query.intersects( bounds ); },
+         [&] (box const & bounds) { return query.contains( bounds ); },
+         [&] (Point const & point) { return query.contains( point ); },
+         function
+         )
+         ;
+   }
+   
+   //
+   // Calls function( point ) for every point within a
+   // distance of a center:
+   //
+   
+   template <::std::invocable<Point const &> Function>
+   void
+      for_each_within(Point const & center, ::std::int64_t radius, Function && function) const
+   {
+      auto const
+         squared_radius = radius * radius;
+      
+      search
+         (
+         [&] (box const & bounds) { return squared_distance( center, bounds ) <= squared_radius; },
+         [&] (box const & bounds) { return farthest_squared_distance( center, bounds ) <= squared_radius; },
+         [&] (Point const & point) { return squared_distance( center, point ) <= squared_radius; },
+         function
+         )
+         ;
+   }
+   
+   ::std::size_t
+      count_in(box const & query) const
+   {
+      ::std::size_t
+         count = 0u;
+      
+      for_each_in( query, [&] (Point const &) { ++count; } );
+      
+      return
+         count;
+   }
+   
+   //
+   // The k nearest points, nearest first, by a best-first
+   // search: nodes and points are visited in the order of
+   // their smallest distance to the query, so the first k
+   // points visited are the nearest.
+   //
+   
+   ::std::vector<Point>
+      nearest(Point const & query, ::std::size_t k) const
+   {
+      struct candidate final
+      {
+         ::std::int64_t
+            distance;
+         
+         //
+         // A point when level is -1, a node otherwise:
+         //
+         
+         int
+            level;
+         
+         ::std::size_t
+            index;
+         
+         bool
+            operator> (candidate const & other) const noexcept
+         {
+            return
+               distance > other.distance;
+         }
+      }
+      ;
+      
+      ::std::vector<Point>
+         result;
+      
+      if( points_.empty() )
+      {
+         return
+            result;
+      }
+      
+      ::std::priority_queue< candidate, ::std::vector<candidate>, ::std::greater<> >
+         queue;
+      
+      auto const
+         root = static_cast<int>( levels_.size() ) - 1;
+      
+      queue.push( { squared_distance( query, levels_.back()[0] ), root, 0u } );
+      
+      while( not queue.empty() and result.size() < k )
+      {
+         auto const
+            [ distance, level, index ] = queue.top();
+         
+         queue.pop();
+         
+         if( level < 0 )
+         {
+            result.push_back( points_[index] );
+         }
+         else if( level == 0 )
+         {
+            for( auto point = index * fanout; point < ::std::min( ( index + 1u ) * fanout, points_.size() ); ++point )
+            {
+               queue.push( { squared_distance( query, points_[point] ), -1, point } );
+            }
+         }
+         else
+         {
+            auto const &
+               children = levels_[ level - 1 ];
+            
+            for( auto child = index * fanout; child < ::std::min( ( index + 1u ) * fanout, children.size() ); ++child )
+            {
+               queue.push( { squared_distance( query, children[child] ), level - 1, child } );
+            }
+         }
+      }
+      
+      return
+         result;
+   }
+
+private:
+   void
+      build(::std::span<Point const> points)
+   {
+      if( points.empty() )
+      {
+         return;
+      }
+      
+      //
+      // Sort the points by Morton code, each thread sorting
+      // one part, then merge the parts:
+      //
+      
+      ::std::vector< ::std::pair<::std::uint64_t, Point> >
+         coded( points.size() );
+      
+      ::std::vector< ::std::pair<::std::size_t, ::std::size_t> >
+         parts;
+      
+      ::std::mutex
+         parts_mutex;
+      
+      parallel_for
+         (
+         points.size(),
+         [&] (::std::size_t begin, ::std::size_t end)
+         {
+            for( auto index = begin; index < end; ++index )
+            {
+               coded[index] = { morton_code( points[index] ), points[index] };
+            }
+            
+            ::std::sort( coded.begin() + begin, coded.begin() + end );
+            
+            ::std::scoped_lock
+               lock( parts_mutex );
+            
+            parts.emplace_back( begin, end );
+         }
+         )
+         ;
+      
+      ::std::ranges::sort( parts );
+      
+      while( parts.size() > 1u )
+      {
+         ::std::vector< ::std::pair<::std::size_t, ::std::size_t> >
+            merged;
+         
+         {
+         
+         ::std::vector<::std::jthread>
+            workers;
+         
+         for( ::std::size_t part = 0; part + 1u < parts.size(); part += 2u )
+         {
+            workers.emplace_back
+               (
+               [&, part]
+               {
+                  ::std::inplace_merge
+                     (
+                     coded.begin() + parts[part].first,
+                     coded.begin() + parts[ part + 1u ].first,
+                     coded.begin() + parts[ part + 1u ].second
+                     )
+                     ;
+               }
+               )
+               ;
+            
+            merged.emplace_back( parts[part].first, parts[ part + 1u ].second );
+         }
+         
+         }
+         
+         if( parts.size() % 2u == 1u )
+         {
+            merged.push_back( parts.back() );
+         }
+         
+         parts.swap( merged );
+      }
+      
+      points_.resize( points.size() );
+      
+      //
+      // The points and the leaves, in parallel:
+      //
+      
+      auto &
+         leaves = levels_.emplace_back( ( points.size() + fanout - 1u ) / fanout, box::empty() );
+      
+      parallel_for
+         (
+         leaves.size(),
+         [&] (::std::size_t begin, ::std::size_t end)
+         {
+            for( auto leaf = begin; leaf < end; ++leaf )
+            {
+               for( auto index = leaf * fanout; index < ::std::min( ( leaf + 1u ) * fanout, points.size() ); ++index )
+               {
+                  points_[index] = coded[index].second;
+                  
+                  leaves[leaf].extend( points_[index] );
+               }
+            }
+         }
+         )
+         ;
+      
+      //
+      // The upper levels are 16 times smaller each:
+      //
+      
+      while( levels_.back().size() > 1u )
+      {
+         auto const &
+            children = levels_.back();
+         
+         ::std::vector<box>
+            parents( ( children.size() + fanout - 1u ) / fanout, box::empty() );
+         
+         for( ::std::size_t child = 0; child < children.size(); ++child )
+         {
+            parents[ child / fanout ].extend( children[child].min );
+            parents[ child / fanout ].extend( children[child].max );
+         }
+         
+         levels_.push_back( ::std::move( parents ) );
+      }
+   }
+   
+   //
+   // A depth-first search from the root. may_contain( box )
+   // prunes nodes, contains_all( box ) reports all the
+   // points of a node, and matches( point ) tests the
+   // points of the leaves otherwise:
+   //
+   
+   template <typename MayContain, typename ContainsAll, typename Matches, typename Function>
+   void
+      search(MayContain may_contain, ContainsAll contains_all, Matches matches, Function & function) const
+   {
+      if( points_.empty() )
+      {
+         return;
+      }
+      
+      auto const
+         visit =
+            [&] (auto const & self, ::std::size_t level, ::std::size_t index) -> void
+            {
+               auto const &
+                  bounds = levels_[level][index];
+               
+               if( not may_contain( bounds ) )
+               {
+                  return;
+               }
+               
+               //
+               // The points under node index of a level:
+               //
+               
+               auto
+                  span = fanout;
+               
+               for( ::std::size_t above = 0; above < level; ++above )
+               {
+                  span *= fanout;
+               }
+               
+               auto const
+                  first = index * span,
+                  last = ::std::min( first + span, points_.size() );
+               
+               if( contains_all( bounds ) )
+               {
+                  for( auto point = first; point < last; ++point )
+                  {
+                     function( points_[point] );
+                  }
+               }
+               else if( level == 0u )
+               {
+                  for( auto point = first; point < last; ++point )
+                  {
+                     if( matches( points_[point] ) )
+                     {
+                        function( points_[point] );
+                     }
+                  }
+               }
+               else
+               {
+                  auto const
+                     children = levels_[ level - 1u ].size();
+                  
+                  for( auto child = index * fanout; child < ::std::min( ( index + 1u ) * fanout, children ); ++child )
+                  {
+                     self( self, level - 1u, child );
+                  }
+               }
+            }
+            ;
+      
+      visit( visit, levels_.size() - 1u, 0u );
+   }
+   
+   ::std::vector<Point>
+      points_;
+   
+   //
+   // levels_[0] are the leaves, levels_.back() the root:
+   //
+   
+   ::std::vector< ::std::vector<box> >
+      levels_;
+}
+;
+
+//
+// The linear scans the index replaces:
+//
+
+::std::size_t
+scan_count_in(::std::span<Point const> points, box const & query)
+{
+   return
+      static_cast<::std::size_t>( ::std::ranges::count_if( points, [&] (Point const & point) { return query.contains( point ); } ) );
+}
+
+::std::vector<::std::int64_t>
+scan_nearest_distances(::std::span<Point const> points, Point const & query, ::std::size_t k)
+{
+   ::std::priority_queue<::std::int64_t>
+      nearest;
+   
+   for( auto const & point : points )
+   {
+      auto const
+         distance = squared_distance( query, point );
+      
+      if( nearest.size() < k )
+      {
+         nearest.push( distance );
+      }
+      else if( distance < nearest.top() )
+      {
+         nearest.pop();
+         
+         nearest.push( distance );
+      }
+   }
+   
+   ::std::vector<::std::int64_t>
+      result;
+   
+   for( ; not nearest.empty(); nearest.pop() )
+   {
+      result.push_back( nearest.top() );
+   }
+   
+   ::std::ranges::reverse( result );
+   
+   return
+      result;
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli> ( ::std::chrono::steady_clock::now() - start ).count();
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   assert( morton_code( { -1, -1 } ) < morton_code( { 0, 0 } ) and morton_code( { 0, 0 } ) == 0xC000'0000'0000'0000u );
+   
+   //
+   // At the ends of the coordinate range:
+   //
+   
+   [[maybe_unused]] int const
+      limit = 1 << 30;
+   
+   assert
+      (
+      farthest_squared_distance( { limit, 0 }, box { { -limit, 0 }, { limit, 0 } } )
+         ==
+      ::std::int64_t { 4 } * limit * limit
+      )
+      ;
+   
+   ::std::vector<Point> const
+      grid =
+         [] (void)
+         {
+            ::std::vector<Point>
+               points;
+            
+            for( int x = -50; x < 50; ++x )
+            {
+               for( int y = -50; y < 50; ++y )
+               {
+                  points.push_back( { x, y } );
+               }
+            }
+            
+            return
+               points;
+         }
+         ()
+         ;
+   
+   spatial_index const
+      index( grid );
+   
+   assert( index.count_in( { { 0, 0 }, { 9, 4 } } ) == 50u );
+   
+   ::std::size_t
+      within = 0u;
+   
+   index.for_each_within( { 0, 0 }, 1, [&] (Point const &) { ++within; } );
+   
+   assert( within == 5u );
+   
+   auto const
+      nearest = index.nearest( { 10, 10 }, 5u );
+   
+   assert( nearest.size() == 5u and nearest[0] == ( Point { 10, 10 } ) );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark queries against linear scans. The number of
+   // points and of queries can be passed as the first and
+   // second command-line arguments:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 4'000'000u
+               ;
+   
+   ::std::size_t const
+      queries =
+         ( argc > 2 )
+            ? ::std::strtoull( argv[2], nullptr, 10 )
+            : 10'000u
+               ;
+   
+   constexpr int
+      extent = 1 << 20;
+   
+   ::std::mt19937
+      generator( 42 );
+   
+   ::std::uniform_int_distribution<int>
+      coordinate( -extent, extent );
+   
+   ::std::vector<Point>
+      points( size );
+   
+   for( auto & point : points )
+   {
+      point = { coordinate( generator ), coordinate( generator ) };
+   }
+   
+   ::std::vector<Point>
+      centers( queries );
+   
+   for( auto & center : centers )
+   {
+      center = { coordinate( generator ), coordinate( generator ) };
+   }
+   
+   //
+   // Squares of 1/1000 of the width, and circles of the same
+   // area:
+   //
+   
+   constexpr int
+      half_side = extent / 1000;
+   
+   auto const
+      square =
+         [&] (Point const & center)
+         {
+            return
+               box { { center.x - half_side, center.y - half_side }, { center.x + half_side, center.y + half_side } };
+         }
+         ;
+   
+   ::std::int64_t const
+      radius = static_cast<::std::int64_t>( 2. * half_side / ::std::sqrt( 3.14159265358979 ) );
+   
+   ::std::optional<spatial_index>
+      index;
+   
+   auto const
+      build_time = milliseconds( [&] { index.emplace( points ); } );
+   
+   ::std::cout << "build of "
+               << size
+               << " points: "
+               << build_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   //
+   // Linear scans are much slower: run one for every 100
+   // queries, and check the results of the index against
+   // them. The results are kept, and both checksums are
+   // taken over the queries which the scans run, so that the
+   // work timed cannot be removed and the checksums printed
+   // can be compared:
+   //
+   
+   ::std::size_t const
+      scans = ::std::max< ::std::size_t >( queries / 100u, 1u );
+   
+   auto const
+      report =
+         [&]
+         (
+         char const * name,
+         double index_time,
+         ::std::int64_t index_checksum,
+         double scan_time,
+         ::std::int64_t scan_checksum
+         )
+         {
+            ::std::cout << name
+                        << ": index "
+                        << static_cast<double>( queries ) / index_time * 1e3
+                        << " queries per second (checksum "
+                        << index_checksum
+                        << "), linear scan "
+                        << static_cast<double>( scans ) / scan_time * 1e3
+                        << " (checksum "
+                        << scan_checksum
+                        << ")"
+                        << ::std::endl
+                           ;
+         }
+         ;
+   
+   {
+   
+   ::std::vector<::std::size_t>
+      counts( queries ),
+      scan_counts( scans );
+   
+   ::std::int64_t
+      index_checksum = 0,
+      scan_checksum = 0;
+   
+   auto const
+      index_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t query = 0; query < queries; ++query )
+               {
+                  counts[query] = index->count_in( square( centers[query] ) );
+               }
+            }
+            )
+            ;
+   
+   auto const
+      scan_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t query = 0; query < scans; ++query )
+               {
+                  scan_counts[query] = scan_count_in( points, square( centers[query] ) );
+                  
+                  scan_checksum += static_cast<::std::int64_t>( scan_counts[query] );
+               }
+            }
+            )
+            ;
+   
+   for( ::std::size_t query = 0; query < scans; ++query )
+   {
+      index_checksum += static_cast<::std::int64_t>( counts[query] );
+   }
+   
+   assert( ::std::ranges::equal( scan_counts, counts | ::std::views::take( scans ) ) );
+   
+   report( "rectangle", index_time, index_checksum, scan_time, scan_checksum );
+   
+   }
+   
+   {
+   
+   ::std::vector<::std::size_t>
+      counts( queries ),
+      scan_counts( scans );
+   
+   ::std::int64_t
+      index_checksum = 0,
+      scan_checksum = 0;
+   
+   auto const
+      index_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t query = 0; query < queries; ++query )
+               {
+                  index->for_each_within( centers[query], radius, [&] (Point const &) { ++counts[query]; } );
+               }
+            }
+            )
+            ;
+   
+   auto const
+      scan_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t query = 0; query < scans; ++query )
+               {
+                  scan_counts[query] =
+                     static_cast<::std::size_t>
+                        (
+                        ::std::ranges::count_if
+                           (
+                           points,
+                           [&] (Point const & point) { return squared_distance( centers[query], point ) <= radius * radius; }
+                           )
+                        )
+                        ;
+                  
+                  scan_checksum += static_cast<::std::int64_t>( scan_counts[query] );
+               }
+            }
+            )
+            ;
+   
+   for( ::std::size_t query = 0; query < scans; ++query )
+   {
+      index_checksum += static_cast<::std::int64_t>( counts[query] );
+   }
+   
+   assert( ::std::ranges::equal( scan_counts, counts | ::std::views::take( scans ) ) );
+   
+   report( "radius", index_time, index_checksum, scan_time, scan_checksum );
+   
+   }
+   
+   {
+   
+   constexpr ::std::size_t
+      k = 10u;
+   
+   ::std::vector< ::std::vector<Point> >
+      results( queries );
+   
+   ::std::vector< ::std::vector<::std::int64_t> >
+      scan_results( scans );
+   
+   ::std::int64_t
+      index_checksum = 0,
+      scan_checksum = 0;
+   
+   auto const
+      index_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t query = 0; query < queries; ++query )
+               {
+                  results[query] = index->nearest( centers[query], k );
+               }
+            }
+            )
+            ;
+   
+   auto const
+      scan_time =
+         milliseconds
+            (
+            [&]
+            {
+               for( ::std::size_t query = 0; query < scans; ++query )
+               {
+                  scan_results[query] = scan_nearest_distances( points, centers[query], k );
+                  
+                  for( auto const distance : scan_results[query] )
+                  {
+                     scan_checksum += distance;
+                  }
+               }
+            }
+            )
+            ;
+   
+   for( ::std::size_t query = 0; query < scans; ++query )
+   {
+      for( ::std::size_t neighbour = 0; neighbour < k; ++neighbour )
+      {
+         assert( squared_distance( centers[query], results[query][neighbour] ) == scan_results[query][neighbour] );
+      }
+      
+      for( auto const & neighbour : results[query] )
+      {
+         index_checksum += squared_distance( centers[query], neighbour );
+      }
+   }
+   
+   report( "10 nearest", index_time, index_checksum, scan_time, scan_checksum );
+   
+   }
+   
+   }
+   
+   return 0;
+}
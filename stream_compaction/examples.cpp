@@ -0,0 +1,700 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <ranges>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <iostream>
+
+//
+// ::std::ranges::copy_if branches on the predicate for
+// every element. When the predicate is true for, say, half
+// of the elements at random, the branch is mispredicted
+// about every other element, and each misprediction costs
+// 15-20 cycles.
+//
+// Stream compaction can be written without that branch: the
+// element is always written to the next output position, and
+// the output position is advanced by the result of the
+// predicate (0 or 1):
+//
+//    buffer[count] = element;
+//
+//    count += predicate( element );
+//
+// With SIMD instructions, the predicate is evaluated for a
+// block of elements into a bit mask, and the selected
+// elements are moved to the front of a vector register in
+// one instruction: a "compress" on AVX-512, or, on AVX2, a
+// permutation whose indices are looked up from the mask in
+// a table. The register is stored whole, and the output
+// position is advanced by the number of bits set in the
+// mask.
+//
+// Both write past the last selected element, so
+// ranges::compact compacts blocks of elements into a local
+// buffer and copies the selected elements from there to the
+// output: like copy_if, compact only requires room for the
+// selected elements in the output.
+//
+// The SIMD paths are used for contiguous ranges of 4- and
+// 8-byte trivially copyable elements (eg. int, float,
+// ::std::int64_t, double) when the program is compiled for
+// AVX2 or AVX-512 (eg. with -mavx2, -mavx512f or
+// -march=native); other trivially copyable elements use the
+// scalar, branch-free path, and any other elements
+// ::std::ranges::copy_if.
+//
+
+namespace ranges
+{
+
+//
+// The number of elements compacted into the local buffer
+// at a time:
+//
+
+inline constexpr ::std::size_t
+   compact_block = 256u;
+
+//
+// The bit mask of the elements of [first, first + Width)
+// which satisfy the predicate. The loop has no branches, so
+// the compiler can vectorize it for simple predicates:
+//
+
+template <::std::size_t Width, typename Iterator, typename Predicate, typename Projection>
+unsigned
+selection_mask(Iterator first, Predicate & predicate, Projection & projection)
+{
+   unsigned
+      mask = 0u;
+   
+   for( ::std::size_t index = 0; index < Width; ++index )
+   {
+      mask |=
+         static_cast<unsigned>
+            (
+            static_cast<bool>( ::std::invoke( predicate, ::std::invoke( projection, first[index] ) ) )
+            )
+         << index
+            ;
+   }
+   
+   return
+      mask;
+}
+
+//
+// The scalar, branch-free kernel. It writes every element to
+// buffer[count], which is never beyond the element itself,
+// so buffer needs room for size elements:
+//
+
+template <typename Iterator, typename T, typename Predicate, typename Projection>
+::std::size_t
+compact_scalar_block
+   (
+   Iterator first,
+   ::std::size_t size,
+   T * buffer,
+   Predicate & predicate,
+   Projection & projection
+   )
+{
+   ::std::size_t
+      count = 0u;
+   
+   for( ::std::size_t index = 0; index < size; ++index, ++first )
+   {
+      buffer[count] = *first;
+      
+      count += static_cast<bool>( ::std::invoke( predicate, ::std::invoke( projection, *first ) ) );
+   }
+   
+   return
+      count;
+}
+
+#if defined(__AVX2__) && !defined(__AVX512F__)
+
+//
+// For every 8-bit mask, the indices of its set bits, packed
+// one per byte, for _mm256_permutevar8x32_epi32:
+//
+
+inline constexpr auto
+   permutation_indices_8 =
+      [] (void)
+      {
+         ::std::array<::std::uint64_t, 256>
+            table { };
+         
+         for( unsigned mask = 0; mask < 256u; ++mask )
+         {
+            unsigned
+               count = 0u;
+            
+            for( unsigned lane = 0; lane < 8u; ++lane )
+            {
+               if( mask >> lane & 1u )
+               {
+                  table[mask] |= ::std::uint64_t { lane } << ( 8u * count++ );
+               }
+            }
+         }
+         
+         return
+            table;
+      }
+      ()
+      ;
+
+//
+// The same for 4-bit masks of 8-byte elements, as pairs of
+// 32-bit lanes:
+//
+
+inline constexpr auto
+   permutation_indices_4 =
+      [] (void)
+      {
+         ::std::array<::std::uint64_t, 16>
+            table { };
+         
+         for( unsigned mask = 0; mask < 16u; ++mask )
+         {
+            unsigned
+               count = 0u;
+            
+            for( unsigned element = 0; element < 4u; ++element )
+            {
+               if( mask >> element & 1u )
+               {
+                  table[mask] |= ::std::uint64_t { 2u * element } << ( 8u * count++ );
+                  
+                  table[mask] |= ::std::uint64_t { 2u * element + 1u } << ( 8u * count++ );
+               }
+            }
+         }
+         
+         return
+            table;
+      }
+      ()
+      ;
+
+#endif
+
+//
+// The SIMD kernel, for contiguous elements of 4 or 8 bytes.
+// size is a multiple of the SIMD width, and every store
+// writes a whole register at buffer + count, so buffer
+// needs room for size elements:
+//
+
+template <typename T, typename Predicate, typename Projection>
+::std::size_t
+compact_simd_block
+   (
+   T const * first,
+   ::std::size_t size,
+   T * buffer,
+   Predicate & predicate,
+   Projection & projection
+   )
+{
+   ::std::size_t
+      count = 0u;
+
+#if defined(__AVX512F__)
+   
+   if constexpr ( sizeof( T ) == 4u )
+   {
+      for( ::std::size_t index = 0; index < size; index += 16u )
+      {
+         auto const
+            mask = selection_mask<16>( first + index, predicate, projection );
+         
+         _mm512_mask_compressstoreu_epi32
+            (
+            buffer + count,
+            static_cast<__mmask16>( mask ),
+            _mm512_loadu_si512( first + index )
+            )
+            ;
+         
+         count += static_cast<::std::size_t>( ::std::popcount( mask ) );
+      }
+   }
+   else
+   {
+      for( ::std::size_t index = 0; index < size; index += 8u )
+      {
+         auto const
+            mask = selection_mask<8>( first + index, predicate, projection );
+         
+         _mm512_mask_compressstoreu_epi64
+            (
+            buffer + count,
+            static_cast<__mmask8>( mask ),
+            _mm512_loadu_si512( first + index )
+            )
+            ;
+         
+         count += static_cast<::std::size_t>( ::std::popcount( mask ) );
+      }
+   }
+
+#elif defined(__AVX2__)
+   
+   constexpr ::std::size_t
+      width = 32u / sizeof( T );
+   
+   for( ::std::size_t index = 0; index < size; index += width )
+   {
+      auto const
+         mask = selection_mask<width>( first + index, predicate, projection );
+      
+      auto const
+         indices =
+            _mm256_cvtepu8_epi32
+               (
+               _mm_loadl_epi64
+                  (
+                  reinterpret_cast<__m128i const *>
+                     (
+                     sizeof( T ) == 4u
+                        ? &permutation_indices_8[mask]
+                        : &permutation_indices_4[mask]
+                     )
+                  )
+               )
+               ;
+      
+      _mm256_storeu_si256
+         (
+         reinterpret_cast<__m256i *>( buffer + count ),
+         _mm256_permutevar8x32_epi32
+            (
+            _mm256_loadu_si256( reinterpret_cast<__m256i const *>( first + index ) ),
+            indices
+            )
+         )
+         ;
+      
+      count += static_cast<::std::size_t>( ::std::popcount( mask ) );
+   }
+
+#else
+   
+   count = compact_scalar_block( first, size, buffer, predicate, projection );
+
+#endif
+   
+   return
+      count;
+}
+
+template <typename T>
+concept SimdCompactable =
+   ::std::is_trivially_copyable_v<T>
+   
+   and
+   
+   ::std::default_initializable<T>
+   
+   and
+   
+   ( sizeof( T ) == 4u or sizeof( T ) == 8u );
+
+template <typename T>
+concept BranchFreeCompactable =
+   ::std::is_trivially_copyable_v<T>
+   
+   and
+   
+   ::std::default_initializable<T>;
+
+//
+// Compacts [first, first + size) block by block into a
+// local buffer, and copies the selected elements to out:
+//
+
+template <bool Simd, typename Iterator, typename O, typename Predicate, typename Projection>
+O
+compact_blocks
+   (
+   Iterator first,
+   ::std::size_t size,
+   O out,
+   Predicate & predicate,
+   Projection & projection
+   )
+{
+   using
+      T = ::std::iter_value_t<Iterator>;
+   
+   alignas( 64 ) T
+      buffer[compact_block];
+   
+   for( ::std::size_t done = 0; done < size; )
+   {
+      auto const
+         block = ::std::min( compact_block, size - done );
+      
+      ::std::size_t
+         count = 0u;
+      
+      if constexpr ( Simd )
+      {
+         //
+         // The SIMD kernel takes whole registers of 64
+         // bytes at most; the rest of a short last block
+         // is compacted by the scalar kernel:
+         //
+         
+         auto const
+            whole = block / ( 64u / sizeof( T ) ) * ( 64u / sizeof( T ) );
+         
+         auto const
+            data = ::std::to_address( first ) + done;
+         
+         count = compact_simd_block( data, whole, buffer, predicate, projection );
+         
+         count +=
+            compact_scalar_block
+               (
+               data + whole, block - whole, buffer + count, predicate, projection
+               )
+               ;
+      }
+      else
+      {
+         count = compact_scalar_block( first, block, buffer, predicate, projection );
+         
+         ::std::ranges::advance( first, static_cast<::std::ptrdiff_t>( block ) );
+      }
+      
+      out = ::std::ranges::copy( buffer, buffer + count, ::std::move( out ) ).out;
+      
+      done += block;
+   }
+   
+   return
+      out;
+}
+
+//
+// compact(range, out, predicate, projection) copies the
+// elements of range which satisfy the predicate to out, in
+// order, like ::std::ranges::copy_if, and returns the same
+// result:
+//
+
+template
+   <
+   ::std::ranges::input_range R,
+   ::std::weakly_incrementable O,
+   typename Projection = ::std::identity,
+   ::std::indirect_unary_predicate< ::std::projected< ::std::ranges::iterator_t<R>, Projection > > Predicate
+   >
+   requires ( ::std::indirectly_copyable< ::std::ranges::iterator_t<R>, O > )
+::std::ranges::copy_if_result< ::std::ranges::borrowed_iterator_t<R>, O >
+compact(R && range, O out, Predicate predicate, Projection projection = { })
+{
+   using
+      T = ::std::ranges::range_value_t<R>;
+   
+   if constexpr
+      (
+      ::std::ranges::contiguous_range<R>
+      
+      and
+      
+      ::std::ranges::sized_range<R>
+      
+      and
+      
+      SimdCompactable<T>
+      )
+   {
+      auto const
+         size = static_cast<::std::size_t>( ::std::ranges::size( range ) );
+      
+      out =
+         compact_blocks<true>
+            (
+            ::std::ranges::begin( range ), size, ::std::move( out ), predicate, projection
+            )
+            ;
+      
+      return
+         { ::std::ranges::next( ::std::ranges::begin( range ), ::std::ranges::end( range ) ), ::std::move( out ) };
+   }
+   else if constexpr ( ::std::ranges::sized_range<R> and BranchFreeCompactable<T> )
+   {
+      auto const
+         size = static_cast<::std::size_t>( ::std::ranges::size( range ) );
+      
+      out =
+         compact_blocks<false>
+            (
+            ::std::ranges::begin( range ), size, ::std::move( out ), predicate, projection
+            )
+            ;
+      
+      return
+         { ::std::ranges::next( ::std::ranges::begin( range ), ::std::ranges::end( range ) ), ::std::move( out ) };
+   }
+   else
+   {
+      return
+         ::std::ranges::copy_if( ::std::forward<R>( range ), ::std::move( out ), predicate, projection );
+   }
+}
+
+//
+// The scalar, branch-free path alone, for comparison:
+//
+
+template
+   <
+   ::std::ranges::input_range R,
+   ::std::weakly_incrementable O,
+   typename Projection = ::std::identity,
+   ::std::indirect_unary_predicate< ::std::projected< ::std::ranges::iterator_t<R>, Projection > > Predicate
+   >
+   requires
+      (
+      ::std::ranges::sized_range<R>
+      
+      and
+      
+      BranchFreeCompactable< ::std::ranges::range_value_t<R> >
+      
+      and
+      
+      ::std::indirectly_copyable< ::std::ranges::iterator_t<R>, O >
+      )
+O
+compact_branch_free(R && range, O out, Predicate predicate, Projection projection = { })
+{
+   return
+      compact_blocks<false>
+         (
+         ::std::ranges::begin( range ),
+         static_cast<::std::size_t>( ::std::ranges::size( range ) ),
+         ::std::move( out ),
+         predicate,
+         projection
+         )
+         ;
+}
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+template <typename T>
+void
+benchmark(char const * name, ::std::size_t size)
+{
+   ::std::mt19937_64
+      generator( 42u );
+   
+   ::std::uniform_int_distribution<int>
+      percent( 0, 99 );
+   
+   ::std::vector<T>
+      items( size );
+   
+   for( auto & item : items )
+   {
+      item = static_cast<T>( percent( generator ) );
+   }
+   
+   ::std::vector<T>
+      expected( size ),
+      branch_free( size ),
+      compacted( size );
+   
+   ::std::cout << name << ":" << ::std::endl;
+   
+   for( int selectivity : { 1, 10, 25, 50, 75, 90, 99 } )
+   {
+      auto const
+         selected = [threshold = static_cast<T>( selectivity )] (T item) { return item < threshold; };
+      
+      typename ::std::vector<T>::iterator
+         expected_end,
+         branch_free_end,
+         compacted_end;
+      
+      auto const
+         copy_if_time =
+            milliseconds
+               (
+               [&]
+               {
+                  expected_end = ::std::ranges::copy_if( items, expected.begin(), selected ).out;
+               }
+               )
+               ;
+      
+      auto const
+         branch_free_time =
+            milliseconds
+               (
+               [&]
+               {
+                  branch_free_end = ranges::compact_branch_free( items, branch_free.begin(), selected );
+               }
+               )
+               ;
+      
+      auto const
+         compact_time =
+            milliseconds
+               (
+               [&]
+               {
+                  compacted_end = ranges::compact( items, compacted.begin(), selected ).out;
+               }
+               )
+               ;
+      
+      assert
+         (
+         ::std::ranges::equal( expected.begin(), expected_end, branch_free.begin(), branch_free_end )
+         )
+         ;
+      
+      assert
+         (
+         ::std::ranges::equal( expected.begin(), expected_end, compacted.begin(), compacted_end )
+         )
+         ;
+      
+      ::std::cout << "   "
+                  << selectivity
+                  << "% selected: copy_if "
+                  << copy_if_time
+                  << " ms, branch-free "
+                  << branch_free_time
+                  << " ms, compact "
+                  << compact_time
+                  << " ms"
+                  << ::std::endl
+                     ;
+   }
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<int> const
+      items { 5, 12, 7, 30, 1, 18, 9, 22, 3, 14, 11, 40, 2, 16, 8, 25, 6, 19 };
+   
+   ::std::vector<int>
+      small;
+   
+   ranges::compact( items, ::std::back_inserter( small ), [] (int item) { return item < 10; } );
+   
+   for( int v : small )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   assert( ( small == ::std::vector<int> { 5, 7, 1, 9, 3, 2, 8, 6 } ) );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark compacting random percentages at several
+   // selectivities. The number of elements can be passed as
+   // the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 10'000'000u
+               ;
+
+#if defined(__AVX512F__)
+   ::std::cout << "compact uses AVX-512 compress stores" << ::std::endl;
+#elif defined(__AVX2__)
+   ::std::cout << "compact uses AVX2 permutations" << ::std::endl;
+#else
+   ::std::cout << "compact uses the scalar branch-free kernel" << ::std::endl;
+#endif
+   
+   benchmark<int>( "int", size );
+   
+   benchmark<double>( "double", size );
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,791 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+#include <functional>
+#include <numeric>
+#include <vector>
+#include <tuple>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// A ::std::vector<Person> stores its elements one after the
+// other ("array of structures", AoS):
+//
+//    id_ salary_ id_ salary_ id_ salary_ ...
+//
+// so a loop which only reads salary_ also drags every id_
+// (a 32-byte ::std::string header) through the cache. A
+// "structure of arrays" (SoA) container stores every member
+// in its own contiguous column instead:
+//
+//    id_     id_     id_     ...
+//    salary_ salary_ salary_ ...
+//
+// Below, soa_vector is parameterized by the member pointers
+// of the columns that it stores. Member pointers are valid
+// non-type template parameters, and auto template
+// parameters accept them without spelling out their type:
+//
+//    soa_vector< &Person::id_, &Person::salary_ >
+//
+
+struct Person final
+{
+   ::std::string
+      id_;
+   
+   double
+      salary_;
+   
+   double
+      salary(void)
+   {
+      return
+         salary_;
+   }
+}
+;
+
+//
+// Extracts the class and the member type from a pointer to
+// a data member:
+//
+
+template <typename T>
+struct member_pointer_traits;
+
+template <typename Class, typename T>
+struct member_pointer_traits <T Class::*>
+{
+   using
+      class_type = Class;
+   
+   using
+      value_type = T;
+}
+;
+
+template <auto Member>
+using
+   member_class_t =
+      typename member_pointer_traits< decltype(Member) >::class_type;
+
+template <auto Member>
+using
+   member_value_t =
+      typename member_pointer_traits< decltype(Member) >::value_type;
+
+//
+// Member pointers of different types cannot be compared
+// with ==, so compare their types first:
+//
+
+template <auto First, auto Second>
+consteval bool
+is_same_member(void)
+{
+   if constexpr
+      (
+      ::std::is_same_v< decltype(First), decltype(Second) >
+      )
+   {
+      return
+         First == Second;
+   }
+   else
+   {
+      return
+         false;
+   }
+}
+
+template <auto Member, auto ... Members>
+consteval ::std::size_t
+column_index(void)
+{
+   ::std::size_t
+      index = 0;
+   
+   bool
+      found = false;
+   
+   (
+      (
+         found
+            or
+         ( is_same_member<Member, Members>() ? ( found = true ) : ( ++index, false ) )
+      )
+      ,
+      ...
+   )
+   ;
+   
+   return
+      index;
+}
+
+template <auto ... Members>
+   requires
+      ( sizeof...(Members) > 0 )
+      
+      and
+      
+      ( ::std::is_member_object_pointer_v< decltype(Members) > and ... )
+class soa_vector final
+{
+public:
+   using
+      value_type =
+         member_class_t
+            <
+            ::std::get<0>( ::std::tuple( Members ... ) )
+            >
+            ;
+   
+   static_assert
+      (
+      ( ::std::is_same_v< member_class_t<Members>, value_type > and ... ),
+      "every column must be a member of the same class"
+      )
+      ;
+   
+   //
+   // True if Member is one of the stored columns:
+   //
+   
+   template <auto Member>
+   static constexpr bool
+      has_column = ( is_same_member<Member, Members>() or ... );
+   
+   //
+   // A reference to one row. Rows do not exist in memory,
+   // so the reference stores the container and the index,
+   // and reads each member from its column when asked:
+   //
+   
+   template <bool Const>
+   class row_reference final
+   {
+   public:
+      using
+         owner_type =
+            ::std::conditional_t<Const, soa_vector const, soa_vector>;
+      
+      row_reference(owner_type & owner, ::std::size_t index)
+         : owner_( &owner ), index_( index )
+      { }
+      
+      template <auto Member>
+         requires ( has_column<Member> )
+      decltype(auto)
+         get(void) const
+      {
+         return
+            owner_->template column<Member>()[index_];
+      }
+      
+      ::std::size_t
+         index(void) const
+      {
+         return
+            index_;
+      }
+      
+      //
+      // Materializes the row as an object:
+      //
+      
+      operator value_type () const
+      {
+         value_type
+            object { };
+         
+         ( ( object.*Members = this->get<Members>() ), ... );
+         
+         return
+            object;
+      }
+   
+   private:
+      owner_type *
+         owner_;
+      
+      ::std::size_t
+         index_;
+   }
+   ;
+   
+   ::std::size_t
+      size(void) const
+   {
+      return
+         ::std::get<0>( columns_ ).size();
+   }
+   
+   void
+      reserve(::std::size_t capacity)
+   {
+      ::std::apply
+         (
+         [capacity] (auto & ... column)
+         {
+            ( column.reserve( capacity ), ... );
+         },
+         columns_
+         )
+         ;
+   }
+   
+   void
+      push_back(value_type const & object)
+   {
+      ::std::apply
+         (
+         [&object] (auto & ... column)
+         {
+            ( column.push_back( object.*Members ), ... );
+         },
+         columns_
+         )
+         ;
+   }
+   
+   void
+      push_back(value_type && object)
+   {
+      ::std::apply
+         (
+         [&object] (auto & ... column)
+         {
+            ( column.push_back( ::std::move( object.*Members ) ), ... );
+         },
+         columns_
+         )
+         ;
+   }
+   
+   //
+   // A column is contiguous, so it is exposed as a span. Any
+   // range algorithm can be applied to it directly:
+   //
+   
+   template <auto Member>
+      requires ( has_column<Member> )
+   ::std::span< member_value_t<Member> >
+      column(void)
+   {
+      return
+         ::std::get< column_index<Member, Members ...>() >( columns_ );
+   }
+   
+   template <auto Member>
+      requires ( has_column<Member> )
+   ::std::span< member_value_t<Member> const >
+      column(void) const
+   {
+      return
+         ::std::get< column_index<Member, Members ...>() >( columns_ );
+   }
+   
+   row_reference<false>
+      operator[] (::std::size_t index)
+   {
+      return
+         { *this, index };
+   }
+   
+   row_reference<true>
+      operator[] (::std::size_t index) const
+   {
+      return
+         { *this, index };
+   }
+   
+   //
+   // A random-access view of row references, similar to
+   // zipping the columns together:
+   //
+   
+   auto
+      rows(void)
+   {
+      return
+         ::std::views::iota( ::std::size_t { 0 }, this->size() )
+            | ::std::views::transform
+               (
+               [this] (::std::size_t index)
+               {
+                  return
+                     row_reference<false> { *this, index };
+               }
+               )
+               ;
+   }
+   
+   auto
+      rows(void) const
+   {
+      return
+         ::std::views::iota( ::std::size_t { 0 }, this->size() )
+            | ::std::views::transform
+               (
+               [this] (::std::size_t index)
+               {
+                  return
+                     row_reference<true> { *this, index };
+               }
+               )
+               ;
+   }
+   
+   //
+   // Reorders every column so that the new row i is the old
+   // row permutation[i]:
+   //
+   
+   void
+      permute(::std::span<::std::size_t const> permutation)
+   {
+      assert( permutation.size() == this->size() );
+      
+      ::std::apply
+         (
+         [permutation] (auto & ... column)
+         {
+            ( permute_column( column, permutation ), ... );
+         },
+         columns_
+         )
+         ;
+   }
+
+private:
+   template <typename T>
+   static void
+      permute_column
+         (
+         ::std::vector<T> & column,
+         ::std::span<::std::size_t const> permutation
+         )
+   {
+      ::std::vector<T>
+         permuted;
+      
+      permuted.reserve( column.size() );
+      
+      for( auto index : permutation )
+      {
+         permuted.push_back( ::std::move( column[index] ) );
+      }
+      
+      column.swap( permuted );
+   }
+   
+   ::std::tuple< ::std::vector< member_value_t<Members> > ... >
+      columns_;
+}
+;
+
+//
+// The equivalent of ::std::ranges::sort for a soa_vector,
+// projected onto one of its columns. Only the key column
+// and a vector of row indices are touched while sorting; the
+// resulting permutation is then applied to every column
+// once. Like ::std::ranges::sort, this is not a stable
+// sort, and it is a function object, so that argument-
+// dependent lookup cannot find ::std::sort instead, and
+// the comparison may be given as { }:
+//
+
+struct sort_fn
+{
+   template
+      <
+      auto ... Members,
+      typename Comparison = ::std::ranges::less,
+      typename Projection
+      >
+   void
+   operator()
+      (
+      soa_vector<Members ...> & items,
+      Comparison comparison,
+      Projection projection
+      )
+      const
+   {
+      static_assert
+         (
+         ( ::std::is_same_v< Projection, decltype(Members) > or ... ),
+         "the projection must be a pointer to one of the stored columns"
+         )
+         ;
+   
+      ::std::vector <::std::size_t>
+         permutation( items.size() );
+   
+      ::std::iota( permutation.begin(), permutation.end(), ::std::size_t { 0 } );
+   
+      bool
+         sorted = false;
+   
+      //
+      // The projection is a run-time value, so find its column
+      // by comparing it with every stored member pointer of the
+      // same type:
+      //
+   
+      auto const
+         sort_by =
+            [&] <auto Member> (void)
+            {
+               if constexpr ( ::std::is_same_v< Projection, decltype(Member) > )
+               {
+                  if( not sorted and projection == Member )
+                  {
+                     auto const
+                        keys = items.template column<Member>();
+                  
+                     using
+                        Key = member_value_t<Member>;
+                  
+                     if constexpr ( ::std::is_trivially_copyable_v<Key> )
+                     {
+                        //
+                        // Small keys are copied next to their row
+                        // index, so that the sort reads memory
+                        // sequentially:
+                        //
+                     
+                        ::std::vector< ::std::pair<Key, ::std::size_t> >
+                           keyed;
+                     
+                        keyed.reserve( keys.size() );
+                     
+                        for( auto index : permutation )
+                        {
+                           keyed.emplace_back( keys[index], index );
+                        }
+                     
+                        ::std::ranges::sort
+                           (
+                           keyed,
+                           comparison,
+                           &::std::pair<Key, ::std::size_t>::first
+                           )
+                           ;
+                     
+                        ::std::ranges::copy
+                           (
+                           keyed | ::std::views::values,
+                           permutation.begin()
+                           )
+                           ;
+                     }
+                     else
+                     {
+                        ::std::ranges::sort
+                           (
+                           permutation,
+                           comparison,
+                           [keys] (::std::size_t index) -> Key const &
+                           {
+                              return
+                                 keys[index];
+                           }
+                           )
+                           ;
+                     }
+                  
+                     sorted = true;
+                  }
+               }
+            }
+            ;
+   
+      ( sort_by.template operator()<Members>(), ... );
+   
+      //
+      // A pointer to a member of the same type which is not a
+      // stored column (or a null pointer) matches no column.
+      // Rather than silently leave the items unsorted, reject
+      // it:
+      //
+   
+      if( not sorted )
+      {
+         throw
+            ::std::invalid_argument( "sort: the projection is not a stored column" );
+      }
+   
+      items.permute( permutation );
+   }
+}
+;
+
+inline constexpr sort_fn
+   sort;
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   using
+      People = soa_vector< &Person::id_, &Person::salary_ >;
+   
+   {
+   
+   People
+      people;
+   
+   people.push_back( { "carol", 3. } );
+   people.push_back( { "alice", 1. } );
+   people.push_back( { "bob", 2. } );
+   
+   //
+   // Columns are spans, so range algorithms apply to them
+   // directly:
+   //
+   
+   [[maybe_unused]] auto const
+      total =
+         ::std::accumulate
+            (
+            people.column<&Person::salary_>().begin(),
+            people.column<&Person::salary_>().end(),
+            0.
+            )
+            ;
+   
+   assert( total == 6. );
+   
+   //
+   // Ported from ::std::ranges::sort( items, { }, &Person::id_ ):
+   //
+   
+   sort( people, { }, &Person::id_ );
+   
+   //
+   // A member pointer which names no stored column is
+   // rejected, rather than leaving the items unsorted:
+   //
+   
+   [[maybe_unused]] bool
+      rejected = false;
+   
+   try
+   {
+      sort( people, { }, static_cast<double Person::*>( nullptr ) );
+   }
+   catch( ::std::invalid_argument const & )
+   {
+      rejected = true;
+   }
+   
+   assert( rejected );
+   
+   for( auto const & row : people.rows() )
+   {
+      ::std::cout << row.get<&Person::id_>()
+                  << " "
+                  << row.get<&Person::salary_>()
+                  << ::std::endl
+                     ;
+   }
+   
+   //
+   // Rows are references, so the data can be modified
+   // through them:
+   //
+   
+   for( auto row : people.rows() )
+   {
+      row.get<&Person::salary_>() *= 2.;
+   }
+   
+   Person const
+      first = people[0];
+   
+   assert( first.id_ == "alice" and first.salary_ == 2. );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark a salary scan and a sort by salary over AoS
+   // and SoA storage. The number of people can be passed as
+   // the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 2'000'000u
+               ;
+   
+   ::std::vector<Person>
+      aos;
+   
+   People
+      soa;
+   
+   aos.reserve( size );
+   
+   soa.reserve( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      Person
+         person
+            {
+            "person-" + ::std::to_string( index ),
+            static_cast<double>( ( index * 7919u ) % 100'003u )
+            }
+            ;
+      
+      soa.push_back( person );
+      
+      aos.push_back( ::std::move( person ) );
+   }
+   
+   double
+      aos_total = 0.,
+      soa_total = 0.;
+   
+   auto const
+      aos_scan =
+         milliseconds
+            (
+            [&]
+            {
+               for( auto const & person : aos )
+               {
+                  aos_total += person.salary_;
+               }
+            }
+            )
+            ;
+   
+   auto const
+      soa_scan =
+         milliseconds
+            (
+            [&]
+            {
+               for( double salary : soa.column<&Person::salary_>() )
+               {
+                  soa_total += salary;
+               }
+            }
+            )
+            ;
+   
+   assert( aos_total == soa_total );
+   
+   auto const
+      aos_sort =
+         milliseconds
+            (
+            [&]
+            {
+               ::std::ranges::sort( aos, { }, &Person::salary_ );
+            }
+            )
+            ;
+   
+   auto const
+      soa_sort =
+         milliseconds
+            (
+            [&]
+            {
+               sort( soa, { }, &Person::salary_ );
+            }
+            )
+            ;
+   
+   assert
+      (
+      ::std::ranges::equal
+         (
+         aos | ::std::views::transform( &Person::salary_ ),
+         soa.column<&Person::salary_>()
+         )
+      )
+      ;
+   
+   ::std::cout << size
+               << " people:"
+               << ::std::endl
+               << "   scan salaries: AoS "
+               << aos_scan
+               << " ms (total "
+               << aos_total
+               << "), SoA "
+               << soa_scan
+               << " ms (total "
+               << soa_total
+               << ")"
+               << ::std::endl
+               << "   sort by salary: AoS "
+               << aos_sort
+               << " ms, SoA "
+               << soa_sort
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,881 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// Finding the 100 highest-paid people out of 500 million
+// with ::std::ranges::sort sorts all 500 million of them.
+// ::std::ranges::partial_sort and ::std::ranges::nth_element
+// do less work, but they still reorder (and so need a
+// writable copy of) the whole range.
+//
+// top_k reads the range once and keeps the best k elements
+// seen so far in a bounded heap. The heap is ordered so
+// that its top is the worst of the k elements: the
+// "threshold". Once the heap is full, an element is only
+// worth inserting if it beats the threshold, and for
+// typical inputs almost none do. So the inner loop is a
+// single comparison against the threshold, which is checked
+// for blocks of elements at a time in a loop without
+// branches that the compiler can vectorize.
+//
+// top_k(range, k, comparison, projection) returns the k
+// elements which would come first if the range were sorted
+// by comparison, in that order. The comparison defaults to
+// ::std::ranges::greater, so by default top_k returns the k
+// largest elements.
+//
+
+struct Person final
+{
+   ::std::string
+      id_;
+   
+   double
+      salary_;
+}
+;
+
+namespace ranges
+{
+
+//
+// The number of elements checked against the threshold
+// between branches:
+//
+
+inline constexpr ::std::size_t
+   top_k_block = 16u;
+
+template
+   <
+   ::std::ranges::input_range R,
+   typename Comparison = ::std::ranges::greater,
+   typename Projection = ::std::identity
+   >
+   requires
+      (
+      ::std::indirect_strict_weak_order
+         <
+         Comparison,
+         ::std::projected< ::std::ranges::iterator_t<R>, Projection >
+         >
+      )
+::std::vector< ::std::ranges::range_value_t<R> >
+top_k
+   (
+   R && range,
+   ::std::size_t k,
+   Comparison comparison = { },
+   Projection projection = { }
+   )
+{
+   using
+      Value = ::std::ranges::range_value_t<R>;
+   
+   ::std::vector<Value>
+      heap;
+   
+   if( k == 0u )
+   {
+      return
+         heap;
+   }
+   
+   heap.reserve( k );
+   
+   //
+   // With comparison as the heap order, the top of the heap
+   // is the element which would come last in sorted order:
+   //
+   
+   auto
+      first = ::std::ranges::begin( range );
+   
+   auto const
+      last = ::std::ranges::end( range );
+   
+   for( ; first != last and heap.size() < k; ++first )
+   {
+      heap.push_back( *first );
+      
+      ::std::ranges::push_heap( heap, comparison, projection );
+   }
+   
+   //
+   // With fewer than k elements, the heap holds them all and
+   // has no threshold yet:
+   //
+   
+   if( heap.size() < k )
+   {
+      ::std::ranges::sort_heap( heap, comparison, projection );
+      
+      return
+         heap;
+   }
+   
+   auto const
+      insert =
+         [&] (auto && element)
+         {
+            ::std::ranges::pop_heap( heap, comparison, projection );
+            
+            heap.back() = ::std::forward<decltype(element)>( element );
+            
+            ::std::ranges::push_heap( heap, comparison, projection );
+         }
+         ;
+   
+   auto const
+      beats_threshold =
+         [&] (auto const & element)
+         {
+            return
+               ::std::invoke
+                  (
+                  comparison,
+                  ::std::invoke( projection, element ),
+                  ::std::invoke( projection, heap.front() )
+                  )
+                  ;
+         }
+         ;
+   
+   if constexpr
+      (
+      ::std::ranges::random_access_range<R>
+      
+      and
+      
+      ::std::ranges::sized_range<R>
+      )
+   {
+      //
+      // Check whole blocks against a copy of the threshold
+      // key, and only look at the elements of a block
+      // individually if one of them beats it:
+      //
+      
+      auto
+         threshold = ::std::invoke( projection, heap.front() );
+      
+      while( last - first >= static_cast<::std::ptrdiff_t>( top_k_block ) )
+      {
+         bool
+            any = false;
+         
+         for( ::std::size_t index = 0; index < top_k_block; ++index )
+         {
+            any |=
+               ::std::invoke
+                  (
+                  comparison,
+                  ::std::invoke( projection, first[index] ),
+                  threshold
+                  )
+                  ;
+         }
+         
+         if( any )
+         {
+            for( ::std::size_t index = 0; index < top_k_block; ++index )
+            {
+               if( beats_threshold( first[index] ) )
+               {
+                  insert( first[index] );
+               }
+            }
+            
+            threshold = ::std::invoke( projection, heap.front() );
+         }
+         
+         first += top_k_block;
+      }
+   }
+   
+   for( ; first != last; ++first )
+   {
+      if( beats_threshold( *first ) )
+      {
+         insert( *first );
+      }
+   }
+   
+   ::std::ranges::sort_heap( heap, comparison, projection );
+   
+   return
+      heap;
+}
+
+//
+// A parallel top_k: the range is split between threads, each
+// thread computes the top k of its part, and the per-thread
+// results are merged with a final top_k:
+//
+
+template
+   <
+   ::std::ranges::random_access_range R,
+   typename Comparison = ::std::ranges::greater,
+   typename Projection = ::std::identity
+   >
+   requires ( ::std::ranges::sized_range<R> )
+::std::vector< ::std::ranges::range_value_t<R> >
+parallel_top_k
+   (
+   R && range,
+   ::std::size_t k,
+   Comparison comparison = { },
+   Projection projection = { },
+   unsigned threads = ::std::thread::hardware_concurrency()
+   )
+{
+   threads = ::std::max( threads, 1u );
+   
+   auto const
+      size = ::std::ranges::size( range );
+   
+   auto const
+      part = ( size + threads - 1u ) / threads;
+   
+   ::std::vector< ::std::vector< ::std::ranges::range_value_t<R> > >
+      results( threads );
+   
+   {
+   
+   ::std::vector<::std::jthread>
+      workers;
+   
+   for( unsigned thread = 0; thread < threads; ++thread )
+   {
+      workers.emplace_back
+         (
+         [&, thread]
+         {
+            auto const
+               begin = ::std::min( size, thread * part ),
+               end = ::std::min( size, begin + part );
+            
+            results[thread] =
+               top_k
+                  (
+                  ::std::ranges::subrange
+                     (
+                     ::std::ranges::begin( range ) + begin,
+                     ::std::ranges::begin( range ) + end
+                     ),
+                  k,
+                  comparison,
+                  projection
+                  )
+                  ;
+         }
+         )
+         ;
+   }
+   
+   //
+   // The ::std::jthread destructors join the workers.
+   //
+   
+   }
+   
+   return
+      top_k
+         (
+         results | ::std::views::join,
+         k,
+         comparison,
+         projection
+         )
+         ;
+}
+
+//
+// A KLL quantile sketch. It estimates the quantiles of a
+// stream of values in O(k log(n / k)) memory, with a rank
+// error of about 1.7 / k.
+//
+// The sketch is a stack of "compactors". Values are added
+// to the bottom compactor, in which every value has weight
+// one. When a compactor of weight w is full, it is sorted
+// and every other value (starting at a random offset) is
+// moved to the compactor above, with weight 2w; the other
+// values are discarded. Higher compactors have larger
+// capacities, by a factor of 3 / 2 per level, up to k; the
+// lowest ones have a minimum capacity of 8 so that values
+// are not compacted two at a time.
+//
+
+template <typename T = double>
+class quantile_sketch final
+{
+public:
+   explicit quantile_sketch(::std::size_t k = 200u, unsigned seed = 1u)
+      : k_( ::std::max <::std::size_t> ( k, 8u ) ), random_( seed )
+   {
+      this->add_level();
+   }
+   
+   void
+      insert(T value)
+   {
+      levels_[0].push_back( value );
+      
+      ++count_;
+      
+      if( levels_[0].size() >= capacities_[0] )
+      {
+         this->compress();
+      }
+   }
+   
+   template <::std::ranges::input_range R, typename Projection = ::std::identity>
+   void
+      insert_range(R && range, Projection projection = { })
+   {
+      for( auto && element : range )
+      {
+         this->insert( ::std::invoke( projection, element ) );
+      }
+   }
+   
+   //
+   // Sketches of parts of a stream can be merged, so that a
+   // stream can be sketched in parallel:
+   //
+   
+   void
+      merge(quantile_sketch const & other)
+   {
+      while( levels_.size() < other.levels_.size() )
+      {
+         this->add_level();
+      }
+      
+      for( ::std::size_t level = 0; level < other.levels_.size(); ++level )
+      {
+         levels_[level].insert
+            (
+            levels_[level].end(),
+            other.levels_[level].begin(),
+            other.levels_[level].end()
+            )
+            ;
+      }
+      
+      count_ += other.count_;
+      
+      this->compress();
+   }
+   
+   ::std::size_t
+      count(void) const
+   {
+      return
+         count_;
+   }
+   
+   //
+   // The value at quantile q, for q in [0, 1]:
+   //
+   
+   T
+      quantile(double q) const
+   {
+      auto const
+         weighted = this->weighted_values();
+      
+      if( weighted.empty() )
+      {
+         return
+            T { };
+      }
+      
+      ::std::uint64_t
+         total = 0u;
+      
+      for( auto const & [ value, weight ] : weighted )
+      {
+         total += weight;
+      }
+      
+      auto const
+         target = q * static_cast<double>( total );
+      
+      ::std::uint64_t
+         cumulative = 0u;
+      
+      for( auto const & [ value, weight ] : weighted )
+      {
+         cumulative += weight;
+         
+         if( static_cast<double>( cumulative ) >= target )
+         {
+            return
+               value;
+         }
+      }
+      
+      return
+         weighted.back().first;
+   }
+
+private:
+   //
+   // The capacities only change when the sketch grows a
+   // level, so they are not recomputed for every value:
+   //
+   
+   void
+      add_level(void)
+   {
+      levels_.emplace_back();
+      
+      capacities_.resize( levels_.size() );
+      
+      auto
+         capacity = static_cast<double>( k_ );
+      
+      for( auto level = capacities_.size(); level-- > 0u; )
+      {
+         capacities_[level] =
+            ::std::max <::std::size_t>
+               (
+               8u,
+               static_cast<::std::size_t>( ::std::ceil( capacity ) )
+               )
+               ;
+         
+         capacity *= 2. / 3.;
+      }
+   }
+   
+   void
+      compress(void)
+   {
+      for( ::std::size_t level = 0; level < levels_.size(); ++level )
+      {
+         if( levels_[level].size() < capacities_[level] )
+         {
+            continue;
+         }
+         
+         if( level + 1u == levels_.size() )
+         {
+            this->add_level();
+         }
+         
+         auto &
+            compactor = levels_[level];
+         
+         ::std::ranges::sort( compactor );
+         
+         //
+         // With an odd number of values, the last value
+         // stays in this compactor:
+         //
+         
+         ::std::size_t const
+            pairs = compactor.size() / 2u;
+         
+         ::std::size_t const
+            offset = random_() & 1u;
+         
+         for( ::std::size_t pair = 0; pair < pairs; ++pair )
+         {
+            levels_[level + 1u].push_back( compactor[ 2u * pair + offset ] );
+         }
+         
+         compactor.erase
+            (
+            compactor.begin(),
+            compactor.begin() + static_cast<::std::ptrdiff_t>( 2u * pairs )
+            )
+            ;
+      }
+   }
+   
+   ::std::vector< ::std::pair<T, ::std::uint64_t> >
+      weighted_values(void) const
+   {
+      ::std::vector< ::std::pair<T, ::std::uint64_t> >
+         weighted;
+      
+      for( ::std::size_t level = 0; level < levels_.size(); ++level )
+      {
+         for( auto const & value : levels_[level] )
+         {
+            weighted.emplace_back( value, ::std::uint64_t { 1u } << level );
+         }
+      }
+      
+      ::std::ranges::sort( weighted, { }, &::std::pair<T, ::std::uint64_t>::first );
+      
+      return
+         weighted;
+   }
+   
+   ::std::size_t
+      k_;
+   
+   ::std::size_t
+      count_ = 0u;
+   
+   ::std::vector<::std::size_t>
+      capacities_;
+   
+   ::std::minstd_rand
+      random_;
+   
+   ::std::vector< ::std::vector<T> >
+      levels_;
+}
+;
+
+}
+
+template <typename Function>
+double
+milliseconds(Function && function)
+{
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   function();
+   
+   return
+      ::std::chrono::duration <double, ::std::milli>
+         (
+         ::std::chrono::steady_clock::now() - start
+         )
+         .count()
+            ;
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   ::std::vector<int> const
+      items { 5, 1, 9, 3, 7, 2, 8 };
+   
+   for( int v : ranges::top_k( items, 3u ) )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   //
+   // The three smallest elements:
+   //
+   
+   assert
+      (
+      ( ranges::top_k( items, 3u, ::std::ranges::less { } ) == ::std::vector<int> { 1, 2, 3 } )
+      )
+      ;
+   
+   //
+   // Fewer elements than k, and more threads than
+   // elements, some of which then have empty parts:
+   //
+   
+   assert( ranges::top_k( ::std::vector<int> { }, 3u ).empty() );
+   
+   assert( ( ranges::top_k( ::std::vector<int> { 2, 1 }, 3u ) == ::std::vector<int> { 2, 1 } ) );
+   
+   assert( ( ranges::parallel_top_k( items, 3u, { }, { }, 16u ) == ::std::vector<int> { 9, 8, 7 } ) );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark finding the 100 highest-paid people. The
+   // number of people can be passed as the first
+   // command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 5'000'000u
+               ;
+   
+   ::std::size_t const
+      k = 100u;
+   
+   ::std::mt19937_64
+      generator( 42u );
+   
+   ::std::lognormal_distribution<double>
+      salaries( 10.5, 0.5 );
+   
+   ::std::vector<Person>
+      people( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      people[index].id_ = ::std::to_string( index );
+      
+      people[index].salary_ = salaries( generator );
+   }
+   
+   ::std::vector<Person>
+      top,
+      parallel,
+      partial,
+      nth;
+   
+   auto const
+      top_k_time =
+         milliseconds
+            (
+            [&]
+            {
+               top = ranges::top_k( people, k, { }, &Person::salary_ );
+            }
+            )
+            ;
+   
+   auto const
+      parallel_time =
+         milliseconds
+            (
+            [&]
+            {
+               parallel =
+                  ranges::parallel_top_k( people, k, { }, &Person::salary_ );
+            }
+            )
+            ;
+   
+   //
+   // partial_sort and nth_element reorder their input, so
+   // they are given a copy, which is not timed:
+   //
+   
+   partial = people;
+   
+   auto const
+      partial_sort_time =
+         milliseconds
+            (
+            [&]
+            {
+               ::std::ranges::partial_sort
+                  (
+                  partial,
+                  partial.begin() + static_cast<::std::ptrdiff_t>( k ),
+                  ::std::ranges::greater { },
+                  &Person::salary_
+                  )
+                  ;
+               
+               partial.resize( k );
+            }
+            )
+            ;
+   
+   nth = people;
+   
+   auto const
+      nth_element_time =
+         milliseconds
+            (
+            [&]
+            {
+               auto const
+                  middle = nth.begin() + static_cast<::std::ptrdiff_t>( k );
+               
+               ::std::ranges::nth_element
+                  (
+                  nth, middle, ::std::ranges::greater { }, &Person::salary_
+                  )
+                  ;
+               
+               nth.resize( k );
+               
+               ::std::ranges::sort( nth, ::std::ranges::greater { }, &Person::salary_ );
+            }
+            )
+            ;
+   
+   auto const
+      salary_of = ::std::views::transform( &Person::salary_ );
+   
+   assert( ::std::ranges::equal( top | salary_of, partial | salary_of ) );
+   
+   assert( ::std::ranges::equal( top | salary_of, parallel | salary_of ) );
+   
+   assert( ::std::ranges::equal( top | salary_of, nth | salary_of ) );
+   
+   ::std::cout << "top "
+               << k
+               << " of "
+               << size
+               << " people by salary:"
+               << ::std::endl
+               << "   top_k:          "
+               << top_k_time
+               << " ms"
+               << ::std::endl
+               << "   parallel_top_k: "
+               << parallel_time
+               << " ms"
+               << ::std::endl
+               << "   partial_sort:   "
+               << partial_sort_time
+               << " ms"
+               << ::std::endl
+               << "   nth_element:    "
+               << nth_element_time
+               << " ms"
+               << ::std::endl
+                  ;
+   
+   //
+   // Estimate salary quantiles with a sketch, and compare
+   // them with the exact quantiles:
+   //
+   
+   ranges::quantile_sketch<double>
+      sketch;
+   
+   auto const
+      sketch_time =
+         milliseconds
+            (
+            [&]
+            {
+               sketch.insert_range( people, &Person::salary_ );
+            }
+            )
+            ;
+   
+   //
+   // Sketches of the two halves of the people, merged, give
+   // the same guarantees as a sketch of all of them:
+   //
+   
+   ranges::quantile_sketch<double>
+      first_half( 200u, 2u ),
+      second_half( 200u, 3u );
+   
+   first_half.insert_range
+      (
+      people | ::std::views::take( size / 2u ), &Person::salary_
+      )
+      ;
+   
+   second_half.insert_range
+      (
+      people | ::std::views::drop( size / 2u ), &Person::salary_
+      )
+      ;
+   
+   first_half.merge( second_half );
+   
+   assert( first_half.count() == size );
+   
+   ::std::cout << "median of merged sketches: "
+               << first_half.quantile( 0.5 )
+               << ::std::endl
+                  ;
+   
+   auto
+      salaries_sorted = ::std::vector<double>( size );
+   
+   ::std::ranges::copy( people | salary_of, salaries_sorted.begin() );
+   
+   ::std::ranges::sort( salaries_sorted );
+   
+   ::std::cout << "quantile sketch ("
+               << sketch_time
+               << " ms):"
+               << ::std::endl
+                  ;
+   
+   for( double q : { 0.01, 0.5, 0.99 } )
+   {
+      auto const
+         estimate = sketch.quantile( q );
+      
+      //
+      // The error of a quantile sketch is measured in rank,
+      // not in value:
+      //
+      
+      auto const
+         rank =
+            static_cast<double>
+               (
+               ::std::ranges::lower_bound( salaries_sorted, estimate )
+               -
+               salaries_sorted.begin()
+               )
+            /
+            static_cast<double>( size )
+               ;
+      
+      ::std::cout << "   q = "
+                  << q
+                  << ": estimate "
+                  << estimate
+                  << " (rank "
+                  << rank
+                  << "), exact "
+                  << salaries_sorted
+                        [
+                        static_cast<::std::size_t>( q * static_cast<double>( size - 1u ) )
+                        ]
+                  << ::std::endl
+                     ;
+   }
+   
+   }
+   
+   return 0;
+}
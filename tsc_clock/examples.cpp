@@ -0,0 +1,662 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+
+#include <concepts>
+#include <array>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+
+#include <iostream>
+
+//
+// The IsClock concept of the concepts examples:
+//
+
+template <typename T>
+concept IsClock = requires(T object, double parameter)
+{
+   object.start();
+   object.stop();
+   object.reset();
+   
+   ++object;
+   --object;
+   object += parameter;
+   
+   { object.time_now() } noexcept
+      ->
+         ::std::convertible_to
+            <
+            ::std::string
+            >
+            ;
+   
+   { T::resolution() }
+      ->
+         ::std::same_as
+            <
+            float
+            >
+            ;
+   
+   typename T::ClockResolutionType;
+   
+   requires
+      
+      ::std::default_initializable<T>
+      
+      and
+      
+      ::std::copy_constructible<T>
+         ;
+   
+   requires
+      (
+         sizeof( decltype( T::resolution() ) )
+         
+         <=
+         
+         sizeof( double )
+      )
+      ;
+}
+;
+
+//
+// ::std::chrono::steady_clock::now() costs a call into the
+// vDSO and a conversion to nanoseconds, about 20 ns on
+// common hardware. The time stamp counter of x86 processors
+// (TSC) is read by a single instruction, rdtsc, in a few
+// nanoseconds. On current processors the TSC is "invariant":
+// it ticks at a constant rate whatever the frequency or
+// power state of the core, and it is synchronised between
+// cores.
+//
+// tsc_clock is an IsClock which counts TSC ticks between
+// start() and stop(). The tick rate is calibrated once per
+// process against CLOCK_MONOTONIC. Where there is no
+// invariant TSC (or no x86 processor), it falls back to
+// clock_gettime(CLOCK_MONOTONIC_RAW), in nanoseconds.
+//
+// start() reads the counter after an lfence, so that the
+// read is not executed before earlier instructions; stop()
+// uses rdtscp, which waits for earlier instructions to
+// complete.
+//
+// time_now() returns the elapsed time as a timestamp, a
+// fixed-size character buffer which converts to
+// ::std::string and ::std::string_view, so that reading the
+// clock never allocates. The class is final and has no
+// virtual functions, so that calls are inlined.
+//
+
+enum class tick_source
+{
+   tsc,
+   monotonic_raw
+}
+;
+
+//
+// The elapsed time in seconds, formatted without
+// allocating:
+//
+
+class timestamp final
+{
+public:
+   explicit timestamp(double seconds) noexcept
+   {
+      auto const
+         [ end, error ] =
+            ::std::to_chars
+               (
+               characters_.data(),
+               characters_.data() + characters_.size() - 2u,
+               seconds,
+               ::std::chars_format::fixed,
+               9
+               )
+               ;
+      
+      if( error == ::std::errc { } )
+      {
+         *end = 's';
+         
+         size_ = static_cast<::std::size_t>( end - characters_.data() ) + 1u;
+      }
+   }
+   
+   ::std::string_view
+      view(void) const noexcept
+   {
+      return
+         { characters_.data(), size_ };
+   }
+   
+   operator ::std::string_view () const noexcept
+   {
+      return
+         this->view();
+   }
+   
+   operator ::std::string () const
+   {
+      return
+         ::std::string( this->view() );
+   }
+
+private:
+   ::std::array<char, 40>
+      characters_ { };
+   
+   ::std::size_t
+      size_ = 0u;
+}
+;
+
+class tsc_clock final
+{
+public:
+   typedef
+      float
+      ClockResolutionType
+         ;
+   
+   void
+      start(void) noexcept
+   {
+      start_ = read_start();
+   }
+   
+   void
+      stop(void) noexcept
+   {
+      elapsed_ += read_stop() - start_;
+   }
+   
+   void
+      reset(void) noexcept
+   {
+      elapsed_ = 0u;
+   }
+   
+   //
+   // ++ and -- adjust the elapsed time by one tick, and +=
+   // by a number of seconds:
+   //
+   
+   tsc_clock &
+      operator++ (void) noexcept
+   {
+      ++elapsed_;
+      
+      return
+         *this;
+   }
+   
+   tsc_clock &
+      operator-- (void) noexcept
+   {
+      --elapsed_;
+      
+      return
+         *this;
+   }
+   
+   tsc_clock &
+      operator+= (double seconds) noexcept
+   {
+      //
+      // Through a signed integer, as seconds may be negative:
+      // the tick count wraps, as it does for operator--:
+      //
+      
+      elapsed_ +=
+         static_cast<::std::uint64_t>
+            (
+            static_cast<::std::int64_t>( seconds * calibration().ticks_per_second )
+            )
+            ;
+      
+      return
+         *this;
+   }
+   
+   ::std::uint64_t
+      ticks(void) const noexcept
+   {
+      return
+         elapsed_;
+   }
+   
+   double
+      seconds(void) const noexcept
+   {
+      return
+         static_cast<double>( elapsed_ ) / calibration().ticks_per_second;
+   }
+   
+   timestamp
+      time_now(void) const noexcept
+   {
+      return
+         timestamp( this->seconds() );
+   }
+   
+   //
+   // The duration of one tick, in seconds:
+   //
+   
+   static ClockResolutionType
+      resolution(void)
+   {
+      return
+         static_cast<ClockResolutionType>( 1. / calibration().ticks_per_second );
+   }
+   
+   static tick_source
+      source(void)
+   {
+      return
+         calibration().source;
+   }
+
+private:
+   struct calibration_data final
+   {
+      tick_source
+         source = tick_source::monotonic_raw;
+      
+      double
+         ticks_per_second = 1e9;
+   }
+   ;
+   
+   static ::std::uint64_t
+      monotonic_nanoseconds(clockid_t clock) noexcept
+   {
+      ::timespec
+         time { };
+      
+      ::clock_gettime( clock, &time );
+      
+      return
+         static_cast<::std::uint64_t>( time.tv_sec ) * 1'000'000'000u
+         +
+         static_cast<::std::uint64_t>( time.tv_nsec );
+   }
+   
+   static bool
+      has_invariant_tsc(void) noexcept
+   {
+#if defined(__x86_64__) || defined(__i386__)
+      unsigned
+         eax = 0u,
+         ebx = 0u,
+         ecx = 0u,
+         edx = 0u;
+      
+      //
+      // CPUID leaf 0x80000007, EDX bit 8:
+      //
+      
+      return
+         ::__get_cpuid( 0x80000007u, &eax, &ebx, &ecx, &edx ) != 0
+         
+         and
+         
+         ( edx & ( 1u << 8u ) ) != 0u;
+#else
+      return
+         false;
+#endif
+   }
+   
+   //
+   // Counts TSC ticks over about 20 ms of CLOCK_MONOTONIC.
+   // The function-local static is initialised once, on
+   // first use, in a thread-safe way:
+   //
+   
+   static calibration_data const &
+      calibration(void) noexcept
+   {
+      static calibration_data const
+         data =
+            [] (void)
+            {
+               calibration_data
+                  result;
+
+#if defined(__x86_64__) || defined(__i386__)
+               if( has_invariant_tsc() )
+               {
+                  auto const
+                     start_nanoseconds = monotonic_nanoseconds( CLOCK_MONOTONIC );
+                  
+                  auto const
+                     start_ticks = __rdtsc();
+                  
+                  while( monotonic_nanoseconds( CLOCK_MONOTONIC ) - start_nanoseconds < 20'000'000u )
+                  {
+                  }
+                  
+                  auto const
+                     stop_nanoseconds = monotonic_nanoseconds( CLOCK_MONOTONIC );
+                  
+                  auto const
+                     stop_ticks = __rdtsc();
+                  
+                  result.source = tick_source::tsc;
+                  
+                  result.ticks_per_second =
+                     static_cast<double>( stop_ticks - start_ticks )
+                     * 1e9
+                     / static_cast<double>( stop_nanoseconds - start_nanoseconds )
+                        ;
+               }
+#endif
+               
+               return
+                  result;
+            }
+            ()
+            ;
+      
+      return
+         data;
+   }
+   
+   static ::std::uint64_t
+      read_start(void) noexcept
+   {
+#if defined(__x86_64__) || defined(__i386__)
+      if( calibration().source == tick_source::tsc )
+      {
+         _mm_lfence();
+         
+         return
+            __rdtsc();
+      }
+#endif
+      
+      return
+         monotonic_nanoseconds( CLOCK_MONOTONIC_RAW );
+   }
+   
+   static ::std::uint64_t
+      read_stop(void) noexcept
+   {
+#if defined(__x86_64__) || defined(__i386__)
+      if( calibration().source == tick_source::tsc )
+      {
+         unsigned
+            processor = 0u;
+         
+         return
+            __rdtscp( &processor );
+      }
+#endif
+      
+      return
+         monotonic_nanoseconds( CLOCK_MONOTONIC_RAW );
+   }
+   
+   ::std::uint64_t
+      start_ = 0u,
+      elapsed_ = 0u;
+}
+;
+
+static_assert( IsClock<tsc_clock> );
+
+//
+// For comparison, the same clock over
+// ::std::chrono::steady_clock:
+//
+
+class steady_clock_adapter final
+{
+public:
+   typedef
+      float
+      ClockResolutionType
+         ;
+   
+   void
+      start(void) noexcept
+   {
+      start_ = ::std::chrono::steady_clock::now();
+   }
+   
+   void
+      stop(void) noexcept
+   {
+      elapsed_ += ::std::chrono::steady_clock::now() - start_;
+   }
+   
+   void
+      reset(void) noexcept
+   {
+      elapsed_ = { };
+   }
+   
+   steady_clock_adapter &
+      operator++ (void) noexcept
+   {
+      ++elapsed_;
+      
+      return
+         *this;
+   }
+   
+   steady_clock_adapter &
+      operator-- (void) noexcept
+   {
+      --elapsed_;
+      
+      return
+         *this;
+   }
+   
+   steady_clock_adapter &
+      operator+= (double seconds) noexcept
+   {
+      elapsed_ +=
+         ::std::chrono::duration_cast<::std::chrono::steady_clock::duration>
+            (
+            ::std::chrono::duration<double>( seconds )
+            )
+            ;
+      
+      return
+         *this;
+   }
+   
+   double
+      seconds(void) const noexcept
+   {
+      return
+         ::std::chrono::duration<double>( elapsed_ ).count();
+   }
+   
+   timestamp
+      time_now(void) const noexcept
+   {
+      return
+         timestamp( this->seconds() );
+   }
+   
+   static ClockResolutionType
+      resolution(void)
+   {
+      return
+         static_cast<ClockResolutionType>
+            (
+            ::std::chrono::duration<double>( ::std::chrono::steady_clock::duration( 1 ) ).count()
+            )
+            ;
+   }
+
+private:
+   ::std::chrono::steady_clock::time_point
+      start_ { };
+   
+   ::std::chrono::steady_clock::duration
+      elapsed_ { };
+}
+;
+
+static_assert( IsClock<steady_clock_adapter> );
+
+//
+// The average cost, in nanoseconds, of a start() and stop()
+// pair:
+//
+
+template <IsClock Clock>
+double
+nanoseconds_per_start_stop(::std::size_t iterations)
+{
+   Clock
+      clock;
+   
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   for( ::std::size_t iteration = 0; iteration < iterations; ++iteration )
+   {
+      clock.start();
+      
+      clock.stop();
+   }
+   
+   auto const
+      stop = ::std::chrono::steady_clock::now();
+   
+   return
+      ::std::chrono::duration <double, ::std::nano> ( stop - start ).count()
+      /
+      static_cast<double>( iterations );
+}
+
+int main(int argc, char ** argv)
+{
+   {
+   
+   tsc_clock
+      clock;
+   
+   clock.start();
+   
+   ::std::this_thread::sleep_for( ::std::chrono::milliseconds( 50 ) );
+   
+   clock.stop();
+   
+   ::std::cout << "ticks from "
+               << ( tsc_clock::source() == tick_source::tsc ? "the TSC" : "CLOCK_MONOTONIC_RAW" )
+               << ", resolution "
+               << tsc_clock::resolution()
+               << " s"
+               << ::std::endl
+               << "slept for "
+               << clock.time_now().view()
+               << ::std::endl
+                  ;
+   
+   assert( clock.seconds() >= 0.045 and clock.seconds() < 1. );
+   
+   //
+   // time_now() converts to a ::std::string, as IsClock
+   // requires:
+   //
+   
+   ::std::string const
+      text = clock.time_now();
+   
+   assert( text.back() == 's' );
+   
+   clock += 1.;
+   
+   assert( clock.seconds() >= 1.045 );
+   
+   clock += -1.;
+   
+   assert( clock.seconds() >= 0.04 and clock.seconds() < 1. );
+   
+   clock.reset();
+   
+   assert( clock.ticks() == 0u );
+   
+   }
+   
+   {
+   
+   //
+   // Benchmark the cost of a start() and stop() pair. The
+   // number of pairs can be passed as the first
+   // command-line argument:
+   //
+   
+   ::std::size_t const
+      iterations =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 10'000'000u
+               ;
+   
+   //
+   // Calibrate outside of the measurement:
+   //
+   
+   tsc_clock::resolution();
+   
+   ::std::cout << "nanoseconds per start() and stop():"
+               << ::std::endl
+               << "   tsc_clock:    "
+               << nanoseconds_per_start_stop<tsc_clock>( iterations )
+               << ::std::endl
+               << "   steady_clock: "
+               << nanoseconds_per_start_stop<steady_clock_adapter>( iterations )
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}
@@ -0,0 +1,791 @@
+/*
+ 
+ This file is part of cpp-2x, a collection of c++20
+ examples.
+ Copyright (C) 2023
+ 
+ This program is free software: you can redistribute it and/
+ or modify it under the terms of the GNU General Public
+ License as published by the Free Software Foundation,
+ either version 3 of the License, or (at your option) any
+ later version.
+ 
+ This program is distributed in the hope that it will be
+ useful, but WITHOUT ANY WARRANTY; without even the implied
+ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE. See the GNU General Public License for more
+ details.
+ 
+ You should have received a copy of the GNU General Public
+ License along with this program.  If not, see
+ <https://www.gnu.org/licenses/>.
+ 
+ */
+
+#include <ranges>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+
+#include <iostream>
+
+//
+// The ranges examples build pipelines such as:
+//
+//    items | views::reverse | views::drop(3) | views::reverse
+//
+// which is equivalent to "drop the last three elements".
+// Each views::reverse wraps the iterators of the range it
+// adapts in a ::std::reverse_iterator, and views::drop
+// wraps the whole range in a drop_view, so every increment
+// and dereference goes through several layers of adaptor.
+// The compiler is allowed to remove those layers but does
+// not always do so.
+//
+// Because views are ordinary types, a pipeline can instead
+// be rewritten at compile time. The adaptors in the fused
+// namespace below inspect the type of the range that they
+// are applied to and, where possible, return a simpler
+// view with the same elements:
+//
+//    1.    reverse | reverse cancels (the standard
+//          views::reverse already does this for directly
+//          adjacent reverses);
+//    2.    reverse | drop(n) becomes reverse | drop_last(n),
+//          that is, the drop is pushed underneath the
+//          reverse, so that reverse | drop(n) | reverse
+//          becomes drop_last(n) by rule 1;
+//    3.    take and drop over a sized, random-access,
+//          borrowed range become a ::std::ranges::subrange
+//          of the original iterators, so that adjacent
+//          take/drop adaptors collapse into one subrange;
+//    4.    take(n) over an unbounded iota becomes a bounded
+//          iota, which is sized and random-access.
+//
+// A range is "borrowed" if its iterators remain valid after
+// the range object itself is destroyed (eg. an lvalue
+// container, a ref_view, a subrange or an iota_view). Only
+// borrowed ranges can be rewritten as a subrange, otherwise
+// the subrange could dangle. Any other range falls back to
+// the standard adaptor.
+//
+
+namespace fused
+{
+
+namespace views = ::std::ranges::views;
+
+//
+// Type traits used to pattern-match adaptor types:
+//
+
+template <typename T>
+inline constexpr bool
+   is_reverse_view = false;
+
+template <typename V>
+inline constexpr bool
+   is_reverse_view< ::std::ranges::reverse_view <V> > = true;
+
+template <typename T>
+inline constexpr bool
+   is_unbounded_iota = false;
+
+template <::std::integral W>
+inline constexpr bool
+   is_unbounded_iota
+      <
+      ::std::ranges::iota_view <W, ::std::unreachable_sentinel_t>
+      >
+      = true;
+
+//
+// Ranges which may be rewritten as a subrange of their own
+// iterators:
+//
+
+template <typename R>
+concept
+   Sliceable =
+      ::std::ranges::sized_range<R>
+      
+      and
+      
+      ::std::ranges::random_access_range<R>
+      
+      and
+      
+      ::std::ranges::borrowed_range<R>
+         ;
+
+//
+// A reverse_view of a sliceable view:
+//
+
+template <typename T>
+inline constexpr bool
+   is_reversed_sliceable = false;
+
+template <Sliceable V>
+inline constexpr bool
+   is_reversed_sliceable< ::std::ranges::reverse_view <V> > = true;
+
+//
+// The elements [first + from, first + to) of a sliceable
+// range, with both offsets clamped to the range size:
+//
+
+template <Sliceable R>
+constexpr auto
+slice
+   (
+   R && range,
+   ::std::ranges::range_difference_t<R> from,
+   ::std::ranges::range_difference_t<R> to
+   )
+{
+   auto const
+      first = ::std::ranges::begin( range );
+   
+   auto const
+      size = ::std::ranges::distance( range );
+   
+   return
+      ::std::ranges::subrange
+         (
+         first + ::std::clamp( from, decltype(size) { 0 }, size ),
+         first + ::std::clamp( to, decltype(size) { 0 }, size )
+         )
+         ;
+}
+
+//
+// Every adaptor below is a function object which also
+// provides a pipe operator. The closure types store the
+// adaptor arguments (eg. the count passed to drop):
+//
+
+template <typename Adaptor>
+struct closure
+{
+   Adaptor
+      adaptor_;
+   
+   template <::std::ranges::viewable_range R>
+   friend constexpr auto
+   operator| (R && range, closure const & self)
+   {
+      return
+         self.adaptor_( ::std::forward<R>(range) );
+   }
+}
+;
+
+struct reverse_fn
+{
+   template <::std::ranges::viewable_range R>
+      requires ::std::ranges::bidirectional_range<R>
+   constexpr auto
+   operator() (R && range) const
+   {
+      if constexpr ( is_reverse_view< ::std::remove_cvref_t<R> > )
+      {
+         //
+         // Rule 1: reverse | reverse cancels.
+         //
+         
+         return
+            ::std::forward<R>(range).base();
+      }
+      else
+      {
+         return
+            views::reverse( ::std::forward<R>(range) );
+      }
+   }
+   
+   template <::std::ranges::viewable_range R>
+   friend constexpr auto
+   operator| (R && range, reverse_fn const & self)
+   {
+      return
+         self( ::std::forward<R>(range) );
+   }
+}
+;
+
+inline constexpr reverse_fn
+   reverse;
+
+//
+// drop_last and take_last are the reverse-side equivalents
+// of drop and take. They are not part of C++20 views, so
+// non-sliceable ranges are reversed twice instead:
+//
+
+struct drop_last_fn
+{
+   template <::std::ranges::viewable_range R>
+      requires ::std::ranges::bidirectional_range<R>
+   constexpr auto
+   operator()
+      (
+      R && range,
+      ::std::ranges::range_difference_t<R> count
+      )
+      const
+   {
+      if constexpr ( Sliceable<R> )
+      {
+         return
+            slice
+               (
+               ::std::forward<R>(range),
+               0,
+               ::std::ranges::distance( range ) - count
+               )
+               ;
+      }
+      else
+      {
+         return
+            views::reverse
+               (
+               views::drop
+                  (
+                  views::reverse( ::std::forward<R>(range) ),
+                  count
+                  )
+               )
+               ;
+      }
+   }
+   
+   constexpr auto
+   operator() (::std::ptrdiff_t count) const
+   {
+      return
+         closure
+            {
+            [count] <typename R> (R && range)
+            {
+               return
+                  drop_last_fn { } ( ::std::forward<R>(range), count );
+            }
+            }
+            ;
+   }
+}
+;
+
+inline constexpr drop_last_fn
+   drop_last;
+
+struct take_last_fn
+{
+   template <::std::ranges::viewable_range R>
+      requires ::std::ranges::bidirectional_range<R>
+   constexpr auto
+   operator()
+      (
+      R && range,
+      ::std::ranges::range_difference_t<R> count
+      )
+      const
+   {
+      if constexpr ( Sliceable<R> )
+      {
+         auto const
+            size = ::std::ranges::distance( range );
+         
+         return
+            slice( ::std::forward<R>(range), size - count, size );
+      }
+      else
+      {
+         return
+            views::reverse
+               (
+               views::take
+                  (
+                  views::reverse( ::std::forward<R>(range) ),
+                  count
+                  )
+               )
+               ;
+      }
+   }
+   
+   constexpr auto
+   operator() (::std::ptrdiff_t count) const
+   {
+      return
+         closure
+            {
+            [count] <typename R> (R && range)
+            {
+               return
+                  take_last_fn { } ( ::std::forward<R>(range), count );
+            }
+            }
+            ;
+   }
+}
+;
+
+inline constexpr take_last_fn
+   take_last;
+
+struct drop_fn
+{
+   template <::std::ranges::viewable_range R>
+   constexpr auto
+   operator()
+      (
+      R && range,
+      ::std::ranges::range_difference_t<R> count
+      )
+      const
+   {
+      using
+         Range = ::std::remove_cvref_t<R>;
+      
+      if constexpr ( is_reversed_sliceable<Range> )
+      {
+         //
+         // Rule 2: reverse | drop(n) is drop_last(n) |
+         // reverse:
+         //
+         
+         return
+            reverse( drop_last( ::std::forward<R>(range).base(), count ) );
+      }
+      else if constexpr ( Sliceable<R> )
+      {
+         //
+         // Rule 3:
+         //
+         
+         return
+            slice
+               (
+               ::std::forward<R>(range),
+               count,
+               ::std::ranges::distance( range )
+               )
+               ;
+      }
+      else
+      {
+         return
+            views::drop( ::std::forward<R>(range), count );
+      }
+   }
+   
+   constexpr auto
+   operator() (::std::ptrdiff_t count) const
+   {
+      return
+         closure
+            {
+            [count] <typename R> (R && range)
+            {
+               return
+                  drop_fn { } ( ::std::forward<R>(range), count );
+            }
+            }
+            ;
+   }
+}
+;
+
+inline constexpr drop_fn
+   drop;
+
+struct take_fn
+{
+   template <::std::ranges::viewable_range R>
+   constexpr auto
+   operator()
+      (
+      R && range,
+      ::std::ranges::range_difference_t<R> count
+      )
+      const
+   {
+      using
+         Range = ::std::remove_cvref_t<R>;
+      
+      if constexpr ( is_reversed_sliceable<Range> )
+      {
+         return
+            reverse( take_last( ::std::forward<R>(range).base(), count ) );
+      }
+      else if constexpr ( Sliceable<R> )
+      {
+         return
+            slice( ::std::forward<R>(range), 0, count );
+      }
+      else if constexpr ( is_unbounded_iota<Range> )
+      {
+         //
+         // Rule 4:
+         //
+         
+         auto const
+            first = *::std::ranges::begin( range );
+         
+         return
+            views::iota
+               (
+               first,
+               static_cast< decltype(first) >( first + count )
+               )
+               ;
+      }
+      else
+      {
+         return
+            views::take( ::std::forward<R>(range), count );
+      }
+   }
+   
+   constexpr auto
+   operator() (::std::ptrdiff_t count) const
+   {
+      return
+         closure
+            {
+            [count] <typename R> (R && range)
+            {
+               return
+                  take_fn { } ( ::std::forward<R>(range), count );
+            }
+            }
+            ;
+   }
+}
+;
+
+inline constexpr take_fn
+   take;
+
+}
+
+//
+// Times a function which visits every element of a range
+// once and returns the sum of the elements:
+//
+
+template <typename Function>
+double
+nanoseconds_per_element
+   (
+   Function && function,
+   ::std::size_t elements,
+   unsigned repetitions
+   )
+{
+   long long
+      checksum = 0;
+   
+   auto const
+      start = ::std::chrono::steady_clock::now();
+   
+   for( unsigned repetition = 0; repetition < repetitions; ++repetition )
+   {
+      checksum += function();
+   }
+   
+   auto const
+      stop = ::std::chrono::steady_clock::now();
+   
+   //
+   // Prevents the loop from being optimized away:
+   //
+   
+   if( checksum == 0 and elements != 0 )
+   {
+      ::std::cout << "(empty checksum)" << ::std::endl;
+   }
+   
+   return
+      ::std::chrono::duration <double, ::std::nano> ( stop - start ).count()
+         /
+      ( static_cast<double>( elements ) * repetitions )
+         ;
+}
+
+int main(int argc, char ** argv)
+{
+   namespace views = ::std::ranges::views;
+   
+   {
+   
+   ::std::vector<int>
+      items { 1, 2, 3, 4, 5, 6, 7 };
+   
+   //
+   // The standard pipeline is a reverse_view of a drop_view
+   // of a reverse_view:
+   //
+   
+   auto
+      view =
+         items | views::reverse | views::drop(3) | views::reverse;
+   
+   //
+   // The fused pipeline is a plain subrange of the vector
+   // iterators:
+   //
+   
+   auto
+      fused_view =
+         items | fused::reverse | fused::drop(3) | fused::reverse;
+   
+   static_assert
+      (
+      ::std::same_as
+         <
+         decltype( fused_view ),
+         ::std::ranges::subrange< ::std::vector<int>::iterator >
+         >
+      )
+      ;
+   
+   assert( ::std::ranges::equal( view, fused_view ) );
+   
+   for( int v : fused_view )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   //
+   // Infinite ranges are rewritten too. take(7) turns the
+   // unbounded iota into a bounded one, after which the
+   // reverse / drop / reverse sequence collapses as above:
+   //
+   
+   auto
+      fused_view =
+         views::iota(1)
+            | fused::take(7)
+            | fused::reverse
+            | fused::drop(3)
+            | fused::reverse
+               ;
+   
+   static_assert
+      (
+      ::std::same_as
+         <
+         decltype( fused_view ),
+         ::std::ranges::subrange
+            <
+            ::std::ranges::iterator_t
+               <
+               ::std::ranges::iota_view<int, int>
+               >
+            >
+         >
+      )
+      ;
+   
+   for( int v : fused_view )
+   {
+      ::std::cout << v << " ";
+   }
+   
+   ::std::cout << ::std::endl;
+   
+   }
+   
+   {
+   
+   //
+   // Adjacent takes and drops collapse into one subrange:
+   //
+   
+   ::std::vector<int>
+      items { 1, 2, 3, 4, 5, 6, 7 };
+   
+   auto
+      fused_view =
+         items | fused::drop(1) | fused::take(5) | fused::drop(2);
+   
+   static_assert
+      (
+      ::std::same_as
+         <
+         decltype( fused_view ),
+         ::std::ranges::subrange< ::std::vector<int>::iterator >
+         >
+      )
+      ;
+   
+   assert
+      (
+      ::std::ranges::equal
+         (
+         fused_view,
+         items | views::drop(1) | views::take(5) | views::drop(2)
+         )
+      )
+      ;
+   
+   }
+   
+   {
+   
+   //
+   // Measure the iteration cost of the standard and the
+   // fused pipelines. The number of elements can be passed
+   // as the first command-line argument:
+   //
+   
+   ::std::size_t const
+      size =
+         ( argc > 1 )
+            ? ::std::strtoull( argv[1], nullptr, 10 )
+            : 10'000'000u
+               ;
+   
+   //
+   // Repeat small ranges more often, so that every
+   // measurement visits roughly 10^8 elements:
+   //
+   
+   unsigned const
+      repetitions =
+         static_cast<unsigned>
+            (
+            ::std::max <::std::size_t> ( 1u, 100'000'000u / ( size + 1u ) )
+            )
+            ;
+   
+   ::std::vector<int>
+      items( size );
+   
+   for( ::std::size_t index = 0; index < size; ++index )
+   {
+      items[index] = static_cast<int>( index & 0xff );
+   }
+   
+   auto const
+      sum =
+         [] (auto && range)
+         {
+            long long
+               total = 0;
+            
+            for( int v : range )
+            {
+               total += v;
+            }
+            
+            return
+               total;
+         }
+         ;
+   
+   double const
+      standard =
+         nanoseconds_per_element
+            (
+            [&]
+            {
+               return
+                  sum
+                     (
+                     items
+                        | views::reverse
+                        | views::drop(3)
+                        | views::reverse
+                     )
+                     ;
+            },
+            size,
+            repetitions
+            )
+            ;
+   
+   double const
+      fused =
+         nanoseconds_per_element
+            (
+            [&]
+            {
+               return
+                  sum
+                     (
+                     items
+                        | fused::reverse
+                        | fused::drop(3)
+                        | fused::reverse
+                     )
+                     ;
+            },
+            size,
+            repetitions
+            )
+            ;
+   
+   double const
+      loop =
+         nanoseconds_per_element
+            (
+            [&]
+            {
+               long long
+                  total = 0;
+               
+               for
+                  (
+                  ::std::size_t index = 0;
+                  index + 3 < items.size();
+                  ++index
+                  )
+               {
+                  total += items[index];
+               }
+               
+               return
+                  total;
+            },
+            size,
+            repetitions
+            )
+            ;
+   
+   ::std::cout << "reverse | drop(3) | reverse over "
+               << size
+               << " ints:"
+               << ::std::endl
+               << "   standard views: "
+               << standard
+               << " ns/element"
+               << ::std::endl
+               << "   fused views:    "
+               << fused
+               << " ns/element"
+               << ::std::endl
+               << "   hand-written:   "
+               << loop
+               << " ns/element"
+               << ::std::endl
+                  ;
+   
+   }
+   
+   return 0;
+}